@@ -0,0 +1,34 @@
+# Times Python iteration over a large Document. The untyped loop runs on any version of the bindings, so
+# running this script against two builds compares their Document iterators directly.
+#
+# Usage: python bench_iteration.py [number of ComponentDefinitions, default 1000000]
+
+import sys
+import time
+from sbol import *
+
+
+def timed(label, loop):
+    start = time.time()
+    n = loop()
+    elapsed = time.time() - start
+    print('%-40s %10d objects %8.3f s %12.0f objects/s' % (label, n, elapsed, n / elapsed if elapsed else 0))
+
+
+def main():
+    n_objects = int(sys.argv[1]) if len(sys.argv) > 1 else 1000000
+    setHomespace('http://examples.org')
+    doc = Document()
+    bulk_insert = BulkInsert(doc, n_objects)
+    for i in range(n_objects):
+        doc.componentDefinitions.create('cd%d' % i)
+    bulk_insert.commit()
+
+    timed('for obj in doc', lambda: sum(1 for obj in doc))
+    timed('for cd in doc.componentDefinitions', lambda: sum(1 for cd in doc.componentDefinitions))
+    if hasattr(doc, 'iter'):
+        timed('for cd in doc.iter(ComponentDefinition)', lambda: sum(1 for cd in doc.iter(ComponentDefinition)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,146 @@
+/**
+ * @file    generator.cpp
+ * @brief   Generator for synthetic SBOL Documents used by the benchmark suite
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+#include "generator.h"
+
+#include <random>
+#include <algorithm>
+
+using namespace sbol;
+using namespace std;
+
+namespace sbol_bench
+{
+    void registerExtensions()
+    {
+        // Constructing an instance registers the class with the parser
+        BenchAnnotation registration;
+    };
+
+    GeneratedDocument generateDocument(Document& doc, const GeneratorOptions& options)
+    {
+        GeneratedDocument generated;
+        mt19937 rng(options.seed);
+        const char bases[] = "acgt";
+        const vector<string> roles = { SO_PROMOTER, SO_RBS, SO_CDS, SO_TERMINATOR, SO_MISC };
+
+        // Bulk insertion avoids a Document-wide uniqueness scan on every create, so generation time stays linear
+        BulkInsert bulk_insert(doc, options.parts * 3);
+
+        // Leaf parts, each with a random sequence, feature annotations and custom annotation objects
+        int n_annotations = (int)(options.annotation_density * options.sequence_length / 1000.0);
+        vector<ComponentDefinition*> level;
+        for (int i_part = 0; i_part < options.parts; ++i_part)
+        {
+            string id = "part_" + to_string(i_part);
+            ComponentDefinition& cd = doc.componentDefinitions.create(id);
+            cd.roles.set(roles[i_part % roles.size()]);
+            cd.name.set("Part " + to_string(i_part));
+            cd.description.set("Synthetic part generated for benchmarking");
+
+            Sequence& seq = doc.sequences.create(id + "_seq");
+            string elements(options.sequence_length, 'a');
+            for (auto & base : elements)
+                base = bases[rng() % 4];
+            seq.elements.set(elements);
+            cd.sequences.set(seq.identity.get());
+
+            for (int i_sa = 0; i_sa < n_annotations; ++i_sa)
+            {
+                SequenceAnnotation& sa = cd.sequenceAnnotations.create("feature_" + to_string(i_sa));
+                Range& r = sa.locations.create<Range>("range");
+                int start = 1 + rng() % options.sequence_length;
+                int end = start + rng() % (options.sequence_length - start + 1);
+                r.start.set(start);
+                r.end.set(end);
+                sa.roles.set(roles[i_sa % roles.size()]);
+                generated.annotations.push_back(sa.identity.get());
+            }
+
+            OwnedObject<BenchAnnotation> custom(&cd, BENCH_NS "annotation", '0', '*', ValidationRules({}));
+            for (int i_custom = 0; i_custom < options.custom_annotations; ++i_custom)
+            {
+                BenchAnnotation& annotation = custom.create("note_" + to_string(i_custom));
+                annotation.score.set((int)(rng() % 100));
+                annotation.note.set("Custom annotation " + to_string(i_custom));
+                generated.custom_annotations.push_back(annotation.identity.get());
+            }
+
+            generated.parts.push_back(cd.identity.get());
+            level.push_back(&cd);
+        }
+
+        // Composite designs, each assembled from a run of consecutive designs one level down
+        vector<ComponentDefinition*> first_composites;
+        for (int i_level = 1; i_level <= options.depth && level.size() > 1; ++i_level)
+        {
+            vector<ComponentDefinition*> next_level;
+            size_t fanout = max(2, options.fanout);
+            for (size_t i_start = 0; i_start < level.size(); )
+            {
+                // A lone trailing design joins the previous run, since Sequence::compile requires at least two subcomponents to concatenate
+                size_t i_end = min(level.size(), i_start + fanout);
+                if (level.size() - i_end == 1)
+                    ++i_end;
+
+                string id = "design_" + to_string(i_level) + "_" + to_string(next_level.size());
+                ComponentDefinition& composite = doc.componentDefinitions.create(id);
+                Sequence& seq = doc.sequences.create(id + "_seq");
+                composite.sequences.set(seq.identity.get());
+
+                vector<ComponentDefinition*> subcomponents(level.begin() + i_start, level.begin() + i_end);
+                composite.assemblePrimaryStructure(subcomponents);
+                i_start = i_end;
+
+                generated.composites.push_back(composite.identity.get());
+                next_level.push_back(&composite);
+            }
+            if (i_level == 1)
+                first_composites = next_level;
+            level = next_level;
+        }
+        for (auto & cd : level)
+            generated.roots.push_back(cd->identity.get());
+
+        // Combinatorial derivations that vary the subcomponents of first-level composites over the leaf parts
+        for (int i_derivation = 0; i_derivation < options.derivations && i_derivation < (int)first_composites.size(); ++i_derivation)
+        {
+            ComponentDefinition& template_cd = *first_composites[i_derivation];
+            CombinatorialDerivation& derivation = doc.combinatorialderivations.create("derivation_" + to_string(i_derivation));
+            derivation.masterTemplate.set(template_cd.identity.get());
+            int i_variable = 0;
+            for (auto & c : template_cd.components)
+            {
+                VariableComponent& variable = derivation.variableComponents.create("variable_" + to_string(i_variable++));
+                variable.variable.set(c.identity.get());
+                for (int i_variant = 0; i_variant < options.fanout; ++i_variant)
+                    variable.variants.add(generated.parts[rng() % generated.parts.size()]);
+            }
+            generated.derivations.push_back(derivation.identity.get());
+        }
+        bulk_insert.commit();
+        return generated;
+    };
+}
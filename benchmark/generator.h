@@ -0,0 +1,89 @@
+/**
+ * @file    generator.h
+ * @brief   Generator for synthetic SBOL Documents used by the benchmark suite
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+#ifndef SBOL_BENCH_GENERATOR_INCLUDED
+#define SBOL_BENCH_GENERATOR_INCLUDED
+
+#include "sbol.h"
+
+#include <string>
+#include <vector>
+
+#define BENCH_NS "http://sbolstandard.org/bench#"
+
+namespace sbol_bench
+{
+    /// A custom annotation object nested inside ComponentDefinitions, registered as an extension class so the parser recognizes its type.
+    /// ComponentDefinition has no property that owns it, so a Document read back from a synthetic file holds each annotation as a
+    /// separate generic TopLevel rather than nested in its ComponentDefinition, and a copy of that Document leaves them out
+    class BenchAnnotation : public sbol::Identified
+    {
+    public:
+        BenchAnnotation(std::string uri = "example", std::string version = "1.0.0") :
+            sbol::Identified(BENCH_NS "Annotation", uri, version),
+            score(this, BENCH_NS "score", '0', '1', ValidationRules({})),
+            note(this, BENCH_NS "note", '0', '1', ValidationRules({}))
+        {
+            register_extension_class<BenchAnnotation>(BENCH_NS, "bench", "Annotation");
+        };
+        sbol::IntProperty score;
+        sbol::TextProperty note;
+    };
+
+    /// Parameters controlling the size and shape of a synthetic Document
+    struct GeneratorOptions
+    {
+        int parts = 1000;                   ///< Number of leaf ComponentDefinitions, each with its own Sequence
+        int depth = 2;                      ///< Number of levels of composite ComponentDefinitions above the leaf parts
+        int fanout = 4;                     ///< Number of subcomponents assembled into each composite
+        int sequence_length = 1000;         ///< Length in bases of each leaf Sequence
+        double annotation_density = 5.0;    ///< SequenceAnnotations per kilobase of leaf sequence
+        int custom_annotations = 1;         ///< Custom annotation objects nested in each leaf ComponentDefinition
+        int derivations = 10;               ///< Number of CombinatorialDerivations over the first level of composites
+        unsigned seed = 1;                  ///< Seed for the pseudo-random generator, so runs are reproducible
+    };
+
+    /// The URIs of the generated objects, used to drive lookups in the benchmarks
+    struct GeneratedDocument
+    {
+        std::vector<std::string> parts;
+        std::vector<std::string> composites;
+        std::vector<std::string> roots;
+        std::vector<std::string> derivations;
+        std::vector<std::string> annotations;
+        std::vector<std::string> custom_annotations;
+    };
+
+    /// Populate an empty Document with parts, composite designs, annotations and combinatorial derivations
+    /// @param doc The Document to fill
+    /// @param options The size and shape of the Document
+    /// @return The URIs of the generated objects
+    GeneratedDocument generateDocument(sbol::Document& doc, const GeneratorOptions& options);
+
+    /// Register the extension classes used by the generator. Must be called once before reading a synthetic Document
+    void registerExtensions();
+}
+
+#endif
@@ -0,0 +1,400 @@
+/**
+ * @file    sbol_bench.cpp
+ * @brief   Benchmark suite reporting throughput and peak memory of core libSBOL operations
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+// Usage: sbol_bench [options]
+//   --parts N                 Leaf ComponentDefinitions (default 1000)
+//   --depth N                 Levels of composite designs (default 2)
+//   --fanout N                Subcomponents per composite (default 4)
+//   --sequence-length N       Bases per leaf Sequence (default 1000)
+//   --annotation-density F    SequenceAnnotations per kilobase (default 5)
+//   --custom-annotations N    Custom annotation objects per part (default 1)
+//   --derivations N           CombinatorialDerivations (default 10)
+//   --lookups N               Lookups per find and get benchmark (default 10000)
+//   --touched N               TopLevels modified before each write_incremental (default 10)
+//   --repeat N                Repetitions of each benchmark; the fastest is reported (default 3)
+//   --seed N                  Random seed (default 1)
+//   --only NAME[,NAME...]     Run only the named benchmarks
+//   --online                  Include the validate benchmark, which calls the online validator
+//   --format json|csv         Output format (default json, one record per line)
+//   --label TEXT              Free-form label copied into every record, eg, a commit hash
+//
+// Each record reports the benchmark name, the number of items processed per repetition, the fastest
+// wall time in seconds, items per second, bytes processed where applicable, and the peak resident
+// set size of the process in kilobytes after the benchmark.
+
+#include "generator.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <random>
+#include <cstdlib>
+#include <cstdio>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+using namespace sbol;
+using namespace sbol_bench;
+using namespace std;
+
+struct BenchOptions
+{
+    GeneratorOptions generator;
+    int lookups = 10000;
+    int touched = 10;
+    int repeat = 3;
+    bool online = false;
+    string format = "json";
+    string label = "";
+    vector<string> only;
+};
+
+struct BenchResult
+{
+    string name;
+    long long items = 0;
+    long long bytes = 0;
+    double seconds = 0;
+    long peak_rss_kb = 0;
+};
+
+long peakRSS()
+{
+#if defined(_WIN32)
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024;  // Reported in bytes on OSX
+#else
+    return usage.ru_maxrss;         // Reported in kilobytes on Linux
+#endif
+#endif
+}
+
+string escapeJSON(const string& text)
+{
+    string escaped;
+    for (auto c : text)
+    {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+void printHeader(const BenchOptions& options)
+{
+    if (options.format == "csv")
+        cout << "label,benchmark,items,seconds,items_per_second,bytes,bytes_per_second,peak_rss_kb" << endl;
+}
+
+void printResult(const BenchOptions& options, const BenchResult& result)
+{
+    double items_per_second = result.seconds > 0 ? result.items / result.seconds : 0;
+    double bytes_per_second = result.seconds > 0 ? result.bytes / result.seconds : 0;
+    if (options.format == "csv")
+    {
+        cout << options.label << "," << result.name << "," << result.items << "," << result.seconds << "," << items_per_second << "," << result.bytes << "," << bytes_per_second << "," << result.peak_rss_kb << endl;
+    }
+    else
+    {
+        cout << "{\"label\":\"" << escapeJSON(options.label) << "\",\"benchmark\":\"" << result.name << "\",\"items\":" << result.items << ",\"seconds\":" << result.seconds << ",\"items_per_second\":" << items_per_second << ",\"bytes\":" << result.bytes << ",\"bytes_per_second\":" << bytes_per_second << ",\"peak_rss_kb\":" << result.peak_rss_kb;
+        cout << ",\"parts\":" << options.generator.parts << ",\"depth\":" << options.generator.depth << ",\"fanout\":" << options.generator.fanout << ",\"sequence_length\":" << options.generator.sequence_length << ",\"annotation_density\":" << options.generator.annotation_density << ",\"custom_annotations\":" << options.generator.custom_annotations << "}" << endl;
+    }
+}
+
+bool selected(const BenchOptions& options, const string& name)
+{
+    return options.only.empty() || find(options.only.begin(), options.only.end(), name) != options.only.end();
+}
+
+// Run a benchmark several times and keep the fastest repetition. The setup function runs before each repetition and is not timed
+void run(const BenchOptions& options, const string& name, function<void()> setup, function<void(BenchResult&)> body)
+{
+    if (!selected(options, name))
+        return;
+    BenchResult best;
+    best.name = name;
+    for (int i_repeat = 0; i_repeat < options.repeat; ++i_repeat)
+    {
+        BenchResult result;
+        result.name = name;
+        if (setup)
+            setup();
+        auto start = chrono::steady_clock::now();
+        body(result);
+        result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (i_repeat == 0 || result.seconds < best.seconds)
+            best = result;
+    }
+    best.peak_rss_kb = peakRSS();
+    printResult(options, best);
+}
+
+vector<string> sample(const vector<string>& uris, int n, unsigned seed)
+{
+    vector<string> lookups;
+    if (uris.empty())
+        return lookups;
+    mt19937 rng(seed);
+    for (int i = 0; i < n; ++i)
+        lookups.push_back(uris[rng() % uris.size()]);
+    return lookups;
+}
+
+void usage()
+{
+    cerr << "Usage: sbol_bench [--parts N] [--depth N] [--fanout N] [--sequence-length N] [--annotation-density F] [--custom-annotations N] [--derivations N] [--lookups N] [--touched N] [--repeat N] [--seed N] [--only NAME,...] [--online] [--format json|csv] [--label TEXT]" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    BenchOptions options;
+    for (int i_arg = 1; i_arg < argc; ++i_arg)
+    {
+        string arg = argv[i_arg];
+        string value = (i_arg + 1 < argc) ? argv[i_arg + 1] : "";
+        if (arg == "--online")
+        {
+            options.online = true;
+            continue;
+        }
+        if (arg == "--help" || arg == "-h" || value == "")
+        {
+            usage();
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+        ++i_arg;
+        if (arg == "--parts") options.generator.parts = atoi(value.c_str());
+        else if (arg == "--depth") options.generator.depth = atoi(value.c_str());
+        else if (arg == "--fanout") options.generator.fanout = max(2, atoi(value.c_str()));
+        else if (arg == "--sequence-length") options.generator.sequence_length = max(1, atoi(value.c_str()));
+        else if (arg == "--annotation-density") options.generator.annotation_density = atof(value.c_str());
+        else if (arg == "--custom-annotations") options.generator.custom_annotations = atoi(value.c_str());
+        else if (arg == "--derivations") options.generator.derivations = atoi(value.c_str());
+        else if (arg == "--seed") options.generator.seed = (unsigned)atoi(value.c_str());
+        else if (arg == "--lookups") options.lookups = atoi(value.c_str());
+        else if (arg == "--touched") options.touched = max(0, atoi(value.c_str()));
+        else if (arg == "--repeat") options.repeat = max(1, atoi(value.c_str()));
+        else if (arg == "--format") options.format = value;
+        else if (arg == "--label") options.label = value;
+        else if (arg == "--only")
+        {
+            stringstream names(value);
+            string name;
+            while (getline(names, name, ','))
+                options.only.push_back(name);
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    setHomespace("http://sbolstandard.org/bench");
+    Config::setOption("sbol_compliant_uris", true);
+    Config::setOption("sbol_typed_uris", false);
+    Config::setOption("validate", false);
+
+    printHeader(options);
+
+    // The reference Document used by all benchmarks that do not modify it
+    Document doc;
+    registerExtensions();
+    GeneratedDocument generated = generateDocument(doc, options.generator);
+    string serialized = doc.writeString();
+    long long n_toplevels = doc.size();
+
+    Document* scratch = NULL;
+    auto clear_scratch = [&]()
+    {
+        if (scratch)
+            delete scratch;
+        scratch = new Document();
+    };
+
+    run(options, "generate", clear_scratch, [&](BenchResult& result)
+    {
+        GeneratedDocument g = generateDocument(*scratch, options.generator);
+        result.items = scratch->size();
+    });
+
+    // The reference Document caches the serialization of each object, so the write benchmarks serialize a Document that was
+    // read before each repetition and has never been written
+    auto read_scratch = [&]()
+    {
+        string file_format = getFileFormat();
+        setFileFormat("rdfxml");
+        clear_scratch();
+        scratch->readString(serialized);
+        setFileFormat(file_format);
+    };
+
+    run(options, "write", read_scratch, [&](BenchResult& result)
+    {
+        string output = scratch->writeString();
+        result.items = n_toplevels;
+        result.bytes = output.size();
+    });
+
+    for (string format : { "ntriples", "turtle" })
+    {
+        setFileFormat(format);
+        run(options, "write_" + format, read_scratch, [&](BenchResult& result)
+        {
+            string output = scratch->writeString();
+            result.items = n_toplevels;
+            result.bytes = output.size();
+        });
+    }
+    setFileFormat("rdfxml");
+
+    // Write a Document again after editing a few of its TopLevels, so that only their serializations are out of date
+    vector<string> touched_uris = sample(generated.parts, options.touched, options.generator.seed + 2);
+    int n_touched = 0;
+    run(options, "write_incremental", [&]()
+    {
+        read_scratch();
+        scratch->writeString();
+        for (auto & uri : touched_uris)
+            scratch->get<ComponentDefinition>(uri).description.set("Touched " + to_string(++n_touched));
+    },
+    [&](BenchResult& result)
+    {
+        string output = scratch->writeString();
+        result.items = touched_uris.size();
+        result.bytes = output.size();
+    });
+
+    run(options, "read", clear_scratch, [&](BenchResult& result)
+    {
+        scratch->readString(serialized);
+        result.items = scratch->size();
+        result.bytes = serialized.size();
+    });
+
+    string snapshot_file = "sbol_bench.snapshot";
+    run(options, "snapshot_save", NULL, [&](BenchResult& result)
+    {
+        doc.saveSnapshot(snapshot_file);
+        result.items = n_toplevels;
+    });
+
+    run(options, "snapshot_load", clear_scratch, [&](BenchResult& result)
+    {
+        scratch->loadSnapshot(snapshot_file);
+        result.items = scratch->size();
+    });
+    if (selected(options, "snapshot_load") && scratch->writeString() != serialized)
+        throw SBOLError(SBOL_ERROR_SERIALIZATION, "Benchmark snapshot did not round-trip to identical output");
+    remove(snapshot_file.c_str());
+
+    vector<string> find_uris = generated.annotations.size() ? sample(generated.annotations, options.lookups, options.generator.seed) : sample(generated.parts, options.lookups, options.generator.seed);
+    run(options, "find", NULL, [&](BenchResult& result)
+    {
+        for (auto & uri : find_uris)
+            if (!doc.find(uri))
+                throw SBOLError(NOT_FOUND_ERROR, "Benchmark lookup failed for " + uri);
+        result.items = find_uris.size();
+    });
+
+    vector<string> get_uris = sample(generated.parts, options.lookups, options.generator.seed + 1);
+    run(options, "get", NULL, [&](BenchResult& result)
+    {
+        for (auto & uri : get_uris)
+            doc.get<ComponentDefinition>(uri);
+        result.items = get_uris.size();
+    });
+
+    Document* copy = NULL;
+    run(options, "copy", [&]() { if (copy) delete copy; copy = new Document(); }, [&](BenchResult& result)
+    {
+        doc.copy("", copy);
+        result.items = copy->size();
+    });
+    if (copy)
+        delete copy;
+
+    run(options, "compile", NULL, [&](BenchResult& result)
+    {
+        long long bases = 0;
+        for (auto & uri : generated.roots)
+        {
+            ComponentDefinition& root = doc.get<ComponentDefinition>(uri);
+            bases += doc.get<Sequence>(root.sequences.get()).compile().size();
+        }
+        result.items = generated.roots.size();
+        result.bytes = bases;
+    });
+
+    run(options, "combinatorial", NULL, [&](BenchResult& result)
+    {
+        // Resolve the template and every variant of each derivation, and count the size of the combinatorial library
+        long long library_size = 0;
+        for (auto & uri : generated.derivations)
+        {
+            CombinatorialDerivation& derivation = doc.get<CombinatorialDerivation>(uri);
+            ComponentDefinition& template_cd = doc.get<ComponentDefinition>(derivation.masterTemplate.get());
+            long long combinations = 1;
+            for (auto & variable : derivation.variableComponents)
+            {
+                template_cd.components[variable.variable.get()];
+                vector<string> variants = variable.variants.getAll();
+                for (auto & variant_uri : variants)
+                    doc.get<ComponentDefinition>(variant_uri);
+                combinations *= variants.size();
+            }
+            library_size += combinations;
+        }
+        result.items = generated.derivations.size();
+        result.bytes = library_size;
+    });
+
+    if (options.online)
+    {
+        Config::setOption("validate", true);
+        run(options, "validate", NULL, [&](BenchResult& result)
+        {
+            doc.validate();
+            result.items = n_toplevels;
+            result.bytes = serialized.size();
+        });
+        Config::setOption("validate", false);
+    }
+
+    if (scratch)
+        delete scratch;
+    return 0;
+}
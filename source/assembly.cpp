@@ -29,6 +29,12 @@
 #include <algorithm>
 #include <unordered_map>
 #include <queue>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
 
 using namespace std;
 using namespace sbol;
@@ -484,7 +490,7 @@ string Sequence::assemble(string composite_sequence)
             Range& r = *ranges[0];
             r.start.set((int)composite_sequence.size() + 1);
                                 
-            composite_sequence = composite_sequence + seq.assemble(composite_sequence);  // Recursive call
+            composite_sequence = composite_sequence + seq.assemble();  // Recursive call. Subcomponent Ranges are relative to their own Sequence
                                 
             r.end.set((int)composite_sequence.size());
         }
@@ -993,50 +999,227 @@ int FunctionalComponent::isMasked()
     return 0;
 };
 
-vector<ComponentDefinition*> ComponentDefinition::applyToComponentHierarchy(void (*callback_fn)(ComponentDefinition *, void *), void* user_data)
+void sbol::parallel_for(size_t n, int threads, std::function < void(size_t) > fn)
+{
+    if (threads <= 0)
+        threads = max(1u, thread::hardware_concurrency());
+    threads = (int)min((size_t)threads, n);
+    if (threads <= 1)
+    {
+        for (size_t i = 0; i < n; ++i)
+            fn(i);
+        return;
+    }
+    vector < exception_ptr > errors(threads);
+    atomic < size_t > i_next(0);
+    atomic < bool > failed(false);
+    auto work = [&](int i_thread)
+    {
+        try
+        {
+            for (size_t i = i_next++; i < n && !failed; i = i_next++)
+                fn(i);
+        }
+        catch (...)
+        {
+            errors[i_thread] = current_exception();
+            failed = true;
+        }
+    };
+    vector < thread > workers;
+    for (int i_thread = 1; i_thread < threads; ++i_thread)
+        workers.push_back(thread(work, i_thread));
+    work(0);
+    for (auto & worker : workers)
+        worker.join();
+    for (auto & error : errors)
+        if (error)
+            rethrow_exception(error);
+};
+
+void sbol::parallel_for_ready(const vector < vector < size_t > > & children, int threads, std::function < void(size_t) > fn)
+{
+    // Each node waits on a count of unfinished children, and is queued as soon as the count reaches zero, so a worker
+    // never idles while any node anywhere in the graph is ready
+    size_t n = children.size();
+    vector < size_t > pending(n);
+    vector < vector < size_t > > parents(n);
+    deque < size_t > ready;
+    for (size_t i_node = 0; i_node < n; ++i_node)
+    {
+        pending[i_node] = children[i_node].size();
+        for (auto i_child : children[i_node])
+            parents[i_child].push_back(i_node);
+        if (!pending[i_node])
+            ready.push_back(i_node);
+    }
+    if (threads <= 0)
+        threads = max(1u, thread::hardware_concurrency());
+    threads = (int)min((size_t)threads, n);
+    mutex lock;
+    condition_variable wake;
+    size_t n_done = 0;
+    exception_ptr error;
+    auto work = [&]()
+    {
+        unique_lock < mutex > guard(lock);
+        while (true)
+        {
+            wake.wait(guard, [&]() { return ready.size() || n_done == n || error; });
+            if (n_done == n || error)
+                return;
+            size_t i_node = ready.front();
+            ready.pop_front();
+            guard.unlock();
+            try
+            {
+                fn(i_node);
+            }
+            catch (...)
+            {
+                guard.lock();
+                if (!error)
+                    error = current_exception();
+                wake.notify_all();
+                return;
+            }
+            guard.lock();
+            ++n_done;
+            size_t n_ready = 0;
+            for (auto i_parent : parents[i_node])
+                if (!--pending[i_parent])
+                {
+                    ready.push_back(i_parent);
+                    ++n_ready;
+                }
+            if (n_done == n || n_ready > 1)
+                wake.notify_all();
+            else if (n_ready)
+                wake.notify_one();
+        }
+    };
+    vector < thread > workers;
+    for (int i_thread = 1; i_thread < threads; ++i_thread)
+        workers.push_back(thread(work));
+    work();
+    for (auto & worker : workers)
+        worker.join();
+    if (error)
+        rethrow_exception(error);
+};
+
+ComponentHierarchy ComponentDefinition::indexComponentHierarchy()
 {
-    /* Assumes parent_component is an SBOL data structure of the general form ComponentDefinition(->Component->ComponentDefinition)n where n+1 is an integer describing how many hierarchical levels are in the SBOL structure */
-    /* Look at each of the ComponentDef's SequenceAnnotations, is the target base there? */
     if (!doc)
         throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot traverse Component hierarchy without a Document");
 
-    bool GET_ALL = true;
-    vector<ComponentDefinition*> component_nodes;
-    if (components.size() == 0)
+    // Definitions are looked up directly in the Document's registry of TopLevels
+    auto resolve = [&](ComponentDefinition& cd)
     {
-//        cout << "Adding subcomponent : " << identity.get() << endl;
-        component_nodes.push_back(this);  // Add leaf components
-        if (callback_fn)
-            callback_fn(this, user_data);
-    }
-    else
-    {
-        if (GET_ALL)
+        vector < ComponentDefinition* > definitions;
+        definitions.reserve(cd.components.size());
+        for (auto & subc : cd.components)
         {
-//            cout << "Adding subcomponent : " << identity.get() << endl;
-            component_nodes.push_back(this);  // Add components with children
-            if (callback_fn)
-                callback_fn(this, user_data);
+            string uri = subc.definition.get();
+            auto i_obj = doc->SBOLObjects.find(uri);
+            if (i_obj == doc->SBOLObjects.end())
+                throw SBOLError(SBOL_ERROR_NOT_FOUND, uri + " not found");
+            ComponentDefinition* subcdef = dynamic_cast<ComponentDefinition*>(i_obj->second);
+            if (!subcdef)
+                throw SBOLError(SBOL_ERROR_NOT_FOUND, "ComponentDefinition " + uri + " not found");
+            definitions.push_back(subcdef);
         }
-        for (auto& subc : components)
+        return definitions;
+    };
+
+    // Iterative depth-first search, so deep hierarchies cannot overflow the stack. A definition that is reached again
+    // while it is still on the search path closes a cycle
+    enum { ON_PATH, DONE };
+    ComponentHierarchy hierarchy;
+    unordered_map < ComponentDefinition*, size_t > node_ids;
+    vector < vector < ComponentDefinition* > > definitions;
+    vector < int > states;
+    vector < pair < size_t, size_t > > path;  // Pairs of node and index of the next Component to descend into
+    auto push = [&](ComponentDefinition* cd)
+    {
+        size_t i_node = hierarchy.nodes.size();
+        node_ids[cd] = i_node;
+        hierarchy.nodes.push_back(cd);
+        hierarchy.children.emplace_back();
+        definitions.push_back(resolve(*cd));
+        states.push_back(ON_PATH);
+        path.push_back({ i_node, 0 });
+        return i_node;
+    };
+    push(this);
+    while (path.size())
+    {
+        size_t i_node = path.back().first;
+        size_t& i_component = path.back().second;
+        if (i_component < definitions[i_node].size())
         {
-            if (!doc->find(subc.definition.get()))
+            ComponentDefinition* subcdef = definitions[i_node][i_component++];
+            auto i_id = node_ids.find(subcdef);
+            if (i_id == node_ids.end())
             {
-//                std::cout << "Not found" << std::endl;
-                throw SBOLError(SBOL_ERROR_NOT_FOUND, subc.definition.get() + "not found");
+                size_t i_child = push(subcdef);
+                hierarchy.children[i_node].push_back(i_child);
+                continue;
             }
-            ComponentDefinition& subcdef = doc->get<ComponentDefinition>(subc.definition.get());
-//            std::cout << subcdef.identity.get() << std::endl;
-//            cout << "Descending one level : " << subcdef.identity.get() << endl;
-            vector < sbol::ComponentDefinition* > subcomponents = subcdef.applyToComponentHierarchy(callback_fn, user_data);
-//            cout << "Found " << subcomponents.size() << " components" << std::endl;
-            component_nodes.reserve(component_nodes.size() + distance(subcomponents.begin(), subcomponents.end()));
-            component_nodes.insert(component_nodes.end(), subcomponents.begin(),subcomponents.end());
+            size_t i_child = i_id->second;
+            if (states[i_child] == ON_PATH)
+            {
+                string cycle;
+                for (auto & step : path)
+                    if (!cycle.empty() || step.first == i_child)
+                        cycle += hierarchy.nodes[step.first]->identity.get() + " -> ";
+                throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot traverse Component hierarchy because it contains a cycle: " + cycle + subcdef->identity.get());
+            }
+            hierarchy.children[i_node].push_back(i_child);
+        }
+        else
+        {
+            states[i_node] = DONE;
+            path.pop_back();
         }
     }
+    return hierarchy;
+};
+
+vector<ComponentDefinition*> ComponentDefinition::traverseComponentHierarchy(void (*callback_fn)(ComponentDefinition *, void *), void* user_data, bool per_use, int threads)
+{
+    ComponentHierarchy hierarchy = indexComponentHierarchy();
+    vector < ComponentDefinition* > component_nodes;
+    if (per_use)
+    {
+        // Expand shared definitions once per use, in the same pre-order as a recursive descent
+        vector < size_t > stack = { 0 };
+        while (stack.size())
+        {
+            size_t i_node = stack.back();
+            stack.pop_back();
+            component_nodes.push_back(hierarchy.nodes[i_node]);
+            auto & children = hierarchy.children[i_node];
+            stack.insert(stack.end(), children.rbegin(), children.rend());
+        }
+    }
+    else
+        component_nodes = hierarchy.nodes;
+
+    if (callback_fn)
+        parallel_for(component_nodes.size(), threads, [&](size_t i)
+        {
+            callback_fn(component_nodes[i], user_data);
+        });
     return component_nodes;
 };
 
+vector<ComponentDefinition*> ComponentDefinition::applyToComponentHierarchy(void (*callback_fn)(ComponentDefinition *, void *), void* user_data)
+{
+    /* Assumes parent_component is an SBOL data structure of the general form ComponentDefinition(->Component->ComponentDefinition)n where n+1 is an integer describing how many hierarchical levels are in the SBOL structure */
+    return traverseComponentHierarchy(callback_fn, user_data, true, 1);
+};
+
 bool SequenceAnnotation::precedes(SequenceAnnotation& comparand)
 {
     if (locations.size() > 0 && comparand.locations.size() > 0)
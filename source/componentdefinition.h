@@ -31,6 +31,8 @@
 #include "sequenceannotation.h"
 #include "sequenceconstraint.h"
 #include <string>
+#include <functional>
+#include <deque>
 
 namespace sbol 
 {
@@ -39,6 +41,22 @@ namespace sbol
     // Forward declaration of Sequence necessary for ComponentDefinition.sequence property
     class Sequence;
     class Participation;
+    class ComponentDefinition;
+
+    /// @cond
+    // The distinct ComponentDefinitions of a Component hierarchy, as indexed by ComponentDefinition::indexComponentHierarchy
+    struct SBOL_DECLSPEC ComponentHierarchy
+    {
+        std::vector < ComponentDefinition* > nodes;  // In depth-first pre-order of first use, so nodes[0] is the root
+        std::vector < std::vector < size_t > > children;  // For each node, the nodes its Components are defined by, in the order the Components are stored
+    };
+
+    // Call fn(i) for every i in [0, n) on up to the given number of threads, or one per hardware thread if threads <= 0. The first exception thrown is rethrown once all threads have joined
+    SBOL_DECLSPEC void parallel_for(size_t n, int threads, std::function < void(size_t) > fn);
+
+    // Call fn(i) for every node of an acyclic graph on up to the given number of threads, each node only after fn has returned for all of its children. The workers are started once for the whole graph. The first exception thrown stops the walk and is rethrown once all threads have joined
+    SBOL_DECLSPEC void parallel_for_ready(const std::vector < std::vector < size_t > > & children, int threads, std::function < void(size_t) > fn);
+    /// @endcond
     
     /// The ComponentDefinition class represents the structural entities of a biological design. The primary usage of this class is to represent structural entities with designed sequences, such as DNA, RNA, and proteins, but it can also be used to represent any other entity that is part of a design, such as small molecules, proteins, and complexes
     /// @ingroup sbol_core_data_model
@@ -172,6 +190,28 @@ namespace sbol
         /// @return Returns a flat list of pointers to all Components in the hierarchy.
         std::vector<ComponentDefinition*> applyToComponentHierarchy(void (*callback_fn)(ComponentDefinition *, void *) = NULL, void * user_data = NULL);
 
+        /// Visit the ComponentDefinitions in a hierarchy of Components. Definitions are resolved in constant time, cyclic designs are rejected rather than recursed into, and the callback may run in parallel.
+        /// @param callback_fn A pointer to a callback function with signature void callback_fn(ComponentDefinition *, void *). If threads is not 1, the callback must be thread-safe
+        /// @param user_data Arbitrary user data which is passed to the callback
+        /// @param per_use If true, a ComponentDefinition used by several Components is visited once per use, as by applyToComponentHierarchy. Otherwise each ComponentDefinition is visited once
+        /// @param threads The number of threads to run the callback on, or 0 to use one thread per core
+        /// @return The visited ComponentDefinitions in depth-first pre-order
+        /// @throws SBOLError with SBOL_ERROR_NOT_FOUND if a ComponentDefinition is missing from the Document, or SBOL_ERROR_INVALID_ARGUMENT if the hierarchy contains a cycle
+        std::vector<ComponentDefinition*> traverseComponentHierarchy(void (*callback_fn)(ComponentDefinition *, void *) = NULL, void * user_data = NULL, bool per_use = false, int threads = 1);
+
+        /// Compute a value for this ComponentDefinition, such as its length, GC content or part count, from the values of its subcomponents. Each distinct ComponentDefinition in the hierarchy is reduced exactly once, however many times it is used, and independent subtrees may be reduced in parallel.
+        /// @param reduce_fn A function with signature ValueType reduce_fn(ComponentDefinition &, std::vector<ValueType> &, void *), which receives the values of the definitions of each Component, in the order the Components are stored. If threads is not 1, it must be thread-safe
+        /// @param user_data Arbitrary user data which is passed to the reduce function
+        /// @param threads The number of threads to reduce on, or 0 to use one thread per core
+        /// @return The value for this ComponentDefinition
+        /// @throws SBOLError with SBOL_ERROR_NOT_FOUND if a ComponentDefinition is missing from the Document, or SBOL_ERROR_INVALID_ARGUMENT if the hierarchy contains a cycle
+        template < class ValueType >
+        ValueType reduceComponentHierarchy(ValueType (*reduce_fn)(ComponentDefinition &, std::vector < ValueType > &, void *), void * user_data = NULL, int threads = 1);
+
+        /// @cond
+        ComponentHierarchy indexComponentHierarchy();
+        /// @endcond
+
         /// Get the primary sequence of a design in terms of its sequentially ordered Components
         std::vector<ComponentDefinition*> getPrimaryStructure();
 
@@ -230,6 +270,23 @@ namespace sbol
         virtual ~ComponentDefinition() {  };
         
 	};
+
+    template < class ValueType >
+    ValueType ComponentDefinition::reduceComponentHierarchy(ValueType (*reduce_fn)(ComponentDefinition &, std::vector < ValueType > &, void *), void * user_data, int threads)
+    {
+        ComponentHierarchy hierarchy = indexComponentHierarchy();
+        std::deque < ValueType > values(hierarchy.nodes.size());  // Unlike std::vector<bool>, elements can be written from different threads
+        parallel_for_ready(hierarchy.children, threads, [&](size_t i_node)
+        {
+            std::vector < ValueType > child_values;
+            child_values.reserve(hierarchy.children[i_node].size());
+            for (auto i_child : hierarchy.children[i_node])
+                child_values.push_back(values[i_child]);
+            ValueType value = reduce_fn(*hierarchy.nodes[i_node], child_values, user_data);
+            values[i_node] = value;
+        });
+        return values.front();
+    };
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,474 @@
+/**
+ * @file    compression.cpp
+ * @brief   Reading and writing gzip- and zstd-compressed SBOL files without temporary files
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+#include "document.h"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#ifdef SBOL_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef SBOL_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace sbol;
+using namespace std;
+
+namespace
+{
+    const size_t INPUT_BUFFER_SIZE = 1 << 16;
+
+    // zlib counts bytes in 32-bit integers, so longer texts are passed to it in pieces of this size
+    const size_t ZLIB_CHUNK_SIZE = (size_t)1 << 30;
+
+    // Output is compressed on several threads only if it spans more than one block of this size
+    const size_t COMPRESSION_BLOCK_SIZE = 1 << 20;
+
+    bool has_suffix(const string& filename, const string& suffix)
+    {
+        return filename.size() > suffix.size() && filename.compare(filename.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+
+    string compression_name(Compression compression)
+    {
+        return compression == Compression::GZIP ? "gzip" : "zstd";
+    };
+
+    void unsupported(Compression compression)
+    {
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "libSBOL was built without " + compression_name(compression) + " support");
+    };
+
+    // The compression_level option, or the default level of the format if it is not set
+    int compression_level(Compression compression)
+    {
+        string option = Config::getOption("compression_level");
+        int min_level = compression == Compression::GZIP ? 0 : 1;
+        int max_level = compression == Compression::GZIP ? 9 : 22;
+        if (option == "")
+            return compression == Compression::GZIP ? 6 : 3;
+        size_t end = 0;
+        int level = -1;
+        try
+        {
+            level = stoi(option, &end);
+        }
+        catch (...)
+        {
+        }
+        if (end != option.size() || level < min_level || level > max_level)
+            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Invalid compression_level " + option + ". The " + compression_name(compression) + " level must be between " + to_string(min_level) + " and " + to_string(max_level));
+        return level;
+    };
+
+    // The compression_threads option. 0 uses one thread per hardware thread
+    int compression_threads()
+    {
+        string option = Config::getOption("compression_threads");
+        size_t end = 0;
+        int threads = -1;
+        try
+        {
+            threads = stoi(option, &end);
+        }
+        catch (...)
+        {
+        }
+        if (end != option.size() || threads < 0)
+            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Invalid compression_threads " + option + ". Use a positive number of threads, or 0 for one per hardware thread");
+        return threads;
+    };
+
+#ifdef SBOL_HAVE_ZLIB
+    // Deflate one block of text, appending to out. If the block is not the last, the stream is flushed to a byte boundary so that blocks can be concatenated
+    void deflate_block(z_stream& stream, const char* text, size_t length, bool last, string& out)
+    {
+        size_t offset = 0;
+        int flush = Z_NO_FLUSH;
+        int status = Z_OK;
+        while (flush == Z_NO_FLUSH)
+        {
+            size_t chunk = min(length - offset, ZLIB_CHUNK_SIZE);
+            stream.next_in = (Bytef*)text + offset;
+            stream.avail_in = (uInt)chunk;
+            offset += chunk;
+            flush = offset < length ? Z_NO_FLUSH : last ? Z_FINISH : Z_SYNC_FLUSH;
+
+            // The output is complete once deflate leaves some of the space it was given unused
+            do
+            {
+                size_t out_start = out.size();
+                size_t room = min((size_t)deflateBound(&stream, stream.avail_in) + 16, ZLIB_CHUNK_SIZE);
+                out.resize(out_start + room);
+                stream.next_out = (Bytef*)&out[out_start];
+                stream.avail_out = (uInt)room;
+                status = deflate(&stream, flush);
+                out.resize(out.size() - stream.avail_out);
+                if (status == Z_STREAM_ERROR)
+                    throw SBOLError(SBOL_ERROR_SERIALIZATION, "Serialization failed. gzip compression error");
+            } while (stream.avail_out == 0);
+        }
+        if (stream.avail_in || (last && status != Z_STREAM_END))
+            throw SBOLError(SBOL_ERROR_SERIALIZATION, "Serialization failed. gzip compression error");
+    };
+
+    uLong crc32_of(const char* text, size_t length)
+    {
+        uLong checksum = crc32(0, Z_NULL, 0);
+        for (size_t offset = 0; offset < length; offset += ZLIB_CHUNK_SIZE)
+            checksum = crc32(checksum, (const Bytef*)text + offset, (uInt)min(length - offset, ZLIB_CHUNK_SIZE));
+        return checksum;
+    };
+
+    // Compress text into a single gzip member. Large texts are split into blocks that are deflated in parallel, each primed with the
+    // last 32 KB of the block before it, and the deflate streams of the blocks are concatenated, as pigz does
+    void gzip_compress(const string& text, int level, int threads, string& out)
+    {
+        size_t n_blocks = max((size_t)1, (text.size() + COMPRESSION_BLOCK_SIZE - 1) / COMPRESSION_BLOCK_SIZE);
+        if (threads == 1)
+            n_blocks = 1;
+        size_t block_size = n_blocks == 1 ? text.size() : COMPRESSION_BLOCK_SIZE;
+        vector<string> blocks(n_blocks);
+        vector<uLong> checksums(n_blocks);
+        parallel_for(n_blocks, threads, [&](size_t i_block)
+        {
+            size_t start = i_block * block_size;
+            size_t length = min(block_size, text.size() - start);
+            z_stream stream;
+            memset(&stream, 0, sizeof(stream));
+            if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                throw SBOLError(SBOL_ERROR_SERIALIZATION, "Serialization failed. gzip compression error");
+            size_t dictionary = min(start, (size_t)1 << MAX_WBITS);
+            if (dictionary)
+                deflateSetDictionary(&stream, (const Bytef*)text.data() + start - dictionary, (uInt)dictionary);
+            try
+            {
+                deflate_block(stream, text.data() + start, length, i_block == n_blocks - 1, blocks[i_block]);
+            }
+            catch (...)
+            {
+                deflateEnd(&stream);
+                throw;
+            }
+            deflateEnd(&stream);
+            checksums[i_block] = crc32_of(text.data() + start, length);
+        });
+
+        // Member header, with no file name or modification time, followed by the blocks and the checksum and length of the whole text
+        const unsigned char header[] = { 0x1f, 0x8b, Z_DEFLATED, 0, 0, 0, 0, 0, 0, 3 };
+        out.assign((const char*)header, sizeof(header));
+        uLong checksum = checksums[0];
+        for (size_t i_block = 0; i_block < n_blocks; ++i_block)
+        {
+            out += blocks[i_block];
+            if (i_block)
+                checksum = crc32_combine(checksum, checksums[i_block], (z_off_t)min(block_size, text.size() - i_block * block_size));
+        }
+        uint32_t trailer[2] = { (uint32_t)checksum, (uint32_t)text.size() };
+        for (auto value : trailer)
+            for (int i_byte = 0; i_byte < 4; ++i_byte)
+                out.push_back((char)((value >> (8 * i_byte)) & 0xff));
+    };
+#endif
+
+#ifdef SBOL_HAVE_ZSTD
+    // Compress text into a single zstd frame. Large texts are compressed by zstd's own worker threads
+    void zstd_compress(const string& text, int level, int threads, string& out)
+    {
+        ZSTD_CCtx* context = ZSTD_createCCtx();
+        ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, level);
+        if (threads != 1 && text.size() > COMPRESSION_BLOCK_SIZE)
+            ZSTD_CCtx_setParameter(context, ZSTD_c_nbWorkers, threads ? threads : (int)max(1u, thread::hardware_concurrency()));  // Fails harmlessly if zstd was built without threads
+        out.resize(ZSTD_compressBound(text.size()));
+        size_t size = ZSTD_compress2(context, &out[0], out.size(), text.data(), text.size());
+        ZSTD_freeCCtx(context);
+        if (ZSTD_isError(size))
+            throw SBOLError(SBOL_ERROR_SERIALIZATION, string("Serialization failed. zstd compression error: ") + ZSTD_getErrorName(size));
+        out.resize(size);
+    };
+#endif
+}
+
+namespace sbol
+{
+    // Decompresses a file as the raptor parser reads it
+    class InputDecoder
+    {
+    public:
+        FILE* fh;
+        vector<char> input;
+        string error;
+
+        InputDecoder(FILE* fh) :
+            fh(fh),
+            input(INPUT_BUFFER_SIZE)
+        {
+        };
+
+        virtual ~InputDecoder() {};
+
+        // Decompress up to size bytes. Returns the number of bytes, which is 0 at the end of the file, or -1 on error
+        virtual int read(char* out, size_t size) = 0;
+
+        // Whether all the input was decompressed
+        bool end = false;
+    };
+}
+
+namespace
+{
+#ifdef SBOL_HAVE_ZLIB
+    class GzipDecoder : public InputDecoder
+    {
+    public:
+        z_stream stream;
+
+        GzipDecoder(FILE* fh) :
+            InputDecoder(fh)
+        {
+            memset(&stream, 0, sizeof(stream));
+            inflateInit2(&stream, 16 + MAX_WBITS);
+        };
+
+        ~GzipDecoder()
+        {
+            inflateEnd(&stream);
+        };
+
+        int read(char* out, size_t size) override
+        {
+            stream.next_out = (Bytef*)out;
+            stream.avail_out = (uInt)size;
+            while (stream.avail_out && !end)
+            {
+                if (!stream.avail_in)
+                {
+                    stream.avail_in = (uInt)fread(input.data(), 1, input.size(), fh);
+                    stream.next_in = (Bytef*)input.data();
+                    if (!stream.avail_in)
+                    {
+                        error = "Unexpected end of gzip-compressed file";
+                        return -1;
+                    }
+                }
+                int status = inflate(&stream, Z_NO_FLUSH);
+                if (status == Z_STREAM_END)
+                {
+                    // A gzip file may hold several members, as concatenated files and parallel compressors produce
+                    if (!stream.avail_in)
+                    {
+                        stream.avail_in = (uInt)fread(input.data(), 1, input.size(), fh);
+                        stream.next_in = (Bytef*)input.data();
+                    }
+                    if (stream.avail_in)
+                        inflateReset(&stream);
+                    else
+                        end = true;
+                }
+                else if (status != Z_OK && status != Z_BUF_ERROR)
+                {
+                    error = string("Invalid gzip-compressed file: ") + (stream.msg ? stream.msg : "inflate error");
+                    return -1;
+                }
+            }
+            return (int)(size - stream.avail_out);
+        };
+    };
+#endif
+
+#ifdef SBOL_HAVE_ZSTD
+    class ZstdDecoder : public InputDecoder
+    {
+    public:
+        ZSTD_DStream* stream;
+        ZSTD_inBuffer in_buffer = { NULL, 0, 0 };
+        size_t frame_remaining = 0;  // The hint returned by the last call to ZSTD_decompressStream, which is 0 between frames
+
+        ZstdDecoder(FILE* fh) :
+            InputDecoder(fh),
+            stream(ZSTD_createDStream())
+        {
+            ZSTD_initDStream(stream);
+        };
+
+        ~ZstdDecoder()
+        {
+            ZSTD_freeDStream(stream);
+        };
+
+        int read(char* out, size_t size) override
+        {
+            ZSTD_outBuffer out_buffer = { out, size, 0 };
+            while (out_buffer.pos < out_buffer.size && !end)
+            {
+                if (in_buffer.pos == in_buffer.size)
+                {
+                    in_buffer.size = fread(input.data(), 1, input.size(), fh);
+                    in_buffer.src = input.data();
+                    in_buffer.pos = 0;
+                    if (!in_buffer.size)
+                    {
+                        // Frames may be concatenated, so the input may end only between frames
+                        if (frame_remaining)
+                        {
+                            error = "Unexpected end of zstd-compressed file";
+                            return -1;
+                        }
+                        end = true;
+                        break;
+                    }
+                }
+                frame_remaining = ZSTD_decompressStream(stream, &out_buffer, &in_buffer);
+                if (ZSTD_isError(frame_remaining))
+                {
+                    error = string("Invalid zstd-compressed file: ") + ZSTD_getErrorName(frame_remaining);
+                    return -1;
+                }
+            }
+            return (int)out_buffer.pos;
+        };
+    };
+#endif
+
+    int decoder_read_bytes(void* context, void* ptr, size_t size, size_t nmemb)
+    {
+        InputDecoder& decoder = *(InputDecoder*)context;
+        int n_bytes = decoder.read((char*)ptr, size * nmemb);
+        return n_bytes < 0 ? -1 : n_bytes / (int)size;
+    };
+
+    int decoder_read_eof(void* context)
+    {
+        InputDecoder& decoder = *(InputDecoder*)context;
+        return decoder.end || decoder.error.size();
+    };
+
+    const raptor_iostream_handler decoder_handler = { 2, NULL, NULL, NULL, NULL, NULL, decoder_read_bytes, decoder_read_eof };
+}
+
+Compression sbol::compression_from_filename(const std::string& filename)
+{
+    if (has_suffix(filename, ".gz"))
+        return Compression::GZIP;
+    if (has_suffix(filename, ".zst"))
+        return Compression::ZSTD;
+    return Compression::NONE;
+};
+
+void sbol::write_compressed_file(const std::string& filename, const std::string& text, Compression compression)
+{
+    string compressed;
+    if (compression != Compression::NONE)
+    {
+        SBOL_STATS_TIMER("compress");
+        int level = compression_level(compression);
+        int threads = compression_threads();
+        if (compression == Compression::GZIP)
+        {
+#ifdef SBOL_HAVE_ZLIB
+            gzip_compress(text, level, threads, compressed);
+#else
+            unsupported(compression);
+#endif
+        }
+        else
+        {
+#ifdef SBOL_HAVE_ZSTD
+            zstd_compress(text, level, threads, compressed);
+#else
+            unsupported(compression);
+#endif
+        }
+        SBOL_STATS_COUNT("bytes_compressed", compressed.size());
+    }
+    const string& output = compression == Compression::NONE ? text : compressed;
+
+    FILE* fh = fopen(filename.c_str(), "wb");
+    if (!fh)
+        throw SBOLError(SBOL_ERROR_SERIALIZATION, "Serialization failed. Could not open " + filename + " for writing");
+    bool written = fwrite(output.data(), 1, output.size(), fh) == output.size();
+    if (fclose(fh) || !written)
+        throw SBOLError(SBOL_ERROR_SERIALIZATION, "Serialization failed. Could not write to file");
+};
+
+InputFile::InputFile(raptor_world* world, FILE* fh) :
+    compression(Compression::NONE),
+    world(world),
+    fh(fh),
+    decoder(NULL),
+    supported(true)
+{
+    // Compressed files are recognized by their magic bytes, whatever their extension
+    unsigned char magic[4] = { 0, 0, 0, 0 };
+    size_t n_magic = fread(magic, 1, sizeof(magic), fh);
+    rewind(fh);
+    if (n_magic >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+        compression = Compression::GZIP;
+    else if (n_magic == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd)
+        compression = Compression::ZSTD;
+#ifndef SBOL_HAVE_ZLIB
+    if (compression == Compression::GZIP)
+        supported = false;
+#endif
+#ifndef SBOL_HAVE_ZSTD
+    if (compression == Compression::ZSTD)
+        supported = false;
+#endif
+};
+
+InputFile::~InputFile()
+{
+    delete decoder;
+};
+
+raptor_iostream* InputFile::open()
+{
+    rewind(fh);
+    if (compression == Compression::NONE)
+        return raptor_new_iostream_from_file_handle(world, fh);
+    delete decoder;
+    decoder = NULL;
+#ifdef SBOL_HAVE_ZLIB
+    if (compression == Compression::GZIP)
+        decoder = new GzipDecoder(fh);
+#endif
+#ifdef SBOL_HAVE_ZSTD
+    if (compression == Compression::ZSTD)
+        decoder = new ZstdDecoder(fh);
+#endif
+    return raptor_new_iostream_from_handler(world, decoder, &decoder_handler);
+};
+
+void InputFile::check()
+{
+    if (!supported)
+        unsupported(compression);
+    if (decoder && decoder->error.size())
+        throw SBOLError(SBOL_ERROR_PARSE, decoder->error);
+};
@@ -26,8 +26,10 @@
 #include "config.h"
 
 #include <string>
-#include <stdlib.h>     /* srand, rand */
 #include <time.h>
+#include <chrono>
+#include <mutex>
+#include <random>
 #include <vector>
 #include <algorithm>
 #include <json/json.h>
@@ -66,7 +68,9 @@ std::map<std::string, std::string> sbol::Config::options {
     {"main_file_name", "main file"},
     {"diff_file_name", "comparison file"},
     {"return_file", "False"},
-    {"verbose", "False"}
+    {"verbose", "False"},
+    {"compression_level", ""},  // Level of gzip (0-9) or zstd (1-22) compression for files written with a .gz or .zst extension. Empty uses the default of the format
+    {"compression_threads", "0"}  // Threads used to compress large files. 0 uses one per hardware thread
 };
 
 std::map<std::string, std::vector<std::string>> sbol::Config::valid_options {
@@ -88,6 +92,14 @@ std::map<std::string, std::vector<std::string>> sbol::Config::valid_options {
 
 #if defined(SBOL_BUILD_PYTHON2) || defined(SBOL_BUILD_PYTHON3)
 std::map<std::string, PyObject*> sbol::Config::PYTHON_DATA_MODEL_REGISTER {};
+
+std::string sbol::Config::getExtensionClassType(PyObject* python_class)
+{
+    for (auto & i_class : PYTHON_DATA_MODEL_REGISTER)
+        if (i_class.second == python_class)
+            return i_class.first;
+    return "";
+}
 #endif
 
 void sbol::Config::setOption(std::string option, char const* value)
@@ -171,9 +183,10 @@ void sbol::Config::setOption(std::string option, bool value)
 
 std::string sbol::Config::getOption(std::string option)
 {
-    if (options.find(option) != options.end())
+    auto i_option = options.find(option);
+    if (i_option != options.end())
     {
-        return options[option];
+        return i_option->second;
     }
     else
     {
@@ -209,20 +222,100 @@ std::string sbol::constructNonCompliantURI(std::string uri)
         return "";
 };
 
-// Defines format for randomly generated identifier strings to be used in autoconstructed URIs
+namespace
+{
+    // Mixes a 64-bit value into a well-distributed one. Used to derive the random parts of identifiers from a single seed
+    uint64_t splitmix64(uint64_t x)
+    {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    };
+
+    // Random bits that distinguish the identifiers of this process from those minted by other processes in the same millisecond
+    uint64_t process_seed()
+    {
+        static const uint64_t seed = []()
+        {
+            random_device device;
+            uint64_t entropy = ((uint64_t)device() << 32) ^ device();
+            return splitmix64(entropy ^ (uint64_t)chrono::high_resolution_clock::now().time_since_epoch().count());
+        }();
+        return seed;
+    };
+
+    // Each thread that mints identifiers claims a slot once. The slot and a per-thread sequence number make every identifier in the process unique without locking.
+    // A thread returns its slot when it exits, with the sequence number it reached, and the next thread to claim the slot continues that sequence
+    struct IdentifierSlots
+    {
+        mutex lock;
+        uint64_t next_slot = 0;
+        vector<pair<uint64_t, uint64_t>> free_slots;
+    };
+
+    // Never destroyed, because threads may exit after static objects are destroyed
+    IdentifierSlots& identifier_slots()
+    {
+        static IdentifierSlots* slots = new IdentifierSlots();
+        return *slots;
+    };
+
+    struct IdentifierState
+    {
+        uint64_t slot;
+        uint64_t sequence;
+        uint64_t rand_a;
+        uint64_t salt;
+
+        IdentifierState() :
+            sequence(0),
+            salt(process_seed() & 0x3FFFFFFFFFFFFFFFULL)
+        {
+            IdentifierSlots& slots = identifier_slots();
+            {
+                lock_guard<mutex> lock(slots.lock);
+                if (slots.free_slots.size())
+                {
+                    slot = slots.free_slots.back().first;
+                    sequence = slots.free_slots.back().second;
+                    slots.free_slots.pop_back();
+                }
+                else
+                    slot = slots.next_slot++;
+            }
+            rand_a = splitmix64(process_seed() + slot) & 0xFFF;
+        };
+
+        ~IdentifierState()
+        {
+            IdentifierSlots& slots = identifier_slots();
+            lock_guard<mutex> lock(slots.lock);
+            slots.free_slots.push_back({ slot, sequence });
+        };
+    };
+}
+
+// Defines format for randomly generated identifier strings to be used in autoconstructed URIs. Identifiers are time-ordered 128-bit UUIDs (version 7), written as 8-4-4-4-12 hexadecimal digits. They begin with the time in milliseconds, followed by random bits. The last 62 bits hold the slot of the minting thread (22 bits) and its sequence number (40 bits), scrambled with a per-process salt, so no two identifiers minted by the same process are equal. Slots are reused after their threads exit, so only more than 2^22 threads minting at once would share one
 string sbol::randomIdentifier()
 {
-    string id;
-    srand(time(NULL));
-    for (auto i = 1; i <= 16; i++)
+    thread_local IdentifierState state;
+    uint64_t time_ms = (uint64_t)chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    uint64_t unique_bits = ((state.slot & 0x3FFFFF) << 40) | (state.sequence++ & 0xFFFFFFFFFFULL);
+    uint64_t high = (time_ms << 16) | 0x7000 | state.rand_a;
+    uint64_t low = 0x8000000000000000ULL | (unique_bits ^ state.salt);
+
+    static const char hex_digits[] = "0123456789abcdef";
+    char id[36];
+    int i_char = 0;
+    for (int i_digit = 0; i_digit < 32; ++i_digit)
     {
-        int r_digit = rand() % 10;
-        //id = id + to_string(r_digit);
-        id = r_digit;
-        if (r_digit % 4 == 0 && r_digit != 16)
-            id = id + "-";
+        if (i_digit == 8 || i_digit == 12 || i_digit == 16 || i_digit == 20)
+            id[i_char++] = '-';
+        uint64_t word = i_digit < 16 ? high : low;
+        id[i_char++] = hex_digits[(word >> (60 - 4 * (i_digit % 16))) & 0xF];
     }
-    return id;
+    return string(id, sizeof(id));
 }
 
 // This autoconstruct method constructs non-SBOL-compliant URIs
@@ -368,6 +461,10 @@ void Config::setFileFormat(std::string file_format)
 {
     if (file_format.compare("json") == 0)
         this->format = "json";
+    else if (file_format.compare("ntriples") == 0)
+        this->format = "ntriples";
+    else if (file_format.compare("turtle") == 0)
+        this->format = "turtle";
     else
         this->format = "rdfxml";
 };
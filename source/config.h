@@ -113,13 +113,20 @@ namespace sbol
         /// Get current option value for online validation and conversion
         /// @param option The option key
         static std::string getOption(std::string option);
+
+#if defined(SBOL_BUILD_PYTHON2) || defined(SBOL_BUILD_PYTHON3)
+        /// @cond
+        /// @return The RDF type under which a Python extension class was registered, or an empty string if it has not been registered
+        static std::string getExtensionClassType(PyObject* python_class);
+        /// @endcond
+#endif
     };
     
     /// Global methods
 	SBOL_DECLSPEC void setHomespace(std::string ns); ///< Set the default namespace for autocreation of URIs when a new SBOL object is created
 	SBOL_DECLSPEC extern std::string getHomespace(); ///< Get the current default namespace for autocreation of URIs when a new SBOL object is created
 	SBOL_DECLSPEC int hasHomespace();                ///< Checks if a valid default namespace has been defined
-	SBOL_DECLSPEC void setFileFormat(std::string file_format);    ///< Sets file format to use
+	SBOL_DECLSPEC void setFileFormat(std::string file_format);    ///< Sets file format to use: rdfxml (default), json, ntriples or turtle
     std::string SBOL_DECLSPEC getFileFormat();       ///< Returns currently accepted file format
     
     /// <!--------- Utility methods for parsing URIs ------\>
@@ -28,6 +28,12 @@
 
 #include <tuple>
 #include <cctype>
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <memory>
 
 using namespace std;
 using namespace sbol;
@@ -523,7 +529,9 @@ namespace sbol
         add<Implementation>((Implementation&)sbol_obj);
 
         // Move from Implementation store to Build store
+        record_object_removed(this, SBOL_IMPLEMENTATION, this->owned_objects[SBOL_IMPLEMENTATION].size() - 1);
         this->owned_objects[SBOL_IMPLEMENTATION].pop_back();
+        record_object_added(this, SYSBIO_BUILD, &sbol_obj);
         this->owned_objects[SYSBIO_BUILD].push_back(&sbol_obj);
 
     }
@@ -535,7 +543,9 @@ namespace sbol
         add<Collection>((Collection&)sbol_obj);
         
         // Move from Collection store to Test store
+        record_object_removed(this, SBOL_COLLECTION, this->owned_objects[SBOL_COLLECTION].size() - 1);
         this->owned_objects[SBOL_COLLECTION].pop_back();
+        record_object_added(this, SYSBIO_TEST, &sbol_obj);
         this->owned_objects[SYSBIO_TEST].push_back(&sbol_obj);
     }
     
@@ -560,7 +570,9 @@ namespace sbol
     template<>
     Build& OwnedObject<Build>::create(std::string uri)
     {
+        check_mutable(this->sbol_owner);
         Build* child_obj = new Build();
+        record_created(this->sbol_owner, child_obj);
 
         SBOLObject* parent_obj = this->sbol_owner;
         Document* parent_doc = this->sbol_owner->doc;
@@ -589,13 +601,18 @@ namespace sbol
             // this->add(*child_obj);   Can't use this because the add method is prohibited in SBOLCompliant mode!!!
             child_obj->parent = parent_obj;  // Set back-pointer to parent object
             std::vector< sbol::SBOLObject* >& object_store = this->sbol_owner->owned_objects[this->type];
+            record_object_added(this->sbol_owner, this->type, child_obj);
             object_store.push_back((SBOLObject*)child_obj);
+            notify_property_change(this->sbol_owner, this->type);
+            notify_change(SBOL_CHANGE_OBJECT_ADDED, this->sbol_owner, this->type, child_obj);
 
             // The following effectively adds the child object to the Document by setting its back-pointer.  However, the Document itself only maintains a register of TopLevel objects, otherwise the returned object will not be registered
             if (parent_doc)
             {
                 child_obj->doc = parent_doc;
+                record_registration(parent_doc, child_id);
                 parent_doc->SBOLObjects[child_id] = (SBOLObject*)child_obj;
+                notify_change(SBOL_CHANGE_TOPLEVEL_ADDED, parent_doc, "", child_obj);
             }
             this->validate(child_obj);
             return *child_obj;
@@ -622,7 +639,9 @@ namespace sbol
     template<>
     Test& OwnedObject<Test>::create(std::string uri)
     {
+        check_mutable(this->sbol_owner);
         Test* child_obj = new Test();
+        record_created(this->sbol_owner, child_obj);
 
         SBOLObject* parent_obj = this->sbol_owner;
         Document* parent_doc = this->sbol_owner->doc;
@@ -651,13 +670,18 @@ namespace sbol
             // this->add(*child_obj);   Can't use this because the add method is prohibited in SBOLCompliant mode!!!
             child_obj->parent = parent_obj;  // Set back-pointer to parent object
             std::vector< sbol::SBOLObject* >& object_store = this->sbol_owner->owned_objects[this->type];
+            record_object_added(this->sbol_owner, this->type, child_obj);
             object_store.push_back((SBOLObject*)child_obj);
+            notify_property_change(this->sbol_owner, this->type);
+            notify_change(SBOL_CHANGE_OBJECT_ADDED, this->sbol_owner, this->type, child_obj);
 
             // The following effectively adds the child object to the Document by setting its back-pointer.  However, the Document itself only maintains a register of TopLevel objects, otherwise the returned object will not be registered
             if (parent_doc)
             {
                 child_obj->doc = parent_doc;
+                record_registration(parent_doc, child_id);
                 parent_doc->SBOLObjects[child_id] = (SBOLObject*)child_obj;
+                notify_change(SBOL_CHANGE_TOPLEVEL_ADDED, parent_doc, "", child_obj);
             }
             this->validate(child_obj);
             return *child_obj;
@@ -713,147 +737,153 @@ namespace sbol
 #define SO_NUCLEOTIDE_MATCH "http://purl.obolibrary.org/obo/SO_0000347"
 
 
-    std::string verify_base(char target_base, char actual_base)
+    // Classifications of alignment columns and QC annotations, and the Sequence Ontology terms used as their roles
+    enum QCClassification { QC_MATCH, QC_SUBSTITUTION, QC_DELETION, QC_INSERTION, QC_AMBIGUOUS, N_QC_CLASSIFICATIONS };
+    const char* QC_ROLES[N_QC_CLASSIFICATIONS] = { SO_NUCLEOTIDE_MATCH, SO_SUBSTITUTION, SO_DELETION, SO_INSERTION, SO_POSSIBLE_ASSEMBLY_ERROR };
+
+    bool is_actg(char base)
+    {
+        return base == 'A' || base == 'C' || base == 'T' || base == 'G';
+    };
+
+    // Classify an alignment column by comparing the target base with the consensus base
+    int classify_alignment_column(char target_base, char actual_base)
     {
-        target_base = std::toupper(target_base);
-        actual_base = std::toupper(actual_base);
-        vector<char> actg = {'A', 'C', 'T', 'G'};
+        target_base = std::toupper((unsigned char)target_base);
+        actual_base = std::toupper((unsigned char)actual_base);
 
         if (target_base == actual_base)
-            return SO_NUCLEOTIDE_MATCH;
-        else if (target_base == '-' && actual_base == 'N')
-            return SO_POSSIBLE_ASSEMBLY_ERROR;
-        else if (target_base == '-' && find(actg.begin(), actg.end(), actual_base) != actg.end())
-            return SO_INSERTION;
-        else if (find(actg.begin(), actg.end(), target_base) != actg.end() && actual_base == 'N')
-            return SO_POSSIBLE_ASSEMBLY_ERROR;
-        else if (find(actg.begin(), actg.end(), target_base) != actg.end() && actual_base == '-')
-            return SO_DELETION;
-        else if (target_base != actual_base)
-            return SO_SUBSTITUTION;
-        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Could not annotate sequences because of invalid base comparison");
-    }
+            return QC_MATCH;
+        if (target_base == '-' || is_actg(target_base))
+        {
+            if (actual_base == 'N')
+                return QC_AMBIGUOUS;
+            if (target_base == '-' && is_actg(actual_base))
+                return QC_INSERTION;
+            if (target_base != '-' && actual_base == '-')
+                return QC_DELETION;
+        }
+        return QC_SUBSTITUTION;
+    };
 
-    void addQCAnnotations(ComponentDefinition& target, ComponentDefinition& construct)
+    // Scans a pairwise alignment of a target sequence and a consensus sequence in a single pass. The scan produces a
+    // run-length map from alignment coordinates to target coordinates, and the maximal runs of alignment columns which
+    // share a classification. Alignment and target coordinates are indexed from one. A scanner can be reused for
+    // successive alignments, in which case its buffers are recycled
+    class AlignmentScanner
     {
-        Sequence& target_s = target.doc->get<Sequence>(target.sequence.get());
-        Sequence& construct_s = construct.doc->get<Sequence>(construct.sequence.get());
-        string target_sequence = target_s.elements.get();
-        string verified_sequence = construct_s.elements.get();
-        
-        /* Clip gaps from target and verified sequences */
-        string target_clipped = target_sequence;
-        string verified_clipped = verified_sequence;
-        size_t pos;
-        while ((pos = target_clipped.find('-')) != std::string::npos)
-            target_clipped = target_clipped.substr(0, pos) + target_clipped.substr(pos + 1, target_clipped.size() - pos);
-        while ((pos = verified_clipped.find('-')) != std::string::npos)
-            verified_clipped = verified_clipped.substr(0, pos) + verified_clipped.substr(pos + 1, verified_clipped.size() - pos);
-        
-        /* The following indices mark the beginning coordinates of clipped sequences translated into alignment coordinates. This is necessary, for example, if the target sequence is not fully covered by sequence reads, resulting in gaps padding the beginning and end of the consensus read, or if there are insertions in the verified sequence.
-           eg.,
-           target: actggtca
-           actual: --tggt-- 
-         */
-        size_t l_verified = verified_sequence.find(verified_clipped[0]);
-        size_t l_target = target_sequence.find(target_clipped[0]);
-        size_t r_verified = verified_sequence.find_last_of(verified_clipped[verified_clipped.size() - 1]);
-        size_t r_target = target_sequence.find_last_of(target_clipped[target_clipped.size() - 1]);
-        
-        if (Config::getOption("verbose") == "True")
+    public:
+        // A run of alignment columns over which the target coordinate advances one base per column, or holds across a gap in the target
+        struct CoordinateRun
         {
-            cout << "Target:    " << target_sequence << endl;
-            cout << "Consensus: " << verified_sequence << endl;
-            cout << "Target:    " << target_clipped << endl;
-            cout << "Consensus: " << verified_clipped << endl;
-//
-//            cout << (int)l_verified << endl;
-//            cout << (int)r_verified << endl;
-        }
-        
-        /* Calculate lengths of sequences */
-        size_t L_alignment = verified_sequence.size();
-        size_t L_target_clipped = target_clipped.size();
-        size_t L_actual = verified_clipped.size();
-
-        /* Map nucleotide coordinates of target sequence to alignment coordinates. Nucleotide coordinates are indexed from one */
-        map < int, int > target_map = {};
-        size_t i_target = 0;
-        for (size_t i_alignment = l_target; i_alignment <= r_target; ++i_alignment)
+            size_t alignment_start;
+            size_t length;
+            int target_start;
+            bool gap;
+        };
+
+        struct ClassificationRun
         {
-            char target_base = target_sequence[i_alignment];
-            char verified_base = verified_sequence[i_alignment];
-            if (target_base != '-')
-            {
-                i_target += 1;
-                //            target_map[i_target] = i_alignment;
-                //            assert(target_clipped[i_target] == target_sequence[target_map[i_target]]);
-            }
-            target_map[i_alignment+1] = i_target;
-        }
-        
-        int region_start = 1;
-        int region_end = 1;
-        vector < SequenceAnnotation* > variant_annotations;
-        int i_annotation = 0;
-        
-        // Scan alignment base by base and classify regions of interest. Bases are indexed from one not zero
-        string verification_code;
-        string current_region_classification = verify_base(target_sequence[0], verified_sequence[0]);
-        for (int i_base = 1; i_base <= L_alignment; ++i_base)
+            int classification;
+            size_t alignment_start;
+            size_t alignment_end;
+        };
+
+        vector < CoordinateRun > coordinate_map;
+        vector < ClassificationRun > runs;
+
+        void scan(const string& target, const string& consensus)
         {
-            verification_code = verify_base(target_sequence[i_base - 1], verified_sequence[i_base - 1]);
-            
-            if (Config::getOption("verbose") == "True")
-                cout << i_base << "\t" << target_map[i_base] << "\t" << target_sequence[i_base - 1] << "\t" << verified_sequence[i_base - 1] << "\t" << verification_code << endl;
-            
-            if (verification_code.compare(current_region_classification) == 0)
-            {
-                // Extend region of interest
-                ++region_end;
-            }
-            else
+            coordinate_map.clear();
+            runs.clear();
+
+            // Gaps padding either end of the target, eg, where the target is not fully covered by sequence reads, lie outside the coordinate map
+            size_t L_alignment = target.size();
+            size_t l_target = target.find_first_not_of('-');
+            size_t r_target = target.find_last_not_of('-');
+            int i_target = 0;
+            for (size_t i_alignment = 0; i_alignment < L_alignment; ++i_alignment)
             {
-                // Mark end of region of interest
-                region_end = i_base - 1;
-                
-                // Insertions and deletions at the ends are not valid annotations (uncovered by sequence reads)
-                if (i_annotation == 0 && current_region_classification.compare(SO_INSERTION) == 0)
-                    ;
-                else if (i_annotation == 0 && current_region_classification.compare(SO_DELETION) == 0)
-                    ;
+                int classification = classify_alignment_column(target[i_alignment], consensus[i_alignment]);
+                if (runs.size() && runs.back().classification == classification)
+                    runs.back().alignment_end = i_alignment + 1;
                 else
-                {
-                    // Annotate region of interest
-                    SequenceAnnotation& sa = construct.sequenceAnnotations.create < SequenceAnnotation >("qc" + to_string(i_annotation));
-                    sbol::Range& r = sa.locations.create < sbol::Range > ("r");
-                    r.start.set(target_map[region_start]);  // Translate region of interest into target coordinates
-                    r.end.set(target_map[region_end]);
-                    variant_annotations.push_back(&sa);
-                    sa.roles.set(current_region_classification);
-                    ++i_annotation;
-                }
+                    runs.push_back({ classification, i_alignment + 1, i_alignment + 1 });
 
-                // Begin a new region
-                current_region_classification = verification_code;
-                region_start = i_base;
+                if (l_target == string::npos || i_alignment < l_target || i_alignment > r_target)
+                    continue;
+                bool gap = (target[i_alignment] == '-');
+                if (!gap)
+                    ++i_target;
+                if (coordinate_map.size() && coordinate_map.back().gap == gap)
+                    ++coordinate_map.back().length;
+                else
+                    coordinate_map.push_back({ i_alignment + 1, 1, i_target, gap });
             }
+        };
+
+        // Translate an alignment coordinate into a target coordinate. Coordinates outside the span of the target map to zero
+        int translate(size_t i_alignment) const
+        {
+            auto i_run = upper_bound(coordinate_map.begin(), coordinate_map.end(), i_alignment, [](size_t x, const CoordinateRun& run) { return x < run.alignment_start; });
+            if (i_run == coordinate_map.begin())
+                return 0;
+            --i_run;
+            if (i_alignment >= i_run->alignment_start + i_run->length)
+                return 0;
+            if (i_run->gap)
+                return i_run->target_start;
+            return i_run->target_start + (int)(i_alignment - i_run->alignment_start);
+        };
+    };
+
+    // A region of interest in an alignment, in target coordinates
+    struct QCRegion
+    {
+        int classification;
+        int start;
+        int end;
+    };
+
+    // Classify the regions of interest in an alignment. Insertions and deletions at the ends are not valid regions (uncovered by sequence reads)
+    void scan_qc_regions(AlignmentScanner& alignment, const string& target_sequence, const string& verified_sequence, vector < QCRegion >& qc_regions)
+    {
+        alignment.scan(target_sequence, verified_sequence);
+        qc_regions.clear();
+        for (size_t i_run = 0; i_run < alignment.runs.size(); ++i_run)
+        {
+            auto& run = alignment.runs[i_run];
+            bool indel = (run.classification == QC_INSERTION || run.classification == QC_DELETION);
+            if (indel && (qc_regions.empty() || i_run == alignment.runs.size() - 1))
+                continue;
+            qc_regions.push_back({ run.classification, alignment.translate(run.alignment_start), alignment.translate(run.alignment_end) });
         }
-        if (region_end >= L_alignment)
-            region_end = L_alignment - 1;  // In case the sequences have perfect identity
-        // Annotate final region of interest.  Insertions and deletions are not valid (uncovered by sequence reads)
-        if (current_region_classification.compare(SO_INSERTION) == 0 || current_region_classification.compare(SO_DELETION) == 0)
-            ;
-        else
+    };
+
+    // Annotate the construct with the regions of interest found in its alignment to the target
+    void create_qc_annotations(ComponentDefinition& construct, const string& target_sequence, const string& verified_sequence, const vector < QCRegion >& qc_regions)
+    {
+        if (Config::getOption("verbose") == "True")
         {
-            SequenceAnnotation& sa = construct.sequenceAnnotations.create < SequenceAnnotation >("qc" + to_string(i_annotation));
-            sa.roles.set(current_region_classification);
+            cout << "Target:    " << target_sequence << endl;
+            cout << "Consensus: " << verified_sequence << endl;
+        }
+
+        vector < SequenceAnnotation* > variant_annotations;
+        // Defers the Document-wide URI check on each create to a single check at the end. If the check fails, the annotations are
+        // removed again before the error is thrown, so the construct is left as it was
+        BulkInsert bulk_insert(*construct.doc);
+        for (auto & region : qc_regions)
+        {
+            SequenceAnnotation& sa = construct.sequenceAnnotations.create < SequenceAnnotation >("qc" + to_string(variant_annotations.size()));
             sbol::Range& r = sa.locations.create < sbol::Range > ("r");
-            r.start.set(target_map[region_start]);
-            r.end.set(target_map[++region_end]);
+            r.start.set(region.start);
+            r.end.set(region.end);
+            sa.roles.set(QC_ROLES[region.classification]);
             variant_annotations.push_back(&sa);
         }
-        
+        bulk_insert.commit();
+
         if (Config::getOption("verbose") == "True")
         {
             std::cout << "Added QC Annotations:" << std::endl;
@@ -866,20 +896,41 @@ namespace sbol
         }
     };
 
+    void addQCAnnotations(ComponentDefinition& target, ComponentDefinition& construct)
+    {
+        Sequence& target_s = target.doc->get<Sequence>(target.sequence.get());
+        Sequence& construct_s = construct.doc->get<Sequence>(construct.sequence.get());
+        string target_sequence = target_s.elements.get();
+        string verified_sequence = construct_s.elements.get();
+
+        AlignmentScanner alignment;
+        vector < QCRegion > qc_regions;
+        scan_qc_regions(alignment, target_sequence, verified_sequence, qc_regions);
+        create_qc_annotations(construct, target_sequence, verified_sequence, qc_regions);
+    };
+
+    // The Build and target design that verifyTarget resolves by following links back through an Analysis
+    struct VerificationTarget
+    {
+        Build* build;
+        ComponentDefinition* design_structure;
+        string target_sequence;
+    };
 
-    void Analysis::verifyTarget(Sequence& consensus)
+    VerificationTarget resolve_verification_target(Analysis& analysis, Sequence& consensus)
     {
-        if (consensusSequence.size())
+        if (analysis.consensusSequence.size())
             throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot verify target. The consensusSequence property for this Analysis has already been set. Perform a new Analysis or remove the Sequence.");
 
+        Document* doc = analysis.doc;
         if (!doc)
-            throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot verify target. Analysis " + identity.get() + " does not belong to a Document");
+            throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot verify target. Analysis " + analysis.identity.get() + " does not belong to a Document");
 
         // Retrieve Design by following links back through Analysis
-        if (!rawData.size() || !doc->tests.find(rawData.get()))
+        if (!analysis.rawData.size() || !doc->tests.find(analysis.rawData.get()))
             throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot verify target because the Analysis is not linked to a Design. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
         
-        Test& test = doc->get<Test>(rawData.get());
+        Test& test = doc->get<Test>(analysis.rawData.get());
         if (!test.samples.size() || !doc->builds.find(test.samples.get()) )
             throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot verify target because the Analysis is not linked to a Design. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
         
@@ -896,13 +947,17 @@ namespace sbol
             throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot verify target because the Design does not specify a target Sequence or the Sequence is not in the Document.");
         
         Sequence& target = doc->get<Sequence>(design_structure.sequence.get());
-        string target_sequence = target.elements.get();
-        string verified_sequence = consensus.elements.get();
-        if (target_sequence.size() != verified_sequence.size())
+        VerificationTarget verification = { &build, &design_structure, target.elements.get() };
+        if (verification.target_sequence.size() != consensus.elements.get().size())
             throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Invalid consensus sequence. Target sequence and consensus sequence are not equal lengths. Perform a sequence alignment first.");
+        return verification;
+    };
 
+    // Attach the consensus Sequence to the Analysis and to the structure of the Build, which is constructed if necessary
+    ComponentDefinition& attach_consensus_sequence(Analysis& analysis, Build& build, Sequence& consensus)
+    {
 //        // Set consensusSequence property of the Analysis
-        consensusSequence.set(consensus);
+        analysis.consensusSequence.set(consensus);
         
         // Auto-construct Build.structure
         if (!build.structure.size())
@@ -918,133 +973,104 @@ namespace sbol
 
         // Set Build sequence to the consensusSequence
         build_structure.sequence.set(consensus);
-        
-        ::addQCAnnotations(design_structure, build_structure);
+        return build_structure;
+    };
+
+    void Analysis::verifyTarget(Sequence& consensus)
+    {
+        VerificationTarget verification = resolve_verification_target(*this, consensus);
+        ComponentDefinition& build_structure = attach_consensus_sequence(*this, *verification.build, consensus);
+        ::addQCAnnotations(*verification.design_structure, build_structure);
     };
     
     
-    float calculateIdentity(SequenceAnnotation& target, vector<SequenceAnnotation*> qc_annotations)
+    int classify_qc_annotation(const string& role)
     {
-        int n_identical = 0;
-
-        if (target.locations.size() == 0)
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate identity. SequenceAnnotation " + target.identity.get() + " is invalid for this operation because it has no Range specified");
-        if (target.locations.size() > 1)
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate identity. SequenceAnnotation " + target.identity.get() + " is invalid for this operation because it has more than one Range specified");
-        sbol::Range& r_target = (sbol::Range&)target.locations[0];
-        
-        if (Config::getOption("verbose") == "True")
-            cout << r_target.start.get() << "\t" << r_target.end.get() << "\t";
+        if (role.compare(SO_NUCLEOTIDE_MATCH) == 0)
+            return QC_MATCH;
+        if (role.compare(SO_SUBSTITUTION) == 0)
+            return QC_SUBSTITUTION;
+        if (role.compare(SO_DELETION) == 0)
+            return QC_DELETION;
+        if (role.compare(SO_INSERTION) == 0)
+            return QC_INSERTION;
+        if (role.compare(SO_POSSIBLE_ASSEMBLY_ERROR) == 0)
+            return QC_AMBIGUOUS;
+        return -1;
+    };
 
-        for (auto &p_qc : qc_annotations)
-        {
-            SequenceAnnotation& qc = *p_qc;
-            if (qc.locations.size() == 0)
-                throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate identity. SequenceAnnotation " + qc.identity.get() + " is invalid for this operation because it has no Range specified");
-            if (qc.locations.size() > 1)
-                throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate identity. A SequenceAnnotation " + qc.identity.get() + " is invalid for this operation because it has more than one Range specified");
-            sbol::Range& r_qc = (sbol::Range&)qc.locations[0];
-            
-            if (Config::getOption("verbose") == "True")
-                cout << r_qc.start.get() << "\t" << r_qc.end.get() << "\t";
+    sbol::Range& get_qc_range(SequenceAnnotation& sa)
+    {
+        if (sa.locations.size() == 0)
+            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report. SequenceAnnotation " + sa.identity.get() + " is invalid for this operation because it has no Range specified");
+        if (sa.locations.size() > 1)
+            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report. SequenceAnnotation " + sa.identity.get() + " is invalid for this operation because it has more than one Range specified");
+        return (sbol::Range&)sa.locations[0];
+    };
 
+    typedef array < long long, N_QC_CLASSIFICATIONS > QCCounts;
 
-            string qc_classification = qc.roles.get();
-            if (qc_classification.compare(SO_NUCLEOTIDE_MATCH) == 0)
-            {
-                n_identical += r_target.contains(r_qc) + r_target.overlaps(r_qc);
-                if (Config::getOption("verbose") == "True")
-                    cout << "Contains: " << r_target.contains(r_qc) << "\tOverlaps: " <<  r_target.overlaps(r_qc) << "\tIdentical: " << n_identical << "\n\t\t";
-            }
-            else
-                if (Config::getOption("verbose") == "True")
-                    cout << "\n\t\t";
-        }
-        if (Config::getOption("verbose") == "True")
+    // Count the bases of each region which are overlapped by QC annotations of each classification. A QC annotation
+    // contributes the length of its overlap with a region, so the count for region [start, end] is F(end) - F(start - 1),
+    // where F(x) is the number of annotated bases at or before coordinate x. F is piecewise linear with a change of slope
+    // at the boundaries of each QC annotation, so it is evaluated at every region boundary in one sweep over the sorted
+    // boundaries, rather than by comparing every region against every QC annotation
+    vector < QCCounts > count_qc_bases(const vector < pair < int, int > >& regions, const vector < tuple < int, int, int > >& qc_ranges)
+    {
+        // An event at coordinate x changes the slope of F for coordinates greater than x
+        struct SlopeChange { long long x; int classification; int delta; };
+        vector < SlopeChange > events;
+        events.reserve(2 * qc_ranges.size());
+        for (auto & qc_range : qc_ranges)
         {
-            cout << (float)n_identical << "\t" << (float)r_target.length() << endl;
-            cout << "\n";
+            int start = get<0>(qc_range);
+            int end = get<1>(qc_range);
+            if (end < start)
+                continue;
+            events.push_back({ (long long)start - 1, get<2>(qc_range), 1 });
+            events.push_back({ (long long)end, get<2>(qc_range), -1 });
         }
-        return (float)n_identical / (float)r_target.length();
-    };
+        sort(events.begin(), events.end(), [](const SlopeChange& a, const SlopeChange& b) { return a.x < b.x; });
 
-    float calculateError(SequenceAnnotation& target, vector<SequenceAnnotation*> qc_annotations)
-    {
-        int n_substitution = 0;
-        int n_deletion = 0;
-        int n_insertion = 0;
-
-        if (target.locations.size() == 0)
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate error. SequenceAnnotation " + target.identity.get() + " is invalid for this operation because it has no Range specified");
-        if (target.locations.size() > 1)
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate error. SequenceAnnotation " + target.identity.get() + " is invalid for this operation because it has more than one Range specified");
-        sbol::Range& r_target = (sbol::Range&)target.locations[0];
-    //    cout << r_target.start.get() << "\t" << r_target.end.get() << "\t";
-        
-        for (auto &p_qc : qc_annotations)
+        // Each region queries F at two coordinates
+        vector < pair < long long, size_t > > queries;
+        queries.reserve(2 * regions.size());
+        for (size_t i_region = 0; i_region < regions.size(); ++i_region)
         {
-            SequenceAnnotation& qc = *p_qc;
-            if (qc.locations.size() == 0)
-                throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate error. SequenceAnnotation " + qc.identity.get() + " is invalid for this operation because it has no Range specified");
-            if (qc.locations.size() > 1)
-                throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate error. A SequenceAnnotation " + qc.identity.get() + " is invalid for this operation because it has more than one Range specified");
-            sbol::Range& r_qc = (sbol::Range&)qc.locations[0];
-    //        cout << r_qc.start.get() << "\t" << r_qc.end.get();
-            
-            
-            string qc_classification = qc.roles.get();
-            if (qc_classification.compare(SO_SUBSTITUTION) == 0)
-                n_substitution += r_target.contains(r_qc) + r_target.overlaps(r_qc);
-            else if (qc_classification.compare(SO_DELETION) == 0)
-                n_deletion += r_target.contains(r_qc) + r_target.overlaps(r_qc);
-            else if (qc_classification.compare(SO_INSERTION) == 0)
-                n_insertion += r_target.contains(r_qc) + r_target.overlaps(r_qc);
-            
-    //        else
-    //            cout << "\n\t\t";
+            queries.push_back({ (long long)regions[i_region].first - 1, 2 * i_region });
+            queries.push_back({ (long long)regions[i_region].second, 2 * i_region + 1 });
         }
-    //    cout << "\n";
-        return (float)(n_substitution + n_deletion + n_insertion) / (float)(r_target.length() + n_insertion);
-    };
+        sort(queries.begin(), queries.end());
 
-    float calculateAmbiguity(SequenceAnnotation& target, vector<SequenceAnnotation*> qc_annotations)
-    {
-        int n_ambiguous = 0;
-        
-        if (target.locations.size() == 0)
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate ambiguity. SequenceAnnotation " + target.identity.get() + " is invalid for this operation because it has no Range specified");
-        if (target.locations.size() > 1)
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate ambiguity. SequenceAnnotation " + target.identity.get() + " is invalid for this operation because it has more than one Range specified");
-        sbol::Range& r_target = (sbol::Range&)target.locations[0];
-    //    cout << r_target.start.get() << "\t" << r_target.end.get() << "\t";
-        
-        for (auto &p_qc : qc_annotations)
+        vector < QCCounts > F(queries.size());
+        QCCounts slope = {};
+        QCCounts value = {};
+        long long x = queries.size() ? queries.front().first : 0;
+        if (events.size())
+            x = min(x, events.front().x);
+        auto advance = [&](long long x_next)
         {
-            SequenceAnnotation& qc = *p_qc;
-            if (qc.locations.size() == 0)
-                throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate ambiguity. SequenceAnnotation " + qc.identity.get() + " is invalid for this operation because it has no Range specified");
-            if (qc.locations.size() > 1)
-                throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate ambiguity. A SequenceAnnotation " + qc.identity.get() + " is invalid for this operation because it has more than one Range specified");
-            sbol::Range& r_qc = (sbol::Range&)qc.locations[0];
-    //        cout << r_qc.start.get() << "\t" << r_qc.end.get();
-            
-            
-            string qc_classification = qc.roles.get();
-            if (qc_classification.compare(SO_POSSIBLE_ASSEMBLY_ERROR) == 0)
+            for (int i = 0; i < N_QC_CLASSIFICATIONS; ++i)
+                value[i] += slope[i] * (x_next - x);
+            x = x_next;
+        };
+        auto i_event = events.begin();
+        for (auto & query : queries)
+        {
+            for (; i_event != events.end() && i_event->x < query.first; ++i_event)
             {
-                n_ambiguous += r_target.contains(r_qc) + r_target.overlaps(r_qc);
-    //            cout << SO_POSSIBLE_ASSEMBLY_ERROR << "\n\t\t";
+                advance(i_event->x);
+                slope[i_event->classification] += i_event->delta;
             }
-    //        else
-    //            cout << "\n\t\t";
+            advance(query.first);
+            F[query.second] = value;
         }
-    //    cout << "\n";
-        return (float)n_ambiguous / (float)r_target.length();
-    };
 
-    float calculateCoverage(SequenceAnnotation& target, vector<SequenceAnnotation*> qc_annotations)
-    {
-        return calculateIdentity(target, qc_annotations) + calculateError(target, qc_annotations) + calculateAmbiguity(target, qc_annotations);
+        vector < QCCounts > counts(regions.size());
+        for (size_t i_region = 0; i_region < regions.size(); ++i_region)
+            for (int i = 0; i < N_QC_CLASSIFICATIONS; ++i)
+                counts[i_region][i] = F[2 * i_region + 1][i] - F[2 * i_region][i];
+        return counts;
     };
 
     void get_sequence_annotation_callback(ComponentDefinition* cdef_node, void * user_data)
@@ -1057,95 +1083,105 @@ namespace sbol
             cumulative_annotations.insert(cumulative_annotations.end(), annotations.begin(), annotations.end());
         }
     };
-    
-    std::unordered_map < std::string, std::tuple < int, int, float > > reportQC(ComponentDefinition& target, ComponentDefinition& construct, float (*qc_method)(SequenceAnnotation&, vector<SequenceAnnotation*>))
+
+    std::unordered_map < std::string, std::tuple < int, int, float > > project_qc_report(const std::unordered_map < std::string, QCStatistics >& report, float QCStatistics::*statistic)
+    {
+        std::unordered_map < std::string, std::tuple < int, int, float > > qc_report;
+        for (auto & i_region : report)
+            qc_report[i_region.first] = std::make_tuple(i_region.second.start, i_region.second.end, i_region.second.*statistic);
+        return qc_report;
+    };
+
+    // The regions of a target design which are reported on, in the order they are reported
+    struct QCTargets
     {
-        std::unordered_map < std::string, std::tuple < int, int, float > > qc_report;  // Maps the URI of the ComponentDefinition to its qc statistic and its start and end coordinates
+        vector < string > uris;
+        vector < pair < int, int > > regions;
+    };
 
+    // Report on SequenceAnnotations which locate a subcomponent, or which have a role, under the URI of the corresponding ComponentDefinition, and on the target as a whole
+    void collect_qc_targets(ComponentDefinition& target, QCTargets& targets)
+    {
         vector<SequenceAnnotation*> target_annotations;
-        vector<SequenceAnnotation*> qc_annotations;
 
         // Recursively gather all sub-Components through their SequenceAnnotation
         target.applyToComponentHierarchy(get_sequence_annotation_callback, &target_annotations);
-        construct.applyToComponentHierarchy(get_sequence_annotation_callback, &qc_annotations);
-        
         if (Config::getOption("verbose") == "True")
         {
             std::cout << "Generating QC report..." << std::endl;
             std::cout << "Found " << target_annotations.size() << " target annotations" << std::endl;
-            std::cout << "Found " << qc_annotations.size() << " QC annotations" << std::endl;
         }
-        
+
         for (auto &ann_target : target_annotations)
         {
             ComponentDefinition& parent_cdef = (ComponentDefinition&)*ann_target->parent;
             if (ann_target->locations.size() > 0)
             {
-                sbol::Range& r = (sbol::Range&)ann_target->locations[0];
                 // Skip over SequenceAnnotations that do not have a corresponding Component
                 if (ann_target->component.size())
                 {
                     Component& c = parent_cdef.components[ann_target->component.get()];
                     ComponentDefinition& cdef = ann_target->doc->get<ComponentDefinition>(c.definition.get());
-                    
-                    float qc_statistic = qc_method(*ann_target, qc_annotations);
-                    std::tuple < int, int, float > qc = std::make_tuple(r.start.get(), r.end.get(), qc_statistic);
-                    qc_report[ cdef.identity.get() ] = qc;
-                    
-                }
-                else if(ann_target->roles.size() > 0)
-                {
-                    float qc_statistic = qc_method(*ann_target, qc_annotations);
-                    std::tuple < int, int, float > qc = std::make_tuple(r.start.get(), r.end.get(), qc_statistic);
-                    qc_report[ parent_cdef.identity.get() ] = qc;
+                    targets.uris.push_back(cdef.identity.get());
                 }
+                else if (ann_target->roles.size() > 0)
+                    targets.uris.push_back(parent_cdef.identity.get());
+                else
+                    continue;
+                sbol::Range& r = get_qc_range(*ann_target);
+                targets.regions.push_back({ r.start.get(), r.end.get() });
             }
         }
-        
+
         // Calculate cumulative statistics at the highest level of the component hierarchy.
         Sequence& target_seq = target.doc->get<Sequence>(target.sequence.get());
-        SequenceAnnotation target_sa = SequenceAnnotation("temporary");
-        Range& r = target_sa.locations.create<Range>("r");
-        r.start.set(1);
-        r.end.set(target_seq.elements.get().size());
-        float qc_statistic = qc_method(target_sa, qc_annotations);
-        std::tuple < int, int, float > qc = std::make_tuple(r.start.get(), r.end.get(), qc_statistic);
-        qc_report[ target.identity.get() ] = qc;
-        return qc_report;
+        targets.uris.push_back(target.identity.get());
+        targets.regions.push_back({ 1, (int)target_seq.elements.get().size() });
     };
-    
-    
-    std::unordered_map < std::string, std::tuple < int, int, float > > Analysis::reportIdentity()
+
+    // Gather the QC annotations anywhere in the hierarchy of the construct
+    void collect_qc_ranges(ComponentDefinition& construct, vector < tuple < int, int, int > >& qc_ranges)
     {
-        if (!doc)
-            throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot generate QC report. Analysis " + identity.get() + " does not belong to a Document");
+        vector<SequenceAnnotation*> qc_annotations;
+        construct.applyToComponentHierarchy(get_sequence_annotation_callback, &qc_annotations);
+        if (Config::getOption("verbose") == "True")
+            std::cout << "Found " << qc_annotations.size() << " QC annotations" << std::endl;
 
-        // Retrieve Design by following links back through Analysis
-        if (!rawData.size() || !doc->tests.find(rawData.get()))
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report because the Analysis is not linked to a Test. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
-        
-        Test& test = doc->get<Test>(rawData.get());
-        if (!test.samples.size() || !doc->builds.find(test.samples.get()) )
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report because the Analysis is not linked to a Build. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
-        
-        Build& build = doc->get<Build>(test.samples.get());
-        if (!build.design.size() || !doc->designs.find(build.design.get()))
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report because the Analysis is not linked to a Design. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
+        qc_ranges.reserve(qc_ranges.size() + qc_annotations.size());
+        for (auto &ann_qc : qc_annotations)
+        {
+            sbol::Range& r = get_qc_range(*ann_qc);
+            int classification = classify_qc_annotation(ann_qc->roles.size() ? ann_qc->roles.get() : "");
+            if (classification >= 0)
+                qc_ranges.push_back(std::make_tuple(r.start.get(), r.end.get(), classification));
+        }
+    };
 
-        Design& design = doc->get<Design>(build.design.get());
-        
-        if (!design.structure.size())
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report, because the structure property of the Design is unspecified.");
-        ComponentDefinition& target = design.structure.get();
-        
-        if (!build.structure.size())
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report, because the structure property of the Build is unspecified.");
-        ComponentDefinition& construct = build.structure.get();
+    std::unordered_map < std::string, QCStatistics > compile_qc_report(const QCTargets& targets, const vector < tuple < int, int, int > >& qc_ranges)
+    {
+        vector < QCCounts > counts = count_qc_bases(targets.regions, qc_ranges);
 
-        return ::reportQC(target, construct, &::calculateIdentity);
+        // Later regions take precedence when a ComponentDefinition is annotated more than once
+        std::unordered_map < std::string, QCStatistics > qc_report;
+        for (size_t i_region = 0; i_region < targets.regions.size(); ++i_region)
+        {
+            int start = targets.regions[i_region].first;
+            int end = targets.regions[i_region].second;
+            int length = end + 1 - start;
+            const QCCounts& n = counts[i_region];
+            QCStatistics statistics;
+            statistics.start = start;
+            statistics.end = end;
+            statistics.identity = (float)n[QC_MATCH] / (float)length;
+            statistics.error = (float)(n[QC_SUBSTITUTION] + n[QC_DELETION] + n[QC_INSERTION]) / (float)(length + n[QC_INSERTION]);
+            statistics.ambiguity = (float)n[QC_AMBIGUOUS] / (float)length;
+            statistics.coverage = statistics.identity + statistics.error + statistics.ambiguity;
+            qc_report[targets.uris[i_region]] = statistics;
+        }
+        return qc_report;
     };
-    
-    std::unordered_map < std::string, std::tuple < int, int, float > > Analysis::reportError()
+
+    std::unordered_map < std::string, QCStatistics > Analysis::reportQC()
     {
         if (!doc)
             throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot generate QC report. Analysis " + identity.get() + " does not belong to a Document");
@@ -1172,69 +1208,141 @@ namespace sbol
             throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report, because the structure property of the Build is unspecified.");
         ComponentDefinition& construct = build.structure.get();
 
-        return ::reportQC(target, construct, &::calculateError);
+        QCTargets targets;
+        collect_qc_targets(target, targets);
+        vector < tuple < int, int, int > > qc_ranges;
+        collect_qc_ranges(construct, qc_ranges);
+        return compile_qc_report(targets, qc_ranges);
+    };
+    
+    std::unordered_map < std::string, std::tuple < int, int, float > > Analysis::reportIdentity()
+    {
+        return project_qc_report(reportQC(), &QCStatistics::identity);
+    };
+    
+    std::unordered_map < std::string, std::tuple < int, int, float > > Analysis::reportError()
+    {
+        return project_qc_report(reportQC(), &QCStatistics::error);
     };
     
     std::unordered_map < std::string, std::tuple < int, int, float > > Analysis::reportCoverage()
     {
-        if (!doc)
-            throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot generate QC report. Analysis " + identity.get() + " does not belong to a Document");
-
-        // Retrieve Design by following links back through Analysis
-        if (!rawData.size() || !doc->tests.find(rawData.get()))
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report because the Analysis is not linked to a Test. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
-        
-        Test& test = doc->get<Test>(rawData.get());
-        if (!test.samples.size() || !doc->builds.find(test.samples.get()) )
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report because the Analysis is not linked to a Build. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
-        
-        Build& build = doc->get<Build>(test.samples.get());
-        if (!build.design.size() || !doc->designs.find(build.design.get()))
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report because the Analysis is not linked to a Design. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
-
-        Design& design = doc->get<Design>(build.design.get());
-        
-        if (!design.structure.size())
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report, because the structure property of the Design is unspecified.");
-        ComponentDefinition& target = design.structure.get();
-        
-        if (!build.structure.size())
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report, because the structure property of the Build is unspecified.");
-        ComponentDefinition& construct = build.structure.get();
-
-        return ::reportQC(target, construct, &::calculateCoverage);
+        return project_qc_report(reportQC(), &QCStatistics::coverage);
     };
     
     std::unordered_map < std::string, std::tuple < int, int, float > > Analysis::reportAmbiguity()
     {
-        if (!doc)
-            throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot generate QC report. Analysis " + identity.get() + " does not belong to a Document");
+        return project_qc_report(reportQC(), &QCStatistics::ambiguity);
+    };
 
-        // Retrieve Design by following links back through Analysis
-        if (!rawData.size() || !doc->tests.find(rawData.get()))
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report because the Analysis is not linked to a Test. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
-        
-        Test& test = doc->get<Test>(rawData.get());
-        if (!test.samples.size() || !doc->builds.find(test.samples.get()) )
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report because the Analysis is not linked to a Build. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
-        
-        Build& build = doc->get<Build>(test.samples.get());
-        if (!build.design.size() || !doc->designs.find(build.design.get()))
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report because the Analysis is not linked to a Design. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
+    std::vector < std::unordered_map < std::string, QCStatistics > > Analysis::verifyTargets(std::vector < Analysis* > analyses, std::vector < Sequence* > consensus_sequences, int threads)
+    {
+        SBOL_STATS_TIMER("verify_targets");
+        if (analyses.size() != consensus_sequences.size())
+            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot verify targets. Each Analysis must be paired with one consensus Sequence.");
+        if (analyses.empty())
+            return {};
 
-        Design& design = doc->get<Design>(build.design.get());
-        
-        if (!design.structure.size())
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report, because the structure property of the Design is unspecified.");
-        ComponentDefinition& target = design.structure.get();
-        
-        if (!build.structure.size())
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report, because the structure property of the Build is unspecified.");
-        ComponentDefinition& construct = build.structure.get();
+        // Resolve every Analysis and validate the inputs before the Document is modified, so that the batch is committed whole or not at all
+        vector < VerificationTarget > verifications;
+        verifications.reserve(analyses.size());
+        unordered_map < SBOLObject*, size_t > first_use;
+        for (size_t i = 0; i < analyses.size(); ++i)
+        {
+            if (!analyses[i] || !consensus_sequences[i])
+                throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot verify targets. The batch contains a null Analysis or Sequence.");
+            verifications.push_back(resolve_verification_target(*analyses[i], *consensus_sequences[i]));
+            for (SBOLObject* obj : { (SBOLObject*)analyses[i], (SBOLObject*)consensus_sequences[i], (SBOLObject*)verifications.back().build })
+                if (!first_use.emplace(obj, i).second)
+                    throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot verify targets. " + obj->identity.get() + " is used by more than one Analysis in the batch.");
+        }
+
+        // Gather the report inputs which live in the Document. Target designs shared by several Analyses are traversed once.
+        // A Build structure that has yet to be constructed contributes no prior QC annotations
+        unordered_map < ComponentDefinition*, QCTargets > targets;
+        vector < vector < tuple < int, int, int > > > qc_ranges(analyses.size());
+        vector < string > verified_sequences(analyses.size());
+        for (size_t i = 0; i < analyses.size(); ++i)
+        {
+            ComponentDefinition* design_structure = verifications[i].design_structure;
+            if (!targets.count(design_structure))
+                collect_qc_targets(*design_structure, targets[design_structure]);
+            Build& build = *verifications[i].build;
+            if (build.structure.size())
+                collect_qc_ranges(build.structure.get(), qc_ranges[i]);
+            verified_sequences[i] = consensus_sequences[i]->elements.get();
+        }
 
-        return ::reportQC(target, construct, &::calculateAmbiguity);
+        // Scan alignments and compile reports in parallel. Workers touch nothing but their own scanner and the slots of the Analyses they claim
+        vector < vector < QCRegion > > qc_regions(analyses.size());
+        vector < std::unordered_map < std::string, QCStatistics > > reports(analyses.size());
+        vector < exception_ptr > errors(analyses.size());
+        atomic < size_t > i_next(0);
+        auto work = [&]()
+        {
+            SBOL_STATS_TIMER("verify_scan");
+            AlignmentScanner alignment;
+            for (size_t i = i_next++; i < analyses.size(); i = i_next++)
+            {
+                try
+                {
+                    scan_qc_regions(alignment, verifications[i].target_sequence, verified_sequences[i], qc_regions[i]);
+                    for (auto & region : qc_regions[i])
+                        qc_ranges[i].push_back(std::make_tuple(region.start, region.end, region.classification));
+                    reports[i] = compile_qc_report(targets.at(verifications[i].design_structure), qc_ranges[i]);
+                }
+                catch (...)
+                {
+                    errors[i] = current_exception();
+                }
+            }
+        };
+        if (threads <= 0)
+            threads = max(1u, thread::hardware_concurrency());
+        threads = (int)min((size_t)threads, analyses.size());
+        vector < thread > workers;
+        for (int i_thread = 1; i_thread < threads; ++i_thread)
+            workers.push_back(thread(work));
+        work();
+        for (auto & worker : workers)
+            worker.join();
+        for (auto & error : errors)
+            if (error)
+                rethrow_exception(error);
+
+        // Commit the results in the order the Analyses were given, as the equivalent series of verifyTarget calls would.
+        // The Analyses may belong to different Documents. Each Document gets one BulkInsert scope, so URIs are checked for
+        // uniqueness once rather than once per Analysis, within a transaction that is rolled back if any part of the batch fails
+        SBOL_STATS_TIMER("verify_commit");
+        vector < Document* > docs;
+        for (auto & analysis : analyses)
+            if (std::find(docs.begin(), docs.end(), analysis->doc) == docs.end())
+                docs.push_back(analysis->doc);
+        size_t n_transactions = 0;
+        try
+        {
+            for (; n_transactions < docs.size(); ++n_transactions)
+                docs[n_transactions]->beginTransaction();
+            vector < unique_ptr < BulkInsert > > bulk_inserts;
+            for (auto & doc : docs)
+                bulk_inserts.push_back(unique_ptr < BulkInsert >(new BulkInsert(*doc)));
+            for (size_t i = 0; i < analyses.size(); ++i)
+            {
+                ComponentDefinition& build_structure = attach_consensus_sequence(*analyses[i], *verifications[i].build, *consensus_sequences[i]);
+                create_qc_annotations(build_structure, verifications[i].target_sequence, verified_sequences[i], qc_regions[i]);
+            }
+            for (auto & bulk_insert : bulk_inserts)
+                bulk_insert->commit();
+        }
+        catch (...)
+        {
+            for (size_t i_doc = 0; i_doc < n_transactions; ++i_doc)
+                docs[i_doc]->rollback();
+            throw;
+        }
+        for (auto & doc : docs)
+            doc->commit();
+        return reports;
     };
-    
-    
-    
+
 };
@@ -122,7 +122,7 @@ namespace sbol
             sysbio_type(this, SYSBIO_URI "#type", '1', '1', ValidationRules({}), SYSBIO_BUILD)
         {
             // Overwrite the typed URI formed by base constructor by replacing Implementation with Build
-            if  (Config::getOption("sbol_compliant_uris") == "True")
+            if  (!DeserializationScope::active() && Config::getOption("sbol_compliant_uris") == "True")
             {
                 displayId.set(uri);
                 if (Config::getOption("sbol_typed_uris") == "True")
@@ -150,7 +150,7 @@ namespace sbol
             sysbio_type(this, SYSBIO_URI "#type", '1', '1', ValidationRules({}), SYSBIO_BUILD)
         {
             // Overwrite the typed URI formed by base constructor by replacing Implementation with Build
-            if  (Config::getOption("sbol_compliant_uris") == "True")
+            if  (!DeserializationScope::active() && Config::getOption("sbol_compliant_uris") == "True")
             {
                 displayId.set(uri);
                 if (Config::getOption("sbol_typed_uris") == "True")
@@ -210,7 +210,7 @@ namespace sbol
             sysbio_type(this, SYSBIO_URI "#type", '1', '1', ValidationRules({}), SYSBIO_TEST)
         {
             // Overwrite the typed URI formed by base constructor by replacing Collection with Test
-            if  (Config::getOption("sbol_compliant_uris").compare("True") == 0)
+            if  (!DeserializationScope::active() && Config::getOption("sbol_compliant_uris").compare("True") == 0)
             {
                 if (Config::getOption("sbol_typed_uris") == "True")
                 {
@@ -233,6 +233,17 @@ namespace sbol
     template<>
     Test& TopLevel::generate<Test>(std::string uri, Agent& agent, Plan& plan, std::vector < Identified* > usages);
 
+    /// Quality-control statistics for one region of a target design, compiled by Analysis::reportQC
+    struct QCStatistics
+    {
+        int start;          ///< Start coordinate of the region in the target Sequence
+        int end;            ///< End coordinate of the region in the target Sequence
+        float identity;     ///< Fraction of bases in the region that match the consensus Sequence
+        float error;        ///< Substitutions, deletions and insertions per base of the region, including inserted bases
+        float ambiguity;    ///< Fraction of bases in the region that could not be resolved in the consensus Sequence
+        float coverage;     ///< The sum of identity, error and ambiguity
+    };
+
     class Analysis : public TopLevel
     {
     friend class Document;
@@ -273,7 +284,18 @@ namespace sbol
         
         /// Compare a consensus Sequence to the target Sequence
         void verifyTarget(Sequence& consensus_sequence);
-        
+
+        /// Compare a batch of consensus Sequences to their target Sequences. Alignments are scanned and QC reports compiled on parallel worker threads, then the consensus Sequences and QC annotations are committed serially. The Analyses may belong to different Documents. Each Document ends up exactly as it would after calling verifyTarget on each Analysis in turn. If the batch fails, no Document is changed
+        /// @param analyses The Analyses to verify. No two may verify the same Build
+        /// @param consensus_sequences The consensus Sequence for each Analysis, in the same order. The Analyses take ownership of them
+        /// @param threads The number of worker threads, or 0 to use one per hardware thread
+        /// @return The QC report for each Analysis, the same as reportQC would return once the batch is committed
+        static std::vector < std::unordered_map < std::string, QCStatistics > > verifyTargets(std::vector < Analysis* > analyses, std::vector < Sequence* > consensus_sequences, int threads = 0);
+
+        /// Compile identity, error, ambiguity and coverage statistics for the target design and each of its subcomponents in a single pass over the QC annotations added by verifyTarget
+        /// @return A table mapping the URI of each ComponentDefinition in the target design to its statistics
+        std::unordered_map < std::string, QCStatistics > reportQC();
+
         std::unordered_map < std::string, std::tuple < int, int, float > > reportIdentity();
 
         std::unordered_map < std::string, std::tuple < int, int, float > > reportError();
@@ -315,7 +337,7 @@ namespace sbol
             sysbio_type(this, SYSBIO_URI "#type", '1', '1', ValidationRules({}), SYSBIO_URI "#SampleRoster")
         {
             // Overwrite the typed URI formed by base constructor by replacing Collection with Test
-            if  (Config::getOption("sbol_compliant_uris").compare("True") == 0)
+            if  (!DeserializationScope::active() && Config::getOption("sbol_compliant_uris").compare("True") == 0)
             {
                 if (Config::getOption("sbol_typed_uris") == "True")
                 {
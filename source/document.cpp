@@ -25,6 +25,7 @@
 
 
 #include "document.h"
+#include "dbtl.h"
 
 #include <raptor2.h>
 #include <json/json.h>
@@ -51,47 +52,44 @@ using namespace std;
 
 void Document::parse_extension_objects()
 {
-    // Look in Implementation store for objects with sys-bio:type and move them to Build store
-    vector<SBOLObject*>& implementation_store = owned_objects[SBOL_IMPLEMENTATION];
-    vector<SBOLObject*>& build_store = owned_objects[SYSBIO_BUILD];
-    implementation_store.erase( std::remove_if(implementation_store.begin(), implementation_store.end(), [&](SBOLObject* i)
-        {
-            if (i->properties.find(SYSBIO_URI "#type") != i->properties.end() && i->properties[SYSBIO_URI "#type"].front() == "<" SYSBIO_BUILD ">")
-            {
-                build_store.push_back(i);
-                return true;
-            }
-            return false;
-        }), implementation_store.end());
-
-    // Look in Collection store for objects with sys-bio:type and move them to Test store
-    vector<SBOLObject*>& collection_store = owned_objects[SBOL_COLLECTION];
-    vector<SBOLObject*>& test_store = owned_objects[SYSBIO_TEST];
-    collection_store.erase( std::remove_if(collection_store.begin(), collection_store.end(), [&](SBOLObject* c)
-        {
-            if (c->properties.find(SYSBIO_URI "#type") != c->properties.end() && c->properties[SYSBIO_URI "#type"].front() == "<" SYSBIO_TEST ">")
-            {
-                test_store.push_back(c);
-                return true;
-            }
-            return false;
-        }), collection_store.end());
-
-    // Look in Collection store for objects with sys-bio:type and move them to SampleRoster store
-    vector<SBOLObject*>& roster_store = owned_objects[SYSBIO_URI "#SampleRoster"];
-    collection_store.erase( std::remove_if(collection_store.begin(), collection_store.end(), [&](SBOLObject* c)
+    SBOL_STATS_TIMER("parse_extension_objects");
+    // sys-bio classes, eg, Build, Test and SampleRoster, are serialized as their SBOL base class with a sys-bio:type. Map each base class store
+    // to the sys-bio:type values found in it and the store each value belongs in
+    unordered_map<string, unordered_map<string, string>> extension_stores;
+    for (int id = 0; id < ClassRegistry::size(); ++id)
+    {
+        const ClassTraits& traits = ClassRegistry::get(id);
+        if (traits.discriminator != "" && ClassRegistry::bases(id).size())
         {
-            if (c->properties.find(SYSBIO_URI "#type") != c->properties.end() && c->properties[SYSBIO_URI "#type"].front() == "<" SYSBIO_SAMPLE_ROSTER ">")
+            const ClassTraits& base = ClassRegistry::get(ClassRegistry::bases(id).front());
+            extension_stores[base.store]["<" + traits.discriminator + ">"] = traits.store;
+        }
+    }
+    for (auto &i_base_store : extension_stores)
+    {
+        auto i_store = owned_objects.find(i_base_store.first);
+        if (i_store == owned_objects.end())
+            continue;
+        vector<SBOLObject*>& base_store = i_store->second;
+        base_store.erase( std::remove_if(base_store.begin(), base_store.end(), [&](SBOLObject* obj)
             {
-                roster_store.push_back(c);
+                auto i_type = obj->properties.find(SYSBIO_URI "#type");
+                if (i_type == obj->properties.end() || i_type->second.empty())
+                    return false;
+                auto i_extension_store = i_base_store.second.find(i_type->second.front());
+                if (i_extension_store == i_base_store.second.end())
+                    return false;
+                owned_objects[i_extension_store->second].push_back(obj);
                 return true;
-            }
-            return false;
-        }), collection_store.end());
+            }), base_store.end());
+    }
 };
 
 Document::~Document()
 {
+    release_frozen();
+    release_transactions();
+    release_observers();
     for (auto i_obj = SBOLObjects.begin(); i_obj != SBOLObjects.end(); ++i_obj)
     {
         SBOLObject* obj = i_obj->second;
@@ -99,38 +97,8 @@ Document::~Document()
     }
 };
 
-unordered_map<string, SBOLObject&(*)()> sbol::SBOL_DATA_MODEL_REGISTER =
-{
-    // Typecast proxy constructors to a constructor for SBOL
-    // This makes some ugly syntax, but library users should never see it.
-    make_pair(UNDEFINED, &create<SBOLObject>),
-    make_pair(SBOL_COMPONENT_DEFINITION, (SBOLObject&(*)()) &create<ComponentDefinition>),
-    make_pair(SBOL_SEQUENCE_ANNOTATION, (SBOLObject&(*)()) &create<SequenceAnnotation>),
-    make_pair(SBOL_SEQUENCE, (SBOLObject&(*)()) &create<Sequence>),
-    make_pair(SBOL_COMPONENT, (SBOLObject&(*)()) &create<Component>),
-    make_pair(SBOL_FUNCTIONAL_COMPONENT, (SBOLObject&(*)()) &create<FunctionalComponent>),
-    make_pair(SBOL_MODULE_DEFINITION, (SBOLObject&(*)()) &create<ModuleDefinition>),
-    make_pair(SBOL_MODULE, (SBOLObject&(*)()) &create<Module>),
-    make_pair(SBOL_INTERACTION, (SBOLObject&(*)()) &create<Interaction>),
-    make_pair(SBOL_PARTICIPATION, (SBOLObject&(*)()) &create<Participation>),
-    make_pair(SBOL_MODEL, (SBOLObject&(*)()) &create<Model>),
-    make_pair(SBOL_SEQUENCE_CONSTRAINT, (SBOLObject&(*)()) &create<SequenceConstraint>),
-    make_pair(SBOL_RANGE, (SBOLObject&(*)()) &create<Range>),
-    make_pair(SBOL_MAPS_TO, (SBOLObject&(*)()) &create<MapsTo>),
-    make_pair(SBOL_CUT, (SBOLObject&(*)()) &create<Cut>),
-    make_pair(SBOL_COLLECTION, (SBOLObject&(*)()) &create<Collection>),
-    make_pair(SBOL_GENERIC_LOCATION, (SBOLObject&(*)()) &create<GenericLocation>),
-    make_pair(PROVO_PLAN, (SBOLObject&(*)()) &create<Plan>),
-    make_pair(PROVO_ACTIVITY, (SBOLObject&(*)()) &create<Activity>),
-    make_pair(PROVO_AGENT, (SBOLObject&(*)()) &create<Agent> ),
-    make_pair(PROVO_USAGE, (SBOLObject&(*)()) &create<Usage> ),
-    make_pair(SBOL_ATTACHMENT, (SBOLObject&(*)()) &create<Attachment>),
-    make_pair(SBOL_COMBINATORIAL_DERIVATION, (SBOLObject&(*)()) &create<CombinatorialDerivation> ),
-    make_pair(SBOL_IMPLEMENTATION, (SBOLObject&(*)()) &create<Implementation> ),
-    make_pair(SYSBIO_DESIGN, (SBOLObject&(*)()) &create<Design> ),
-    make_pair(SYSBIO_ANALYSIS, (SBOLObject&(*)()) &create<Analysis> ),
-    make_pair(SYSBIO_SAMPLE_ROSTER, (SBOLObject&(*)()) &create<SampleRoster> )
-};
+// The constructors of the classes registered with the ClassRegistry. Extension classes are added by SBOLObject::register_extension_class
+unordered_map<string, SBOLObject&(*)()> sbol::SBOL_DATA_MODEL_REGISTER = ClassRegistry::constructors();
 
 
 void sbol::seek_element(std::istringstream& xml_buffer, std::string uri)
@@ -539,13 +507,15 @@ void Document::parse_objects(void* user_data, raptor_statement* triple)
 //                std::cout << "Skipping object: " << subject << "\t" << predicate << "\t" << object << std::endl;
 //        }
         // Instantiate Python extension objects
-        if ((!doc->find(subject)) && (doc->PythonObjects.count(subject) == 0) && (Config::PYTHON_DATA_MODEL_REGISTER.count(object) == 1))
+        if ((doc->SBOLObjects.count(subject) == 0) && (doc->existing_children.count(subject) == 0) && (doc->PythonObjects.count(subject) == 0) && (Config::PYTHON_DATA_MODEL_REGISTER.count(object) == 1))
         {
             PyObject* constructor = Config::PYTHON_DATA_MODEL_REGISTER[object];
 
 //            PyObject* py_obj = PyObject_CallFunction(constructor, (char *)"s", subject.c_str());
+            PyGILState_STATE gil_state = PyGILState_Ensure();  // The Python wrapper releases the GIL while reading
             PyObject* py_obj = PyObject_CallFunction(constructor, NULL);
             SwigPyObject* swig_py_object = (SwigPyObject*)PyObject_GetAttr(py_obj, PyUnicode_FromString("this"));
+            PyGILState_Release(gil_state);
             SBOLObject* new_obj = (SBOLObject *)swig_py_object->ptr;
             
             // Wipe default property values passed from default constructor. New property values will be added as properties are parsed from the input file
@@ -574,29 +544,17 @@ void Document::parse_objects(void* user_data, raptor_statement* triple)
             
             doc->PythonObjects[subject] = py_obj;
             //Py_DECREF(py_obj); // Clean up
+            SBOL_STATS_COUNT("objects_created", 1);
         }
         else
 #endif
         // Checks if the object has already been created and whether a constructor for this type of object exists
-        if ((!doc->find(subject)) && (doc->SBOLObjects.count(subject) == 0) && (SBOL_DATA_MODEL_REGISTER.count(object) == 1))
+        const ClassTraits* traits = ClassRegistry::find(object);
+        if ((doc->SBOLObjects.count(subject) == 0) && (doc->existing_children.count(subject) == 0) && traits)
 		{
-            SBOLObject& new_obj = SBOL_DATA_MODEL_REGISTER[ object ]();  // Call constructor for the appropriate SBOLObject
-
-			// Wipe default property values passed from default constructor. New property values will be added as properties are parsed from the input file
-			for (auto it = new_obj.properties.begin(); it != new_obj.properties.end(); it++)
-			{
-				std::string token = it->second.front();
-				if (token[0] == '<')  // clear defaults and re-initialize this property as a URI
-				{
-					new_obj.properties[it->first].clear();
-					new_obj.properties[it->first].push_back("<>");
-				} 
-				else if (token[0] == '"')  // clear defaults and re-initialize as a literal
-				{
-					new_obj.properties[it->first].clear();
-					new_obj.properties[it->first].push_back("\"\"");
-				}
-			}
+            // Call constructor for the appropriate SBOLObject. The parser holds a DeserializationScope open, so the new object's properties
+            // contain only empty "<>" and "\"\"" slots, which are filled as properties are parsed from the input file
+            SBOLObject& new_obj = traits->constructor();
 			new_obj.identity.set(subject);
 
 			// All created objects are placed in the document's object store.  However, only toplevel objects will be left permanently.
@@ -606,12 +564,12 @@ void Document::parse_objects(void* user_data, raptor_statement* triple)
             new_obj.doc = doc;  //  Set's the objects back-pointer to the parent Document
             
             // If the new object is TopLevel, add to the Document's property store
-            TopLevel* check_top_level = dynamic_cast<TopLevel*>(&new_obj);
-            if (check_top_level)
-                doc->owned_objects[new_obj.type].push_back(&new_obj);  // Adds objects to the Document's property store, eg, componentDefinitions, moduleDefinitions, etc
+            if (traits->is_toplevel)
+                doc->owned_objects[traits->store].push_back(&new_obj);  // Adds objects to the Document's property store, eg, componentDefinitions, moduleDefinitions, etc
+            SBOL_STATS_COUNT("objects_created", 1);
 		}
         // Generic TopLevels
-        else if ((!doc->find(subject)) && (doc->SBOLObjects.count(subject) == 0) && (SBOL_DATA_MODEL_REGISTER.count(object) == 0))
+        else if ((doc->SBOLObjects.count(subject) == 0) && (doc->existing_children.count(subject) == 0) && !traits)
         {
             SBOLObject& new_obj = *new SBOLObject();  // Call constructor for the appropriate SBOLObject
             new_obj.identity.set(subject);
@@ -620,6 +578,7 @@ void Document::parse_objects(void* user_data, raptor_statement* triple)
             // Owned objects are kept in the object store as a temporary convenience and will be removed later by the parse_properties handler.
             doc->SBOLObjects[new_obj.identity.get()] = &new_obj;
             new_obj.doc = doc;  //  Set's the objects back-pointer to the parent Document
+            SBOL_STATS_COUNT("objects_created", 1);
         }
 	}
 
@@ -637,6 +596,7 @@ void Document::parse_properties(void* user_data, raptor_statement* triple)
 	string property_uri = predicate.substr(1, predicate.length() - 2);  // Removes flanking < and > from uri
 	//string property_value = object.substr(1, object.length() - 2);  // Removes flanking " from literal
 	string property_value = convert_ntriples_encoding_to_ascii(object);
+    SBOL_STATS_COUNT("triples_parsed", 1);
     std::size_t found = property_uri.find_last_of('#');
     if (found == std::string::npos)
     {
@@ -700,25 +660,55 @@ void Document::parse_properties(void* user_data, raptor_statement* triple)
                 {
 //                    cout << "Setting " << property_uri << " of " << id << " to " << property_value << endl;
                     sbol_obj->properties[property_uri].push_back(property_value);
+                }
+                // Remember references to generic annotation objects, which parse_annotation_objects nests in the referring object
+                if (property_value[0] == '<' && sbol_obj->owned_objects.find(property_uri) == sbol_obj->owned_objects.end())
+                {
+                    auto i_ref = doc->SBOLObjects.find(property_value.substr(1, property_value.length() - 2));
+                    if (i_ref != doc->SBOLObjects.end() && i_ref->second != sbol_obj && !ClassRegistry::find(i_ref->second->type))
+                        doc->annotation_references[i_ref->first].push_back({ sbol_obj, property_uri });
                 }
 			}
 		}
 	}
 };
 
+void Document::collect_existing_children()
+{
+    existing_children.clear();
+    vector<SBOLObject*> stack;
+    for (auto &i_obj : SBOLObjects)
+        stack.push_back(i_obj.second);
+    while (stack.size())
+    {
+        SBOLObject* obj = stack.back();
+        stack.pop_back();
+        for (auto &i_store : obj->owned_objects)
+            for (auto &child : i_store.second)
+            {
+                existing_children.insert(child->identity.get());
+                stack.push_back(child);
+            }
+    }
+}
+
 void Document::parse_annotation_objects()
 {
+    SBOL_STATS_TIMER("parse_annotation_objects");
     // Check if there are any SBOLObjects remaining in the Document's object store which are not recognized as part of the core data model or an explicitly declared extension class
     vector < SBOLObject* > annotation_objects = {};
     for (auto &i_obj : SBOLObjects)
     {
         SBOLObject* obj = i_obj.second;
-        if (!dynamic_cast<TopLevel*>(obj))           // If an object can't be cast to TopLevel then it must be a generic annotation object
+        const ClassTraits* traits = ClassRegistry::find(obj->type);
+        bool is_toplevel = traits ? traits->is_toplevel : (dynamic_cast<TopLevel*>(obj) != NULL);  // Python extension classes are not registered
+        if (!is_toplevel)           // If an object isn't TopLevel then it must be a generic annotation object
             annotation_objects.push_back(obj);
     }
+    // Objects with a persistentIdentity are generic TopLevels. These are converted first, so that annotation objects nested in them are attached to the converted object
+    unordered_map<SBOLObject*, SBOLObject*> converted;
     for (auto &obj : annotation_objects)
     {
-        // Check if this annotation object is a generic TopLevel
         if (obj->properties.find(SBOL_PERSISTENT_IDENTITY) != obj->properties.end())
         {
             // Copy to a new TopLevel object
@@ -726,44 +716,47 @@ void Document::parse_annotation_objects()
             for (auto &i_p : obj->properties)
                 tl->properties[i_p.first] = i_p.second;
             for (auto &i_p : obj->owned_objects)
+            {
                 tl->owned_objects[i_p.first] = i_p.second;
+                for (auto &child : i_p.second)
+                    child->parent = tl;
+            }
             tl->doc = this;  //  Set's the objects back-pointer to the parent Document
             SBOLObjects[tl->identity.get()] = tl;
+            converted[obj] = tl;
         }
-//        // Since this object is not generic TopLevel, it must be a nested annotation. Find the parent object that references it
-        else
+    }
+    // Since the remaining objects are not generic TopLevels, they must be nested annotations. The parent is the object that refers to the annotation object through an extension property
+    for (auto &obj : annotation_objects)
+    {
+        if (converted.count(obj))
+            continue;
+        auto i_refs = annotation_references.find(obj->identity.get());
+        if (i_refs == annotation_references.end())
+            continue;
+        vector< pair<SBOLObject*, rdf_type> > matches;
+        for (auto &ref : i_refs->second)
         {
-            // Determine the RDF type of the member property that contains this kind of annotation object
-            string ns = parseNamespace(obj->type);
-            string class_name = parseClassName(obj->type);
-            string property_name = class_name;
-            property_name[0] = tolower(property_name[0]);
-            string property_uri = ns + property_name;
-
-            // Find all parent objects containing a reference to the annotation object
-            vector<SBOLObject*> matches = find_reference(obj->identity.get());
-            
-            // Does this reference belong to the appropriate member property?
-            matches.erase( std::remove_if (matches.begin(), matches.end(), [property_uri] (SBOLObject* o) {
-                    if (o->properties.find(property_uri) != o->properties.end())
-                        return true;
-                    else
-                        return false;
-                }), matches.end());
-
-            if (matches.size() > 1)
-                throw SBOLError(SBOL_ERROR_SERIALIZATION, "Invalid custom annotation object in SBOL document");
-            else if (matches.size() == 1)
-            {
-                // Nested generic annotations
-                SBOLObject* match = matches.front();
-                match->owned_objects[property_uri].push_back(obj);
-                obj->parent = match;
-                match->properties.erase(property_uri);
-                SBOLObjects.erase(obj->identity.get());  // Remove nested object from TopLevel store
-            }
+            SBOLObject* parent = converted.count(ref.first) ? converted[ref.first] : ref.first;
+            if (std::find_if(matches.begin(), matches.end(), [parent] (pair<SBOLObject*, rdf_type>& m) { return m.first == parent; }) == matches.end())
+                matches.push_back({ parent, ref.second });
         }
+        if (matches.size() > 1)
+            throw SBOLError(SBOL_ERROR_SERIALIZATION, "Invalid custom annotation object in SBOL document");
+
+        // Nested generic annotations. The nested object replaces the reference to it
+        SBOLObject* match = matches.front().first;
+        string property_uri = matches.front().second;
+        string reference = "<" + obj->identity.get() + ">";
+        match->owned_objects[property_uri].push_back(obj);
+        obj->parent = match;
+        vector<string>& values = match->properties[property_uri];
+        values.erase(std::remove(values.begin(), values.end(), reference), values.end());
+        if (values.empty())
+            match->properties.erase(property_uri);
+        SBOLObjects.erase(obj->identity.get());  // Remove nested object from TopLevel store
     }
+    annotation_references.clear();
 }
 
 void sbol::raptor_error_handler(void *user_data, raptor_log_message* message)
@@ -792,6 +785,7 @@ void sbol::raptor_error_handler(void *user_data, raptor_log_message* message)
 */
 std::string Document::validate()
 {
+    SBOL_STATS_TIMER("validate");
 	raptor_world* world = getWorld();
 	raptor_serializer* sbol_serializer;
 	if (getFileFormat().compare("rdfxml") == 0)
@@ -847,6 +841,7 @@ std::vector<std::string> Document::getNamespaces()
 
 SBOLObject* Document::find(std::string uri)
 {
+    SBOL_STATS_COUNT("find_calls", 1);
     for (auto i_obj = SBOLObjects.begin(); i_obj != SBOLObjects.end(); ++i_obj)
     {
         SBOLObject& obj = *i_obj->second;
@@ -859,6 +854,7 @@ SBOLObject* Document::find(std::string uri)
 
 SBOLObject* Document::find_property(std::string uri)
 {
+    SBOL_STATS_COUNT("find_calls", 1);
     for (auto i_obj = SBOLObjects.begin(); i_obj != SBOLObjects.end(); ++i_obj)
     {
         SBOLObject& obj = *i_obj->second;
@@ -871,6 +867,7 @@ SBOLObject* Document::find_property(std::string uri)
 
 vector<SBOLObject*> Document::find_reference(string uri)
 {
+    SBOL_STATS_COUNT("find_calls", 1);
     vector<SBOLObject*> matches = {};
     for (auto i_obj = SBOLObjects.begin(); i_obj != SBOLObjects.end(); ++i_obj)
     {
@@ -896,7 +893,16 @@ void Document::namespaceHandler(void *user_data, raptor_namespace *nspace)
 
 void Document::read(std::string filename)
 {
-    // Wipe existing contents of this Document first. This should
+    SBOL_STATS_TIMER("read");
+    check_mutable(this);
+    check_no_transaction("read into");
+    // Wipe existing contents of this Document first
+    wipe();
+    this->append(filename);
+};
+
+void Document::wipe()
+{
     raptor_free_world(this->rdf_graph);  //  Probably need to free other objects as well...
     for (auto i_obj = SBOLObjects.begin(); i_obj != SBOLObjects.end(); ++i_obj)
     {
@@ -905,6 +911,7 @@ void Document::read(std::string filename)
         obj.close();
     }
     SBOLObjects.clear();
+    invalidate_indices();
 //    properties.clear();  // This may cause problems later because the Document object will lose all properties of an SBOLObject
 //    properties[SBOL_IDENTITY].push_back("<>");  // Re-initialize the identity property. The SBOLObject::compare method needs to get the Document's identity
 //    owned_objects.clear();
@@ -926,11 +933,15 @@ void Document::read(std::string filename)
     
     // Create new RDF graph
     this->rdf_graph = raptor_new_world();
-    this->append(filename);
 };
 
 void Document::append(std::string filename)
 {
+    SBOL_STATS_TIMER("read");
+    check_mutable(this);
+    check_no_transaction("read into");
+    ReloadScope reloading(*this);
+    invalidate_indices();
 
     raptor_world_set_log_handler(this->rdf_graph, NULL, raptor_error_handler); // Intercept raptor errors
     
@@ -946,11 +957,23 @@ void Document::append(std::string filename)
     FILE* fh = fopen(filename.c_str(), "rb");
     if (!fh)
         throw SBOLError(SBOL_ERROR_FILE_NOT_FOUND, "File " + filename + " not found");
+
+    // Compressed files are decompressed as they are parsed
+    InputFile input(this->rdf_graph, fh);
+    try
+    {
+        input.check();
+    }
+    catch (...)
+    {
+        fclose(fh);
+        throw;
+    }
 	//raptor_parser* rdf_parser = raptor_new_parser(this->rdf_graph, "rdfxml");
     raptor_parser* rdf_parser = raptor_new_parser(this->rdf_graph, getFileFormat().c_str());
 
     raptor_parser_set_namespace_handler(rdf_parser, this, this->namespaceHandler);
-	raptor_iostream* ios = raptor_new_iostream_from_file_handle(this->rdf_graph, fh);
+	raptor_iostream* ios = input.open();
 	unsigned char *uri_string;
 	raptor_uri *uri, *base_uri;
     base_uri = raptor_new_uri(this->rdf_graph, (const unsigned char *)SBOL_URI "#");
@@ -959,13 +982,33 @@ void Document::append(std::string filename)
     // Read the triple store. On the first pass through the triple store, new SBOLObjects are constructed by the parse_objects handler
 	raptor_parser_set_statement_handler(rdf_parser, user_data, this->parse_objects);
 	//base_uri = raptor_new_uri(this->rdf_graph, (const unsigned char *)(getHomespace() + "#").c_str());  //This can be used to import URIs into a namespace
-    raptor_parser_parse_iostream(rdf_parser, ios, base_uri);
+    collect_existing_children();
+    {
+        SBOL_STATS_TIMER("parse_objects");
+        DeserializationScope deserializing;
+        raptor_parser_parse_iostream(rdf_parser, ios, base_uri);
+    }
+    existing_children.clear();
+    annotation_references.clear();
     raptor_free_iostream(ios);
+    try
+    {
+        input.check();
+    }
+    catch (...)
+    {
+        raptor_free_uri(base_uri);
+        raptor_free_parser(rdf_parser);
+        fclose(fh);
+        throw;
+    }
     // Read the triple store again. On the second pass through the triple store, property values are assigned to each SBOLObject's member properties by the parse_properties handler
-	rewind(fh);
-	ios = raptor_new_iostream_from_file_handle(this->rdf_graph, fh);
+	ios = input.open();
 	raptor_parser_set_statement_handler(rdf_parser, user_data, this->parse_properties);
-	raptor_parser_parse_iostream(rdf_parser, ios, base_uri);
+    {
+        SBOL_STATS_TIMER("parse_properties");
+        raptor_parser_parse_iostream(rdf_parser, ios, base_uri);
+    }
     raptor_free_iostream(ios);
     
     raptor_free_uri(base_uri);
@@ -977,10 +1020,16 @@ void Document::append(std::string filename)
     // Process libSBOL objects not part of the SBOL core standard
     parse_extension_objects();
     fclose(fh);
+    notify_change(SBOL_CHANGE_RELOADED, this, "", "");
 }
 
 void Document::readString(std::string& sbol)
 {
+    SBOL_STATS_TIMER("read");
+    check_mutable(this);
+    check_no_transaction("read into");
+    ReloadScope reloading(*this);
+    invalidate_indices();
     raptor_world_set_log_handler(this->rdf_graph, NULL, raptor_error_handler); // Intercept raptor errors
     
     raptor_parser* rdf_parser = raptor_new_parser(this->rdf_graph, getFileFormat().c_str());
@@ -997,13 +1046,23 @@ void Document::readString(std::string& sbol)
     raptor_parser_set_statement_handler(rdf_parser, user_data, this->parse_objects);
     //base_uri = raptor_new_uri(this->rdf_graph, (const unsigned char *)(getHomespace() + "#").c_str());  //This can be used to import URIs into a namespace
 
-    raptor_parser_parse_iostream(rdf_parser, ios, base_uri);
+    collect_existing_children();
+    {
+        SBOL_STATS_TIMER("parse_objects");
+        DeserializationScope deserializing;
+        raptor_parser_parse_iostream(rdf_parser, ios, base_uri);
+    }
+    existing_children.clear();
+    annotation_references.clear();
     raptor_free_iostream(ios);
     
     // Read the triple store again. On the second pass through the triple store, property values are assigned to each SBOLObject's member properties by the parse_properties handler
     ios = raptor_new_iostream_from_string(this->rdf_graph, (void *)sbol.c_str(), sbol.size());
     raptor_parser_set_statement_handler(rdf_parser, user_data, this->parse_properties);
-    raptor_parser_parse_iostream(rdf_parser, ios, base_uri);
+    {
+        SBOL_STATS_TIMER("parse_properties");
+        raptor_parser_parse_iostream(rdf_parser, ios, base_uri);
+    }
     raptor_free_iostream(ios);
     
     raptor_free_uri(base_uri);
@@ -1014,6 +1073,7 @@ void Document::readString(std::string& sbol)
 
     // Process libSBOL objects not part of the SBOL core standard
     parse_extension_objects();
+    notify_change(SBOL_CHANGE_RELOADED, this, "", "");
 }
 
 
@@ -1047,7 +1107,9 @@ void SBOLObject::serialize(raptor_serializer* sbol_serializer, raptor_world *sbo
 
         for (auto i_ns = namespaces.begin(); i_ns != namespaces.end(); ++i_ns)
         {
-            doc->namespaces[i_ns->first] = i_ns->second;
+            auto i_declared = doc->namespaces.find(i_ns->first);
+            if (i_declared == doc->namespaces.end() || i_declared->second != i_ns->second)
+                doc->namespaces[i_ns->first] = i_ns->second;
         }
 		for (auto it = properties.begin(); it != properties.end(); ++it)
 		{
@@ -1187,6 +1249,7 @@ raptor_world* Document::getWorld()
 
 void Document::addNamespace(std::string ns, std::string prefix)
 {
+    check_mutable(this);
     this->namespaces[prefix] = ns;
 }
 
@@ -1201,6 +1264,7 @@ void Document::addNamespace(std::string ns, std::string prefix, raptor_serialize
 
 std::string Document::write(std::string filename)
 {
+    SBOL_STATS_TIMER("write");
 	// Initialize raptor serializer
     if (filename != "" && filename[0] == '~') {
         if (filename[1] != '/'){
@@ -1212,8 +1276,56 @@ std::string Document::write(std::string filename)
         }
     }
 
+    // Compressed files are serialized in memory and then compressed, in parallel for large Documents. Frozen Documents are also serialized in memory, from their shared cache
+    Compression compression = compression_from_filename(filename);
+    if (compression != Compression::NONE || frozen)
+    {
+        std::string buffer = writeString();
+        write_compressed_file(filename, buffer, compression);
+        std::string response;
+        if (Config::getOption("validate") == "True")
+            response = validate();
+        else
+            response = "Validation disabled. To enable use of the online validation tool, use Config::setOption(\"validate\", true)";
+        return response;
+    }
+
 	FILE* fh = fopen(filename.c_str(), "wb");
 
+    // Only the objects that changed since the last write are serialized again
+    std::string fragments_buffer;
+    if (getFileFormat().compare("json") != 0 && serialize_fragments(getFileFormat(), fragments_buffer))
+    {
+        if (fragments_buffer.size() && fwrite(fragments_buffer.data(), 1, fragments_buffer.size(), fh) != fragments_buffer.size())
+        {
+            fclose(fh);
+            throw SBOLError(SBOL_ERROR_SERIALIZATION, "Serialization failed. Could not write to file");
+        }
+        SBOL_STATS_COUNT("bytes_serialized", fragments_buffer.size());
+        std::string response;
+        if (Config::getOption("validate") == "True")
+            response = validate();
+        else
+            response = "Validation disabled. To enable use of the online validation tool, use Config::setOption(\"validate\", true)";
+        fclose(fh);
+        return response;
+    }
+
+    // Flat formats are written directly from the object graph
+    if (getFileFormat().compare("ntriples") == 0 || getFileFormat().compare("turtle") == 0)
+    {
+        std::string buffer;
+        size_t bytes_serialized = serialize_triples(getFileFormat(), buffer, fh);
+        SBOL_STATS_COUNT("bytes_serialized", bytes_serialized);
+        std::string response;
+        if (Config::getOption("validate") == "True")
+            response = validate();
+        else
+            response = "Validation disabled. To enable use of the online validation tool, use Config::setOption(\"validate\", true)";
+        fclose(fh);
+        return response;
+    }
+
 	raptor_world* world = getWorld();
 	raptor_serializer* sbol_serializer;
 	if (getFileFormat().compare("rdfxml") == 0)
@@ -1239,6 +1351,7 @@ std::string Document::write(std::string filename)
         if (sbol_buffer)
         {
             // Iterate through objects in document and nest them
+            SBOL_STATS_TIMER("nest");
             for (auto obj_i = SBOLObjects.begin(); obj_i != SBOLObjects.end(); ++obj_i)
             {
                 sbol_buffer_string = obj_i->second->nest(sbol_buffer_string);
@@ -1253,6 +1366,7 @@ std::string Document::write(std::string filename)
 
 	raptor_free_iostream(ios);
     raptor_free_uri(base_uri);
+    SBOL_STATS_COUNT("bytes_serialized", sbol_buffer_string.size());
 
 	// Validate SBOL using online validator
     std::string response;
@@ -1268,6 +1382,28 @@ std::string Document::write(std::string filename)
 
 std::string Document::writeString()
 {
+    SBOL_STATS_TIMER("write");
+    std::unique_lock<std::mutex> frozen_lock;
+    if (frozen)
+    {
+        std::string frozen_buffer;
+        if (serialize_frozen(getFileFormat(), frozen_buffer, frozen_lock))
+            return frozen_buffer;
+    }
+    // Only the objects that changed since the last write are serialized again
+    std::string fragments_buffer;
+    if (getFileFormat().compare("json") != 0 && serialize_fragments(getFileFormat(), fragments_buffer))
+    {
+        SBOL_STATS_COUNT("bytes_serialized", fragments_buffer.size());
+        return fragments_buffer;
+    }
+    if (getFileFormat().compare("ntriples") == 0 || getFileFormat().compare("turtle") == 0)
+    {
+        std::string sbol_buffer_string;
+        serialize_triples(getFileFormat(), sbol_buffer_string);
+        SBOL_STATS_COUNT("bytes_serialized", sbol_buffer_string.size());
+        return sbol_buffer_string;
+    }
     raptor_world* world = getWorld();
     raptor_serializer* sbol_serializer;
     if (getFileFormat().compare("rdfxml") == 0)
@@ -1290,6 +1426,7 @@ std::string Document::writeString()
     if (sbol_buffer)
     {
         // Iterate through objects in document and nest them
+        SBOL_STATS_TIMER("nest");
         for (auto obj_i = SBOLObjects.begin(); obj_i != SBOLObjects.end(); ++obj_i)
         {
             sbol_buffer_string = obj_i->second->nest(sbol_buffer_string);
@@ -1302,6 +1439,7 @@ std::string Document::writeString()
     
     raptor_free_iostream(ios);
     raptor_free_uri(base_uri);
+    SBOL_STATS_COUNT("bytes_serialized", sbol_buffer_string.size());
 
     return sbol_buffer_string;
 };
@@ -1313,6 +1451,7 @@ std::string Document::writeString()
 */
 void Document::generate(raptor_world** world, raptor_serializer** sbol_serializer, char** sbol_buffer, size_t* sbol_buffer_len, raptor_iostream** ios, raptor_uri** base_uri)
 {
+    SBOL_STATS_TIMER("serialize");
 
 	//char * sbol_buffer = "";
 
@@ -1369,6 +1508,40 @@ void Document::generate(raptor_world** world, raptor_serializer** sbol_serialize
 	return;
 }
 
+std::string Document::serialize_rdfxml_fragment(SBOLObject& obj)
+{
+    raptor_world* world = getWorld();
+    raptor_serializer* sbol_serializer = raptor_new_serializer(world, "rdfxml-abbrev");
+    char *sbol_buffer = NULL;
+    size_t sbol_buffer_len = 0;
+    if (raptor_serializer_start_to_string(sbol_serializer, NULL, (void **)&sbol_buffer, &sbol_buffer_len))
+    {
+        raptor_free_serializer(sbol_serializer);
+        throw SBOLError(SBOL_ERROR_SERIALIZATION, "Serialization failed");
+    }
+    obj.serialize(sbol_serializer);
+
+    // Declare the same namespaces as generate
+    raptor_namespace_stack *sbol_namespaces = raptor_new_namespaces(world, 0);
+    for (auto i_ns = this->namespaces.begin(); i_ns != this->namespaces.end(); ++i_ns)
+    {
+        raptor_uri *ns_uri = raptor_new_uri(world, (const unsigned char *)i_ns->second.c_str());
+        raptor_namespace *extension_namespace = raptor_new_namespace_from_uri(sbol_namespaces, (const unsigned char *)i_ns->first.c_str(), ns_uri, 1);
+        raptor_serializer_set_namespace_from_namespace(sbol_serializer, extension_namespace);
+        raptor_free_uri(ns_uri);
+    }
+    raptor_serializer_serialize_end(sbol_serializer);
+    raptor_free_serializer(sbol_serializer);
+    raptor_free_namespaces(sbol_namespaces);
+    if (!sbol_buffer)
+        throw SBOLError(SBOL_ERROR_SERIALIZATION, "Serialization failed");
+
+    // Convert flat RDF/XML into nested SBOL
+    std::string sbol_buffer_string = std::string(sbol_buffer, sbol_buffer_len);
+    raptor_free_memory(sbol_buffer);
+    return obj.nest(sbol_buffer_string);
+};
+
 void Document::close(std::string uri)
 {
     if (uri == "")
@@ -1377,12 +1550,38 @@ void Document::close(std::string uri)
     }
     else
     {
+        check_mutable(this);
         if (SBOLObjects.find(uri) == SBOLObjects.end())
             throw SBOLError(NOT_FOUND_ERROR, "Object " + uri + " is not contained in Document and cannot be deleted");
         else
         {
             SBOLObject* obj = SBOLObjects[uri];
-            obj->close();
+            notify_change(SBOL_CHANGE_TOPLEVEL_CLOSED, this, "", obj);
+            unindex_object(*obj);
+
+            // Take the object out of the store that holds it, recording its position for rollback as OwnedObject::remove does.
+            // The store is usually the one registered for its class
+            const ClassTraits* traits = ClassRegistry::find(std::type_index(typeid(*obj)));
+            auto remove_from_store = [&](const rdf_type& store_type)
+            {
+                auto i_store = owned_objects.find(store_type);
+                if (i_store == owned_objects.end())
+                    return false;
+                vector<SBOLObject*>& store = i_store->second;
+                auto i_obj = std::find(store.begin(), store.end(), obj);
+                if (i_obj == store.end())
+                    return false;
+                record_object_removed(this, store_type, i_obj - store.begin());
+                store.erase(i_obj);
+                notify_property_change(this, store_type);
+                return true;
+            };
+            if (!traits || !remove_from_store(traits->store))
+                for (auto & i_store : owned_objects)
+                    if (remove_from_store(i_store.first))
+                        break;
+            release_object(this, obj);
+            record_registration(this, uri);
             SBOLObjects.erase(uri);
         }
     }
@@ -1431,6 +1630,7 @@ std::string ReferencedObject::create(std::string uri)
 
 Identified& Identified::copy(Document* target_doc, string ns, string version)
 {
+    SBOL_STATS_TIMER("copy");
     // Call constructor for the copy
     Identified& new_obj = (Identified&)SBOL_DATA_MODEL_REGISTER[ this->type ]();
     
@@ -1620,7 +1820,7 @@ std::string Document::request_validation(std::string& sbol)
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
 
         /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
+        res = perform_request(curl);
         /* Check for errors */
         if(res != CURLE_OK)
             throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Cannot validate online. HTTP post request failed with: " + string(curl_easy_strerror(res)));
@@ -1709,7 +1909,7 @@ std::string Document::request_comparison(Document& diff_file)
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
         
         /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
+        res = perform_request(curl);
         /* Check for errors */
         if(res != CURLE_OK)
             throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Cannot compare documents with online validator. HTTP get request failed with: " + string(curl_easy_strerror(res)));
@@ -1793,7 +1993,7 @@ std::string Document::query_repository(std::string command)
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
         
         /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
+        res = perform_request(curl);
         /* Check for errors */
         if(res != CURLE_OK)
             throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to validate online failed with " + string(curl_easy_strerror(res)));
@@ -1887,7 +2087,7 @@ std::string Document::search_metadata(std::string role, std::string type, std::s
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
         
         /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
+        res = perform_request(curl);
         /* Check for errors */
         if(res != CURLE_OK)
             throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to validate online failed with " + string(curl_easy_strerror(res)));
@@ -1931,6 +2131,206 @@ Document& Document::copy(std::string ns, Document* doc)
     return *doc;
 };
 
+vector<string> Document::find_duplicate_uris()
+{
+    // Gather every TopLevel root, including objects in the stores whose URI was overwritten in the register
+    vector<SBOLObject*> roots;
+    roots.reserve(SBOLObjects.size());
+    for (auto & id_and_obj : SBOLObjects)
+        roots.push_back(id_and_obj.second);
+    for (auto & store : owned_objects)
+        if (std::find(hidden_properties.begin(), hidden_properties.end(), store.first) == hidden_properties.end())
+            roots.insert(roots.end(), store.second.begin(), store.second.end());
+
+    // Walk all object trees once, recording which object claims each identity
+    unordered_map<string, SBOLObject*> identities;
+    identities.reserve(roots.size());
+    unordered_map<SBOLObject*, bool> visited;
+    visited.reserve(roots.size());
+    vector<string> duplicates;
+    vector< pair<SBOLObject*, bool> > stack;
+    for (auto & root : roots)
+    {
+        // TopLevels listed both in the register and in a store are only visited once
+        if (visited.find(root) != visited.end())
+            continue;
+        stack.push_back({ root, true });
+        while (stack.size())
+        {
+            SBOLObject* obj = stack.back().first;
+            bool is_root = stack.back().second;
+            stack.pop_back();
+            if (!is_root && visited.find(obj) != visited.end())
+            {
+                // The same child object is contained more than once
+                duplicates.push_back(obj->identity.get());
+                continue;
+            }
+            visited[obj] = true;
+            auto i_match = identities.find(obj->identity.get());
+            if (i_match == identities.end())
+                identities[obj->identity.get()] = obj;
+            else if (i_match->second != obj)
+                duplicates.push_back(obj->identity.get());
+            for (auto & property : obj->owned_objects)
+            {
+                if (std::find(obj->hidden_properties.begin(), obj->hidden_properties.end(), property.first) != obj->hidden_properties.end())
+                    continue;
+                for (auto & child : property.second)
+                    stack.push_back({ child, false });
+            }
+        }
+    }
+    std::sort(duplicates.begin(), duplicates.end());
+    duplicates.erase(std::unique(duplicates.begin(), duplicates.end()), duplicates.end());
+    return duplicates;
+};
+
+// List the objects of one type. TopLevel objects are kept in the Document's stores. Child objects are found by walking the object trees in a fixed order
+static vector<SBOLObject*> get_objects_of_type(Document& doc, const string& object_type)
+{
+    auto i_store = doc.owned_objects.find(object_type);
+    if (i_store != doc.owned_objects.end())
+        return i_store->second;
+    vector<SBOLObject*> objects;
+    vector<SBOLObject*> stack;
+    for (auto i_store = doc.owned_objects.rbegin(); i_store != doc.owned_objects.rend(); ++i_store)
+        stack.insert(stack.end(), i_store->second.rbegin(), i_store->second.rend());
+    while (stack.size())
+    {
+        SBOLObject* obj = stack.back();
+        stack.pop_back();
+        if (obj->type == object_type)
+            objects.push_back(obj);
+        for (auto i_child_store = obj->owned_objects.rbegin(); i_child_store != obj->owned_objects.rend(); ++i_child_store)
+            stack.insert(stack.end(), i_child_store->second.rbegin(), i_child_store->second.rend());
+    }
+    return objects;
+};
+
+vector<PropertyColumn> Document::getPropertyColumns(string object_type, vector<string> property_uris)
+{
+    SBOL_STATS_TIMER("property_columns");
+    vector<SBOLObject*> objects = get_objects_of_type(*this, object_type);
+    vector<PropertyColumn> columns(property_uris.size());
+    for (size_t i_column = 0; i_column < property_uris.size(); ++i_column)
+    {
+        const string& property_uri = property_uris[i_column];
+        PropertyColumn& column = columns[i_column];
+        column.values.reserve(objects.size());
+        column.offsets.reserve(objects.size() + 1);
+        column.offsets.push_back(0);
+        for (auto & obj : objects)
+        {
+            auto i_property = obj->properties.find(property_uri);
+            if (i_property != obj->properties.end())
+            {
+                for (auto & value : i_property->second)
+                    if (value.length() > 2)  // Skip unset values
+                        column.values.push_back(value.substr(1, value.length() - 2));  // Removes flanking < and > or quotes
+            }
+            else
+            {
+                auto i_children = obj->owned_objects.find(property_uri);
+                if (i_children != obj->owned_objects.end())
+                    for (auto & child : i_children->second)
+                        column.values.push_back(child->identity.get());
+            }
+            column.offsets.push_back(column.values.size());
+        }
+    }
+    return columns;
+};
+
+vector<string> Document::getPropertyColumn(string object_type, string property_uri)
+{
+    PropertyColumn column = std::move(getPropertyColumns(object_type, { property_uri }).front());
+    vector<string> first_values;
+    first_values.reserve(column.offsets.size() - 1);
+    for (size_t i_obj = 0; i_obj + 1 < column.offsets.size(); ++i_obj)
+    {
+        if (column.offsets[i_obj + 1] > column.offsets[i_obj])
+            first_values.push_back(std::move(column.values[column.offsets[i_obj]]));
+        else
+            first_values.push_back("");
+    }
+    return first_values;
+};
+
+void Document::addBatch(vector<SBOLObject*> sbol_objects)
+{
+    check_mutable(this);
+    // The scope checks the batch against the Document, and against itself, once all of it has been added
+    BulkInsert bulk_insert(*this, sbol_objects.size());
+    for (auto & obj : sbol_objects)
+    {
+        // Build and Test share an RDF type with Implementation and Collection, so they need the specialized adders to land in the right store
+        if (Build* build = dynamic_cast<Build*>(obj))
+            add<Build>(*build);
+        else if (Test* test = dynamic_cast<Test*>(obj))
+            add<Test>(*test);
+        else
+            add<SBOLObject>(*obj);
+    }
+    bulk_insert.commit();
+};
+
+BulkInsert::BulkInsert(Document& doc, int expected_size) :
+    doc(doc),
+    is_open(true)
+{
+    // The scope records its changes like a transaction, so a failed commit can undo them
+    doc.beginTransaction();
+    savepoint = doc.savepoints.size();
+    ++doc.bulk_insert_depth;
+    if (expected_size > 0)
+        doc.SBOLObjects.reserve(doc.SBOLObjects.size() + expected_size);
+};
+
+void BulkInsert::commit()
+{
+    if (!is_open)
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "This BulkInsert scope was already committed");
+    is_open = false;
+    --doc.bulk_insert_depth;
+    if (doc.savepoints.size() < savepoint)
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot commit BulkInsert scope. Its transaction was already closed");
+    // Transactions begun inside the scope and left open become part of it
+    while (doc.savepoints.size() > savepoint)
+        doc.commit();
+    if (doc.bulk_insert_depth)
+    {
+        doc.commit();  // An enclosing scope will run the check, and undo these changes too if it fails
+        return;
+    }
+    vector<string> duplicates = doc.find_duplicate_uris();
+    if (duplicates.size())
+    {
+        doc.rollback();
+        string msg = "Bulk insertion failed. The objects added in the scope were removed. The following URIs are not unique:";
+        for (auto & uri : duplicates)
+            msg += " " + uri;
+        throw SBOLError(DUPLICATE_URI_ERROR, msg);
+    }
+    doc.commit();
+};
+
+BulkInsert::~BulkInsert() noexcept
+{
+    if (!is_open)
+        return;
+    --doc.bulk_insert_depth;
+    // Unwind the scope's transaction, and any left open inside it, unless it was already closed with Document::commit or rollback
+    try
+    {
+        while (doc.savepoints.size() >= savepoint)
+            doc.rollback();
+    }
+    catch (...)
+    {
+    }
+};
+
 void TopLevel::initialize(std::string uri)
 {
     if  (Config::getOption("sbol_compliant_uris") == "True")
@@ -2003,6 +2403,8 @@ void SBOLObject::update_uri()
     if (!sbol_obj.parent)
         return;
     SBOLObject& parent = *sbol_obj.parent;
+    // Inside a BulkInsert scope, uniqueness is checked once when the scope is committed
+    bool defer_checks = parent.doc && parent.doc->bulk_insert_depth;
     if (Config::getOption("sbol_compliant_uris") == "True" && !dynamic_cast<TopLevel*>(&sbol_obj))
     {
         // Form compliant URI for child object
@@ -2022,11 +2424,16 @@ void SBOLObject::update_uri()
         obj_id = persistent_id + "/" + version;
 
         // Reset SBOLCompliant properties
+        std::string old_id = sbol_obj.identity.get();
         sbol_obj.identity.set(obj_id);
         sbol_obj.persistentIdentity.set(persistent_id);
+        if (old_id != obj_id)
+            notify_change(SBOL_CHANGE_URI_CHANGED, &sbol_obj, SBOL_IDENTITY, old_id);
         
         // Check for uniqueness of URI in local object properties
-        vector<SBOLObject*> matches = this->parent->find_property_value(SBOL_IDENTITY, obj_id);
+        vector<SBOLObject*> matches;
+        if (!defer_checks)
+            matches = this->parent->find_property_value(SBOL_IDENTITY, obj_id);
         if (matches.size() > 1)
             throw SBOLError(DUPLICATE_URI_ERROR, "Cannot update SBOL-compliant URI. The URI " + sbol_obj.identity.get() + " is not unique");
 
@@ -2040,7 +2447,7 @@ void SBOLObject::update_uri()
         }
     }
     // Check for uniqueness of URI in Document
-    if (parent.doc)
+    if (parent.doc && !defer_checks)
     {
         vector<SBOLObject*> matches = parent.doc->find_property_value(SBOL_IDENTITY, sbol_obj.identity.get());
         if (matches.size() > 1)
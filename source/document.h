@@ -40,11 +40,18 @@
 #include "combinatorialderivation.h"
 #include "implementation.h"
 #include "dbtl.h"
+#include "stats.h"
 
 #include <raptor2.h>
 #include <unordered_map>
+#include <unordered_set>
+#include <map>
 #include <istream>
 #include <algorithm>
+#include <typeindex>
+#include <type_traits>
+#include <atomic>
+#include <mutex>
 
 #if defined(SBOL_BUILD_PYTHON2) || defined(SBOL_BUILD_PYTHON3)
 #include "Python.h"
@@ -58,9 +65,285 @@ namespace sbol {
     /// @cond
     // This is the global SBOL register for classes.  It maps an SBOL RDF type (eg, "http://sbolstandard.org/v2#Sequence" to a constructor
     extern std::unordered_map<std::string, sbol::SBOLObject&(*)()> SBOL_DATA_MODEL_REGISTER;
+
+    // Traits of a class in the data model, precomputed when the class is registered
+    struct SBOL_DECLSPEC ClassTraits
+    {
+        int id;                                 // A small integer assigned in order of registration
+        rdf_type type;                          // The RDF type under which the class is registered
+        std::type_index cpp_type;               // The C++ class
+        SBOLObject&(*constructor)();
+        bool is_toplevel;
+        rdf_type store;                         // For TopLevel classes, the key of the Document's property store that holds its instances
+        rdf_type discriminator;                 // For sys-bio classes serialized as their SBOL base class, the value of the sys-bio:type property that identifies them
+        bool (*is_instance)(SBOLObject*);       // Tests whether an object is an instance of this class or a class derived from it
+        size_t size;                            // The size of an instance, excluding the heap memory it owns
+    };
+
+    // Assigns each core and extension class an integer id. The parser and the typed accessors of a Document dispatch on ClassTraits rather than comparing RDF types or casting. Core classes are registered on first use, extension classes once at startup through SBOLObject::register_extension_class. Registration is not thread-safe; lookups are.
+    class SBOL_DECLSPEC ClassRegistry
+    {
+    public:
+        template < class SBOLClass > static int add(rdf_type type, rdf_type discriminator = "");
+        static int add(ClassTraits traits);
+
+        /// @return The traits of the class registered with the RDF type, or NULL
+        static const ClassTraits* find(const rdf_type& type);
+        /// @return The traits of a registered C++ class, or NULL
+        template < class SBOLClass > static const ClassTraits* find() { return find(std::type_index(typeid(SBOLClass))); };
+        static const ClassTraits* find(std::type_index cpp_type);
+        static const ClassTraits& get(int id);
+        static int size();
+
+        /// @return Ids of the registered classes the class derives from, nearest first
+        static const std::vector<int>& bases(int id);
+        /// @return Ids of the class and every registered class derived from it
+        static const std::vector<int>& derived(int id);
+        /// @return Whether an object is an instance of the class or of a class derived from it
+        static bool is_a(SBOLObject* obj, int id);
+
+        /// @return The constructors of all registered classes, keyed by RDF type, for initializing SBOL_DATA_MODEL_REGISTER
+        static std::unordered_map<std::string, SBOLObject&(*)()> constructors();
+
+        template < class SBOLClass > static ClassTraits traits(rdf_type type, rdf_type discriminator = "");
+    };
     /// @endcond
 
     
+    /// The values of one property across many objects, as returned by Document::getPropertyColumns. The values of the i-th object are values[offsets[i]] up to, but not including, values[offsets[i + 1]]
+    struct SBOL_DECLSPEC PropertyColumn
+    {
+        std::vector<std::string> values;
+        std::vector<size_t> offsets;
+    };
+
+    class SearchQuery;
+    class SearchResponse;
+
+    /// An estimate of the memory held by a Document, as returned by Document::memoryUsage. Sizes are in bytes. Heap blocks are counted at their requested size, without the overhead of the allocator, so the process will use somewhat more
+    /// | Category              | Description                                                                    |
+    /// | :-------------------- | :----------------------------------------------------------------------------- |
+    /// | objects               | The C++ objects themselves, including their member properties                  |
+    /// | property_strings      | The values of properties                                                       |
+    /// | owned_object_vectors  | The lists of child objects                                                     |
+    /// | maps                  | The maps of properties and child objects of each object, and their keys        |
+    /// | namespaces            | Namespaces declared by the Document and by extension objects                   |
+    /// | annotation_objects    | Custom annotation objects and their children, in all of the above              |
+    /// | indexes               | The Document's register of objects, and its query, search, lineage and serialization caches |
+    class SBOL_DECLSPEC MemoryUsage
+    {
+    public:
+        /// @return The size of the Document, its objects and its indexes, which is the sum of the categories
+        size_t getTotal();
+
+        /// @return The number of objects, including child objects
+        size_t getObjectCount();
+
+        /// @return The number of RDF triples the objects serialize to: one for the type of each object, one for each property value and one for each child object
+        size_t getTripleCount();
+
+        /// @return The names of the categories, listed in the table above
+        std::vector<std::string> getCategories();
+
+        /// @param category The name of a category, eg, property_strings
+        /// @return The size of the category
+        size_t getCategorySize(std::string category);
+
+        /// @return The RDF types of the classes of the objects, largest first
+        std::vector<std::string> getClasses();
+
+        /// @param class_uri The RDF type of a class, eg, SBOL_COMPONENT_DEFINITION
+        /// @return The number of objects of the class
+        size_t getClassCount(std::string class_uri);
+
+        /// @param class_uri The RDF type of a class, eg, SBOL_COMPONENT_DEFINITION
+        /// @return The size of the objects of the class, excluding their child objects
+        size_t getClassSize(std::string class_uri);
+
+        /// @param class_uri The RDF type of a class, eg, SBOL_COMPONENT_DEFINITION
+        /// @return The average size of an object of the class, excluding its child objects
+        double getClassAverage(std::string class_uri);
+
+        /// @return The identities of the largest TopLevel objects, largest first
+        std::vector<std::string> getLargestObjects();
+
+        /// @param uri The identity of an object returned by getLargestObjects
+        /// @return The size of the object, including its child objects
+        size_t getObjectSize(std::string uri);
+
+        /// @return A human-readable table of the categories, classes and largest objects
+        std::string report();
+
+        /// @cond
+        struct ClassUsage
+        {
+            size_t count;
+            size_t size;
+        };
+        size_t object_count = 0;
+        size_t triple_count = 0;
+        std::map<std::string, size_t> categories;
+        std::map<std::string, ClassUsage> classes;
+        std::vector<std::pair<std::string, size_t>> largest_objects;
+        /// @endcond
+    };
+
+    /// @cond
+    // An occurrence of a token in the full-text index of a Document
+    struct TextPosting
+    {
+        uint32_t object_id;  // Index into Document::text_index_objects
+        uint32_t field;  // Index into Document::text_properties
+    };
+
+    // The serialized text of one TopLevel object and its children, and the revision of the object it was serialized from
+    struct SerializedFragment
+    {
+        uint64_t revision;
+        std::string text;
+    };
+
+    // A flag that one thread may read without a lock while another sets it. Copies take the value of the original
+    struct AtomicFlag
+    {
+        std::atomic<bool> value;
+
+        AtomicFlag() : value(false) {};
+        AtomicFlag(const AtomicFlag& other) : value(other.value.load()) {};
+        AtomicFlag& operator=(const AtomicFlag& other) { value = other.value.load(); return *this; };
+    };
+
+    // The fragments of a Document serialized in one format, with the text that encloses them
+    struct SerializationCache
+    {
+        std::string namespaces;  // The Document's namespaces when the fragments were serialized. The fragments are stale if these change
+        std::string header;
+        std::string footer;
+        std::unordered_map<SBOLObject*, SerializedFragment> fragments;
+        AtomicFlag complete;  // Set when the fragments of a frozen Document are all cached, after which they are only read
+    };
+
+    // An entry in the undo log of a Document. It restores one piece of state, changed inside a transaction, to its value before the change
+    struct UndoEntry
+    {
+        enum Kind { VALUES, OBJECT_ADDED, OBJECT_REMOVED, OBJECT_STORE, LINKS, REGISTRATION, CREATED, CLOSED };
+
+        Kind kind;
+        SBOLObject* owner;  // The object whose property or object store changed, or the object itself for LINKS, CREATED and CLOSED
+        std::string key;  // The property or object store, or the URI of a REGISTRATION
+        SBOLObject* obj = NULL;  // The object added or removed, the previous parent for LINKS, or the object previously registered under the URI
+        Document* doc = NULL;  // The previous Document back-pointer for LINKS
+        size_t index = 0;  // The position of a removed object in its store
+        bool existed = false;  // Whether the property had values, or the URI was registered
+        std::vector<std::string> values;
+        std::vector<SBOLObject*> objects;
+
+        UndoEntry(Kind kind, SBOLObject* owner, const std::string& key = "") : kind(kind), owner(owner), key(key) {};
+    };
+
+    // The Document that an object belongs to, found through its parents, or NULL. Defined in transaction.cpp
+    SBOL_DECLSPEC Document* owning_document(SBOLObject* obj);
+
+    // Held while a file, string or snapshot is read into a Document. The individual changes made by the parser are not reported to observers, which are sent a single SBOL_CHANGE_RELOADED change instead. Defined in observer.cpp
+    class SBOL_DECLSPEC ReloadScope
+    {
+        Document& doc;
+    public:
+        ReloadScope(Document& doc);
+        ~ReloadScope();
+    };
+
+    // Compression formats of the files that Documents are read from and written to
+    enum class Compression { NONE, GZIP, ZSTD };
+
+    // The compression implied by the extension of a filename, ie, .gz or .zst. Defined in compression.cpp
+    SBOL_DECLSPEC Compression compression_from_filename(const std::string& filename);
+
+    // Compress text at the level and with the threads set by the compression_level and compression_threads options, and write it to a file. With Compression::NONE the text is written as it is
+    SBOL_DECLSPEC void write_compressed_file(const std::string& filename, const std::string& text, Compression compression);
+
+    class InputDecoder;
+
+    // A file opened for the raptor parser, which is decompressed as it is read if its magic bytes show it to be gzip- or zstd-compressed
+    class SBOL_DECLSPEC InputFile
+    {
+    public:
+        InputFile(raptor_world* world, FILE* fh);
+        ~InputFile();
+
+        // A new stream that reads the file from its start. Free it before opening another
+        raptor_iostream* open();
+
+        // Throw an SBOLError if the file is compressed in a format that libSBOL was built without, or could not be decompressed. Call it before the first open
+        void check();
+
+        Compression compression;
+
+    private:
+        raptor_world* world;
+        FILE* fh;
+        InputDecoder* decoder;
+        bool supported;
+    };
+    /// @endcond
+
+    /// A condition on the URI-valued properties of objects, such as their types and roles, evaluated by Document::query. Conditions are combined with the & (AND) and | (OR) operators, eg, TermQuery::ofType(SBOL_COMPONENT_DEFINITION) & (TermQuery(SBOL_ROLES, SO_PROMOTER) | TermQuery(SBOL_ROLES, SO_TERMINATOR))
+    class SBOL_DECLSPEC TermQuery
+    {
+    public:
+        /// Match objects that have a given URI among the values of a property
+        /// @param property_uri The RDF type of an indexed property, eg, SBOL_ROLES
+        /// @param value A URI, eg, SO_PROMOTER
+        TermQuery(std::string property_uri, std::string value);
+
+        /// Match objects of a given class
+        /// @param class_uri The RDF type of the class, eg, SBOL_COMPONENT_DEFINITION
+        static TermQuery ofType(std::string class_uri);
+
+        /// Match objects that satisfy both conditions
+        TermQuery operator&(const TermQuery& other) const;
+
+        /// Match objects that satisfy either condition
+        TermQuery operator|(const TermQuery& other) const;
+
+        /// @cond
+        enum Operator { TERM, AND, OR };
+        Operator op;
+        std::string property_uri;
+        std::string value;
+        std::vector<TermQuery> operands;
+        /// @endcond
+    };
+
+    /// A change to a Document, as reported to a DocumentObserver
+    class SBOL_DECLSPEC ChangeEvent
+    {
+    public:
+        /// The kind of change
+        ChangeType type;
+        /// The URI of the object that changed. For TopLevel changes, the URI of the TopLevel object
+        std::string subject;
+        /// The RDF type of the property that changed, or empty for TopLevel changes
+        std::string property;
+        /// The value that was set, added or removed, or the URI of the child object that was added or removed
+        std::string value;
+
+        ChangeEvent(ChangeType type, std::string subject, std::string property, std::string value) :
+            type(type), subject(subject), property(property), value(value) {};
+    };
+
+    class Document;
+
+    /// Receives the changes made to the Documents it is registered with by Document::addObserver. Changes are reported after they are made, on the thread that made them. Inside a batch, they are queued and reported together when the outermost batch ends
+    class SBOL_DECLSPEC DocumentObserver
+    {
+    public:
+        virtual ~DocumentObserver() {};
+
+        /// Called with the changes made to a Document, in the order they were made. The observer may read the Document, but should not modify it
+        virtual void changed(Document& doc, const std::vector<ChangeEvent>& changes) = 0;
+    };
+
     /// Read and write SBOL using a Document class.  The Document is a container for Components, Modules, and all other SBOLObjects
     class SBOL_DECLSPEC Document : public Identified
     {
@@ -118,6 +401,145 @@ namespace sbol {
         /// The Document's register of objects
 		std::unordered_map<std::string, sbol::SBOLObject*> SBOLObjects;
         
+        /// The number of open BulkInsert scopes. While positive, URI uniqueness checks that scan the Document are deferred.
+        /// While every open transaction belongs to a BulkInsert scope, property values are not recorded in the undo log
+        int bulk_insert_depth = 0;
+
+        /// The changes made inside open transactions, in the order they were made
+        std::vector<UndoEntry> undo_log;
+        /// The length of the undo log when each open transaction began, outermost first
+        std::vector<size_t> savepoints;
+
+        /// Throw an SBOLError if a transaction is open, before an operation that replaces the contents of the Document wholesale and cannot be rolled back
+        void check_no_transaction(const std::string& operation);
+
+        /// Called when a Document with open transactions is destroyed, to delete the objects that were closed inside them
+        void release_transactions();
+
+        /// The observers registered with addObserver, in the order they were registered
+        std::vector<DocumentObserver*> observers;
+        /// Observers that are deleted with the Document, such as the callbacks registered from Python
+        std::vector<DocumentObserver*> owned_observers;
+        /// The changes made inside open batches, which are delivered when the outermost batch ends
+        std::vector<ChangeEvent> queued_changes;
+        /// The number of open batches
+        int batch_depth = 0;
+        /// The number of open ReloadScopes
+        int reload_depth = 0;
+
+        /// Queue a change if a batch is open, otherwise report it to the observers
+        void deliver_change(ChangeEvent&& change);
+
+        /// Called when a Document is destroyed, to unregister its observers and delete the ones it owns
+        void release_observers();
+        
+        /// The provenance graph, mapping each object to the entities and Activities it was derived from, generated by, used or informed by. The graph is built on demand by the lineage queries
+        std::unordered_map<std::string, std::vector<std::string>> lineage_parents;
+        /// The reverse of lineage_parents
+        std::unordered_map<std::string, std::vector<std::string>> lineage_children;
+        /// Cleared when a provenance property changes, or an object that carries one is added or removed, so the next lineage query rebuilds the graph
+        bool lineage_valid = false;
+        
+        /// Rebuild the provenance graph in a single pass over the Document, if it is out of date
+        void index_lineage();
+
+        /// Whether an object or any object it contains has a provenance value, so that adding or removing it changes the provenance graph
+        bool carries_lineage(SBOLObject& obj);
+
+        /// The properties in the inverted index. The class type of objects is indexed under rdf:type
+        std::unordered_set<std::string> indexed_properties = { RDF_URI "type", SBOL_TYPES, SBOL_ROLES };
+        /// The inverted index, mapping a property and one of its URI values to the objects with that value
+        std::unordered_map<std::string, std::unordered_map<std::string, std::unordered_set<SBOLObject*>>> term_index;
+        /// The entries of the inverted index for each object, so they can be withdrawn when the object changes
+        std::unordered_map<SBOLObject*, std::vector<std::pair<std::string, std::string>>> term_index_entries;
+        /// Objects whose entries are out of date, each with a flag that is set if the object's children must be indexed as well
+        std::unordered_map<SBOLObject*, bool> term_index_dirty;
+        /// Cleared when the Document is read or wiped, so the next query rebuilds the inverted index
+        bool term_index_valid = false;
+
+        /// Bring the inverted index up to date, by rebuilding it or by re-indexing the objects that changed
+        void index_terms();
+
+        /// The properties in the full-text index, with the weight of a match in each
+        std::vector<std::pair<std::string, float>> text_properties = { { SBOL_DISPLAY_ID, 4 }, { SBOL_NAME, 3 }, { SBOL_DESCRIPTION, 1 } };
+        /// The full-text index, mapping each lower-case token to its occurrences. Tokens are sorted, so the tokens that start with a prefix are adjacent
+        std::map<std::string, std::vector<TextPosting>> text_index;
+        /// The objects in the full-text index, by the ids in its postings. The slot of an object that was re-indexed is set to NULL, and its postings are skipped until the index is next rebuilt
+        std::vector<SBOLObject*> text_index_objects;
+        /// The ids of the objects in the full-text index
+        std::unordered_map<SBOLObject*, uint32_t> text_index_ids;
+        /// The class of each object in the full-text index, as an index into text_index_class_uris, so searches can filter by class without touching the objects
+        std::vector<uint32_t> text_index_classes;
+        /// The RDF types of the objects in the full-text index
+        std::vector<std::string> text_index_class_uris;
+        /// Objects whose postings are out of date, each with a flag that is set if the object's children must be indexed as well
+        std::unordered_map<SBOLObject*, bool> text_index_dirty;
+        /// Cleared when the Document is read or wiped, or when too many postings are out of date, so the next search rebuilds the full-text index
+        bool text_index_valid = false;
+
+        /// Bring the full-text index up to date, by rebuilding it or by re-indexing the objects that changed
+        void index_text();
+
+        /// Withdraw the postings of one removed object from the full-text index
+        void unindex_text(SBOLObject& obj);
+
+        /// Record that an object tree was added to the Document, so the indices built on demand are updated
+        void index_new_object(SBOLObject& obj);
+
+        /// Withdraw an object tree from the indices built on demand, before it is removed from the Document
+        void unindex_object(SBOLObject& obj);
+
+        /// Discard the indices built on demand, after the contents of the Document are replaced or rolled back
+        void invalidate_indices();
+        
+        /// Check the identities of every object in the Document for uniqueness in a single pass
+        /// @return A sorted list of URIs that identify more than one object, or objects contained more than once
+        std::vector<std::string> find_duplicate_uris();
+        
+        /// Serialize the Document as N-Triples or Turtle by walking the object graph directly, without the raptor serializer or nesting
+        /// @param format ntriples or turtle
+        /// @param buffer Receives the output. If a file handle is given, the buffer is flushed to the file whenever it fills
+        /// @param fh An optional file handle
+        /// @return The total number of bytes serialized
+        size_t serialize_triples(std::string format, std::string& buffer, FILE* fh = NULL);
+
+        /// Serialize TopLevel objects separately as N-Triples or Turtle
+        /// @param objects The TopLevel objects
+        /// @param fragments Receives the triples of each object and its children
+        /// @param header Receives the prefix declarations that precede the triples
+        void serialize_triples_fragments(std::string format, const std::vector<SBOLObject*>& objects, std::vector<std::string>& fragments, std::string& header);
+
+        /// Serialize a TopLevel object and its children as a standalone, nested RDF/XML document
+        std::string serialize_rdfxml_fragment(SBOLObject& obj);
+
+        /// The cached serializations of TopLevel objects, by output format
+        std::unordered_map<std::string, SerializationCache> serialization_caches;
+
+        /// Serialize the Document by re-serializing only the TopLevel objects whose revision changed since the last write, and splicing in the cached text of the others. The output is the same as a full serialization
+        /// @param format rdfxml, ntriples or turtle
+        /// @param buffer Receives the output
+        /// @return False if the output cannot be assembled from fragments, in which case the Document must be serialized in full
+        bool serialize_fragments(std::string format, std::string& buffer);
+
+        /// Propagate the extension namespaces of an object and its children up to the Document, as SBOLObject::serialize does
+        void collect_namespaces(SBOLObject& obj);
+
+        /// Concatenate the cached fragments of every TopLevel object, in the order of a full serialization. The cache is only read
+        void assemble_fragments(const std::string& format, const SerializationCache& cache, std::string& buffer);
+
+        /// Set by freeze
+        bool frozen = false;
+
+        /// Serialize a frozen Document from its cache, if every object in it has been cached in the format. Otherwise, take the lock that serializations of frozen Documents take turns on while they fill their caches
+        /// @return True if the buffer holds the serialization
+        bool serialize_frozen(const std::string& format, std::string& buffer, std::unique_lock<std::mutex>& lock);
+
+        /// Called when a frozen Document is destroyed
+        void release_frozen();
+        
+        /// Destroy all objects and namespaces in the Document and re-initialize its properties, before new contents are read
+        void wipe();
+        
         TopLevel& getTopLevel(std::string);
         raptor_world* getWorld();
         /// @endcond
@@ -153,21 +575,77 @@ namespace sbol {
         /// @tparam SBOLClass The type of SBOL object
         template < class SBOLClass > void add(std::vector < SBOLClass* > sbol_objects);
         
+        /// Register many objects in the Document at once. The URIs of the batch are checked against each other and against the contents of the Document in a single pass before any object is added, so the cost is linear rather than quadratic in the number of objects. If any URI conflicts, no objects are added.
+        /// @param sbol_objects A list of pointers to the SBOL objects you want to add
+        /// @throws SBOLError with DUPLICATE_URI_ERROR listing every conflicting URI
+        void addBatch(std::vector < SBOLObject* > sbol_objects);
+        
         /// Retrieve an object from the Document
         /// @param uri The identity of the SBOL object you want to retrieve
         /// @tparam SBOLClass The type of SBOL object
         template < class SBOLClass > SBOLClass& get(std::string uri);
         
         /// Retrieve a vector of objects from the Document
-        /// @tparam SBOLClass The type of SBOL objects
+        /// @tparam SBOLClass The type of SBOL objects. Objects of classes derived from it are included
         template < class SBOLClass > std::vector<SBOLClass*> getAll();
+        
+        /// Get the values of several properties from every object of one type in a single call, which is much faster than visiting the objects one at a time
+        /// @param object_type The RDF type of the objects, eg, SBOL_COMPONENT_DEFINITION. Child objects, such as SequenceAnnotations, may also be tabulated
+        /// @param property_uris The RDF types of the properties, eg, SBOL_DISPLAY_ID and SBOL_ROLES. For a property that contains child objects, their identities are returned
+        /// @return One column per property, with the objects in the same order in every column
+        std::vector<PropertyColumn> getPropertyColumns(std::string object_type, std::vector<std::string> property_uris);
+        
+        /// Get the value of a property from every object of one type in a single call
+        /// @param object_type The RDF type of the objects, eg, SBOL_SEQUENCE
+        /// @param property_uri The RDF type of the property, eg, SBOL_ELEMENTS
+        /// @return The first value of the property for each object, or an empty string for objects where it is not set
+        std::vector<std::string> getPropertyColumn(std::string object_type, std::string property_uri);
+
+        /// Estimate the memory held by this Document, broken down by category and by SBOL class, in a single pass over its objects
+        /// @param n_largest The number of largest TopLevel objects to report
+        /// @return The breakdown. Each object is counted once, even if it is reachable from several places
+        MemoryUsage memoryUsage(int n_largest = 10);
+
+        /// Make this Document read-only, so that any number of threads may read it at once without locking. The indexes that are otherwise built on demand by queries, text searches and lineage queries are built now. Afterwards, retrieving, iterating, finding, querying, searching and serializing objects do not modify the Document, and any attempt to modify it throws an SBOLError with SBOL_ERROR_FROZEN_DOCUMENT. The first serialization in each format fills the cache of serialized objects under a lock. Later serializations read the cache concurrently
+        void freeze();
+
+        /// @return True if the Document has been frozen
+        bool isFrozen();
+
+        /// Begin a transaction. Until it is committed or rolled back, changes to the properties and child objects of objects in the Document, and the TopLevel objects added to and closed in the Document, are recorded in an undo log, so that they can be undone in time proportional to their number. A transaction begun while another is open is nested in it, and acts as a savepoint. Reading a file or snapshot into the Document is not allowed while a transaction is open
+        void beginTransaction();
+
+        /// Keep the changes made since the innermost open transaction began, and end it. If an outer transaction is open, the changes become part of it and are undone if it is rolled back. Objects closed inside the outermost transaction are deleted when it is committed
+        /// @throws SBOLError with SBOL_ERROR_INVALID_ARGUMENT if no transaction is open
+        void commit();
+
+        /// Undo the changes made since the innermost open transaction began, and end it. Objects created since then are deleted
+        /// @throws SBOLError with SBOL_ERROR_INVALID_ARGUMENT if no transaction is open
+        void rollback();
+
+        /// @return The number of open transactions, counting nested ones
+        int getTransactionDepth();
+
+        /// Register an observer that is notified of every change to the properties and child objects of objects in the Document, the TopLevel objects added to and closed in it, and the URIs changed by SBOL-compliant naming. A rollback reports the changes that undo the rolled back ones. Reading a file, string or snapshot into the Document is reported as a single SBOL_CHANGE_RELOADED change. While no Document has an observer, changes are not tracked at all
+        /// @param observer The observer, which must outlive its registration. An observer registered twice is notified once
+        void addObserver(DocumentObserver& observer);
+
+        /// Unregister an observer. Changes that are queued in an open batch are not delivered to it
+        void removeObserver(DocumentObserver& observer);
+
+        /// Begin a batch. Until the outermost batch ends, changes are queued instead of being reported one by one
+        void beginBatch();
 
-        /// Serialize all objects in this Document to an RDF/XML file
+        /// End a batch. When the outermost batch ends, the queued changes are reported to each observer in a single call
+        /// @throws SBOLError with SBOL_ERROR_INVALID_ARGUMENT if no batch is open
+        void endBatch();
+
+        /// Serialize all objects in this Document to an RDF/XML file. If the filename ends in .gz or .zst the file is compressed with gzip or zstd, at the level set by the compression_level option
         /// @param filename The full name of the file you want to write (including file extension)
         /// @return A string with the validation results, or empty string if validation is disabled
         std::string write(std::string filename);
 
-        /// Read an RDF/XML file and attach the SBOL objects to this Document. Existing contents of the Document will be wiped.
+        /// Read an RDF/XML file and attach the SBOL objects to this Document. Existing contents of the Document will be wiped. gzip- and zstd-compressed files are decompressed as they are read
         /// @param filename The full name of the file you want to read (including file extension)
         void read(std::string filename);
 
@@ -178,10 +656,19 @@ namespace sbol {
         /// Convert data objects in this Document into textual SBOL
         std::string writeString();
         
-        /// Read an RDF/XML file and attach the SBOL objects to this Document. New objects will be added to the existing contents of the Document
+        /// Read an RDF/XML file and attach the SBOL objects to this Document. New objects will be added to the existing contents of the Document. gzip- and zstd-compressed files are decompressed as they are read
         /// @param filename The full name of the file you want to read (including file extension)
         void append(std::string filename);
         
+        /// Save the contents of this Document as a compact binary snapshot. A snapshot loads much faster than RDF/XML because no parsing is required. The format is specific to libSBOL and to the byte order of the machine that wrote it, so use write for data exchange.
+        /// @param filename The full name of the snapshot file
+        void saveSnapshot(std::string filename);
+        
+        /// Load a binary snapshot written by saveSnapshot. The file is memory-mapped and objects are constructed directly from its tables. Existing contents of the Document will be wiped.
+        /// @param filename The full name of the snapshot file
+        /// @throws SBOLError with SBOL_ERROR_SERIALIZATION if the file is not a valid snapshot or was written by an incompatible version
+        void loadSnapshot(std::string filename);
+        
         std::string request_validation(std::string& sbol);
 
         /// Perform comparison on Documents using the online validation tool. This is for cross-validation of SBOL documents with libSBOLj. Document comparison can also be performed using the built-in compare method.
@@ -275,6 +762,58 @@ namespace sbol {
         /// @return A pointer to the SBOLObject, or NULL if an object with this identity doesn't exist
         SBOLObject* find(std::string uri);
         
+        /// Get the provenance ancestors of an object, ie, the objects it was derived from, the Activities that generated it, the entities those Activities used and the Activities that informed them, and so on. The provenance graph is indexed on the first query, so each query takes time proportional to the size of its result
+        /// @param uri The identity of an object
+        /// @param depth The maximum number of provenance relations to follow, or -1 to follow all of them
+        /// @return The identities of the ancestors, nearest first. The object itself is not included
+        std::vector<std::string> ancestors(std::string uri, int depth = -1);
+        
+        /// Get the provenance descendants of an object, ie, the objects derived from it, the Activities that used it, the objects those Activities generated, and so on
+        /// @param uri The identity of an object
+        /// @param depth The maximum number of provenance relations to follow, or -1 to follow all of them
+        /// @return The identities of the descendants, nearest first. The object itself is not included
+        std::vector<std::string> descendants(std::string uri, int depth = -1);
+        
+        /// Find the shortest chain of provenance relations that connects two objects, in either direction
+        /// @param from_uri The identity of the object where the path starts
+        /// @param to_uri The identity of an ancestor or descendant of the first object
+        /// @return The identities of the objects along the path, starting with from_uri and ending with to_uri, or an empty list if the objects are not related
+        std::vector<std::string> lineagePath(std::string from_uri, std::string to_uri);
+
+        /// Add a URI-valued property to the Document's inverted index, so it can be used in queries. Class types, types and roles are indexed by default
+        /// @param property_uri The RDF type of the property, eg, SBOL_ENCODING
+        void indexProperty(std::string property_uri);
+
+        /// Find all objects in the Document, including child objects, that satisfy a condition on their indexed properties. The index is built on the first query and then kept current as objects are edited, so a query takes time proportional to the number of matches rather than the size of the Document
+        /// @param condition A single TermQuery, or several combined with & and |
+        /// @return The matching objects, in no particular order
+        /// @throws SBOLError with SBOL_ERROR_INVALID_ARGUMENT if the condition uses a property that is not indexed
+        std::vector<SBOLObject*> query(TermQuery condition);
+
+        /// Add a text property, such as an annotation, to the Document's full-text index. The displayId, name and description are indexed by default
+        /// @param property_uri The RDF type of the property
+        /// @param weight The rank of a match in this property relative to matches in other properties. Matches in displayIds weigh 4, names 3 and descriptions 1
+        void indexText(std::string property_uri, float weight = 1);
+
+        /// A GENERAL search of the Document, with the same interface as PartShop::search. Search the displayId, name, description and other indexed text properties for words that start with each word of the search text, ignoring case. Records are ranked by relevance, with matches in displayIds and names first. The full-text index is built on the first search and then kept current as objects are edited
+        /// @param search_text The words to search for
+        /// @param object_type The RDF type of the objects to search for, eg, SBOL_COMPONENT_DEFINITION
+        /// @param offset The index of the first record to return. This parameter is indexed starting from zero
+        /// @param limit The total count number of records to return
+        /// @return A SearchResponse, which holds a summary record for each matching object. The caller owns the SearchResponse
+        SearchResponse& search(std::string search_text, std::string object_type = SBOL_COMPONENT_DEFINITION, int offset = 0, int limit = 25);
+
+        /// An ADVANCED search of the Document, with the same interface as PartShop::search. Criteria with a text value are matched against words in indexed text properties, as in a general search, and otherwise must equal a value of the property
+        /// @param q A SearchQuery with an objectType, offset, limit and search criteria
+        /// @return A SearchResponse, which holds a summary record for each matching object. The caller owns the SearchResponse
+        SearchResponse& search(SearchQuery& q);
+
+        /// Returns the number of records for a general search matching the given criteria
+        int searchCount(std::string search_text, std::string object_type = SBOL_COMPONENT_DEFINITION);
+
+        /// Returns the number of records for an advanced search matching the given criteria
+        int searchCount(SearchQuery& q);
+        
         /// @cond
         // Handler-functions for the Raptor library's RDF parsers
         static void parse_objects(void* user_data, raptor_statement* triple);
@@ -283,6 +822,13 @@ namespace sbol {
         void addNamespace(std::string ns, std::string prefix, raptor_serializer* sbol_serializer);
         void parse_annotation_objects();
         void parse_extension_objects();
+        void collect_existing_children();
+
+        // Identities of the child objects already in this Document when a file is appended. On the first parser pass TopLevels and newly parsed child objects are all keys of SBOLObjects, so together these sets identify every object that must not be constructed again
+        std::unordered_set<std::string> existing_children;
+
+        // Recorded by parse_properties for each triple whose value is a parsed object of a class that is not part of the data model. Maps the identity of the referenced object to each referring object and predicate, so parse_annotation_objects can nest annotation objects in their parents without searching the Document
+        std::unordered_map<std::string, std::vector<std::pair<SBOLObject*, rdf_type>>> annotation_references;
 
         SBOLObject* find_property(std::string uri);
         std::vector<SBOLObject*> find_reference(std::string uri);
@@ -356,6 +902,29 @@ namespace sbol {
         
 	};
 
+    /// Opens a bulk insertion scope on a Document. While the scope is open, the URI uniqueness checks that add and create would otherwise run against the whole Document on every call are suspended. Commit the scope to check all URIs in one pass. The scope opens a transaction on the Document, so if the check fails, the objects added, created and removed in the scope are restored and the Document's register is left as it was when the scope was opened.
+    /// Unless an enclosing transaction was opened with beginTransaction, the scope only records changes to the register and to object ownership, not property values, so values set in the scope on objects that existed before it are not restored
+    class SBOL_DECLSPEC BulkInsert
+    {
+    private:
+        Document& doc;
+        bool is_open;
+        /// The number of transactions open on the Document once the scope's own transaction began
+        size_t savepoint;
+        
+    public:
+        /// @param doc The Document that will receive the new objects
+        /// @param expected_size The approximate number of TopLevel objects that will be added, used to pre-size the Document's object register
+        BulkInsert(Document& doc, int expected_size = 0);
+        
+        /// Close the scope and check the URIs of all objects in the Document for uniqueness. If outer scopes are still open, the check is left to the outermost scope.
+        /// @throws SBOLError with DUPLICATE_URI_ERROR listing every conflicting URI, after the changes made in the scope have been rolled back
+        void commit();
+        
+        /// Rolls back the changes made in the scope if commit was not called, for example while an exception is unwinding
+        ~BulkInsert() noexcept;
+    };
+    
     template<>
     void Document::add<Build>(Build& sbol_obj);  // Definition in dbtl.cpp
     
@@ -364,20 +933,27 @@ namespace sbol {
     
 	template <class SBOLClass > void Document::add(SBOLClass& sbol_obj)
 	{
+        check_mutable(this);
 		// Check if the uri is already assigned and delete the object, otherwise it will cause a memory leak!!!
 		//if (SBOLObjects[whatever]!=SBOLObjects.end()) {delete SBOLObjects[whatever]'}
-        if (this->SBOLObjects.find(sbol_obj.identity.get()) != this->SBOLObjects.end())
+        // Inside a BulkInsert scope, duplicates are reported when the scope is committed
+        if (!bulk_insert_depth && this->SBOLObjects.find(sbol_obj.identity.get()) != this->SBOLObjects.end())
             throw SBOLError(DUPLICATE_URI_ERROR, "Cannot add " + sbol_obj.identity.get() + " to Document. An object with this identity is already contained in the Document");
         else
         {
-            // If TopLevel add to Document.
-            if (owned_objects.find(sbol_obj.type) != owned_objects.end())
+            // If TopLevel add to Document. Registered extension classes may not have a store yet
+            const ClassTraits* traits = ClassRegistry::find(sbol_obj.type);
+            record_links(this, &sbol_obj);
+            if (owned_objects.find(sbol_obj.type) != owned_objects.end() || (traits && traits->is_toplevel))
             {
+                record_registration(this, sbol_obj.identity.get());
+                record_object_added(this, sbol_obj.getTypeURI(), &sbol_obj);
                 SBOLObjects[sbol_obj.identity.get()] = (SBOLObject*)&sbol_obj;
                 sbol_obj.parent = this;  // Set back-pointer to parent object
                 this->owned_objects[sbol_obj.getTypeURI()].push_back((SBOLClass*)&sbol_obj);  // Add the object to the Document's property store, eg, componentDefinitions, moduleDefinitions, etc.
             }
             sbol_obj.doc = this;
+            index_new_object(sbol_obj);
             // Recurse into child objects and set their back-pointer to this Document
             for (auto i_store = sbol_obj.owned_objects.begin(); i_store != sbol_obj.owned_objects.end(); ++i_store)
             {
@@ -387,6 +963,8 @@ namespace sbol {
                     this->add<SBOLObject>(**i_obj);
                 }
             }
+            if (sbol_obj.parent == this)
+                notify_change(SBOL_CHANGE_TOPLEVEL_ADDED, this, "", &sbol_obj);
         }
 	};
 
@@ -407,29 +985,48 @@ namespace sbol {
     
 	template <class SBOLClass > SBOLClass& Document::get(std::string uri)
 	{
+        // Objects are checked against the class by its type id. Classes that are not registered, such as TopLevel, are not checked
+        const ClassTraits* traits = ClassRegistry::find<SBOLClass>();
+
         // Search the Document's object store for the uri
-        if (SBOLObjects.find(uri) != SBOLObjects.end())
-            return (SBOLClass &)*(SBOLObjects[uri]);
+        auto i_obj = SBOLObjects.find(uri);
+        if (i_obj != SBOLObjects.end())
+        {
+            if (traits && !ClassRegistry::is_a(i_obj->second, traits->id))
+                throw SBOLError(SBOL_ERROR_TYPE_MISMATCH, "Object " + uri + " is not a " + parseClassName(traits->type));
+            return (SBOLClass &)*(i_obj->second);
+        }
         
         // In SBOLCompliant mode, the user may retrieve an object by persistentIdentity as well
         if (Config::getOption("sbol_compliant_uris").compare("True") == 0)
         {
             std::vector < std::string > ids;  // Contains all URIs contaning the persistentIdentity
-            
-            // Search the Document's object map for  property's object store for all URIs prefixed with the persistentIdentity
-            for (auto i_obj = SBOLObjects.begin(); i_obj != SBOLObjects.end(); ++i_obj)
+            auto match_persistent_id = [&](SBOLObject* obj)
             {
-                std::string obj_id = i_obj->first;
-                SBOLObject* obj = i_obj->second;
-                std::string persistent_id = "";
+                auto i_persistent_id = obj->properties.find(SBOL_PERSISTENT_IDENTITY);
+                if (i_persistent_id == obj->properties.end())
+                    return;
+                std::string& persistent_id = i_persistent_id->second[0];
+                if (persistent_id.size() == uri.size() + 2 && persistent_id.compare(1, uri.size(), uri) == 0)  // Skips the flanking brackets
+                    ids.push_back(obj->identity.get());
+            };
 
-                if (obj->properties.find(SBOL_PERSISTENT_IDENTITY) != obj->properties.end())
+            if (traits && traits->is_toplevel)
+            {
+                // Only the stores of the class and of the classes derived from it are searched
+                for (auto &id : ClassRegistry::derived(traits->id))
                 {
-                    persistent_id = obj->properties[SBOL_PERSISTENT_IDENTITY][0];
-                    persistent_id = persistent_id.substr(1, persistent_id.size() - 2);  // Removes flanking " from the version field
+                    auto i_store = owned_objects.find(ClassRegistry::get(id).store);
+                    if (i_store != owned_objects.end())
+                        for (auto &obj : i_store->second)
+                            match_persistent_id(obj);
                 }
-                if (uri.compare(persistent_id) == 0)
-                    ids.push_back(obj_id);
+            }
+            else
+            {
+                for (auto i_obj = SBOLObjects.begin(); i_obj != SBOLObjects.end(); ++i_obj)
+                    if (!traits || ClassRegistry::is_a(i_obj->second, traits->id))
+                        match_persistent_id(i_obj->second);
             }
             
             // Get the latest version
@@ -437,7 +1034,7 @@ namespace sbol {
             if (ids.size() > 0)
             {
                 uri = ids.back();
-                return (SBOLClass &)*(SBOLObjects[uri]);
+                return (SBOLClass &)*(SBOLObjects.at(uri));
             }
         }
         throw SBOLError(NOT_FOUND_ERROR, "Object " + uri + " not found");
@@ -452,6 +1049,55 @@ namespace sbol {
         SBOLClass* a = new (mem) SBOLClass;
         return (sbol::SBOLObject&)*a;
     };
+
+    /// @cond
+    template < class SBOLClass >
+    bool is_instance(SBOLObject* obj)
+    {
+        return dynamic_cast<SBOLClass*>(obj) != NULL;
+    };
+
+    template < class SBOLClass >
+    ClassTraits ClassRegistry::traits(rdf_type type, rdf_type discriminator)
+    {
+        bool is_toplevel = std::is_base_of<TopLevel, SBOLClass>::value;
+        return { -1, type, std::type_index(typeid(SBOLClass)), (SBOLObject&(*)())&create<SBOLClass>, is_toplevel, is_toplevel ? type : "", discriminator, &is_instance<SBOLClass>, sizeof(SBOLClass) };
+    };
+
+    template < class SBOLClass >
+    int ClassRegistry::add(rdf_type type, rdf_type discriminator)
+    {
+        return add(traits<SBOLClass>(type, discriminator));
+    };
+    /// @endcond
+
+    template < class SBOLClass >
+    std::vector<SBOLClass*> Document::getAll()
+    {
+        std::vector<SBOLClass*> objects;
+        const ClassTraits* traits = ClassRegistry::find<SBOLClass>();
+        if (traits && traits->is_toplevel)
+        {
+            // Instances of a TopLevel class are kept in its own store and the stores of classes derived from it
+            for (auto &id : ClassRegistry::derived(traits->id))
+            {
+                auto i_store = owned_objects.find(ClassRegistry::get(id).store);
+                if (i_store != owned_objects.end())
+                    for (auto &obj : i_store->second)
+                        objects.push_back((SBOLClass*)obj);
+            }
+        }
+        else
+        {
+            for (auto &i_obj : SBOLObjects)
+            {
+                SBOLClass* obj = dynamic_cast<SBOLClass*>(i_obj.second);
+                if (obj)
+                    objects.push_back(obj);
+            }
+        }
+        return objects;
+    };
     
 //    /// @TODO Deprecate this
 //    template <class SBOLClass>
@@ -528,9 +1174,12 @@ namespace sbol {
     template <class SBOLClass>
     SBOLClass& OwnedObject<SBOLClass>::create(std::string uri)
     {
+        check_mutable(this->sbol_owner);
         // This is a roundabout way of checking if SBOLClass is TopLevel in the Document
         SBOLObject* parent_obj = this->sbol_owner;
         SBOLClass* child_obj = new SBOLClass();
+        SBOL_STATS_COUNT("objects_created", 1);
+        record_created(this->sbol_owner, child_obj);
         Document* parent_doc;
         TopLevel* CHECK_TOP_LEVEL = dynamic_cast<TopLevel*>(child_obj);
         parent_doc = this->sbol_owner->doc;
@@ -564,11 +1213,14 @@ namespace sbol {
             std::string child_persistent_id =  persistent_id + "/" + uri;
             std::string child_id = child_persistent_id + "/" + version;
             
-            // Check for uniqueness of URI in the Document
-            if (parent_doc && parent_doc->find(child_id))
-                throw SBOLError(DUPLICATE_URI_ERROR, "An object with URI " + child_id + " is already in the Document");
-            if (this->find(child_id))
-                throw SBOLError(DUPLICATE_URI_ERROR, "An object with URI " + child_id + " is already in the " + this->type + " property");
+            // Check for uniqueness of URI in the Document. Inside a BulkInsert scope, this check is deferred until the scope is committed
+            if (!parent_doc || !parent_doc->bulk_insert_depth)
+            {
+                if (parent_doc && parent_doc->find(child_id))
+                    throw SBOLError(DUPLICATE_URI_ERROR, "An object with URI " + child_id + " is already in the Document");
+                if (this->find(child_id))
+                    throw SBOLError(DUPLICATE_URI_ERROR, "An object with URI " + child_id + " is already in the " + this->type + " property");
+            }
             
             // Initialize SBOLCompliant properties
             child_obj->identity.set(child_id);
@@ -580,20 +1232,27 @@ namespace sbol {
             // this->add(*child_obj);   Can't use this because the add method is prohibited in SBOLCompliant mode!!!
             child_obj->parent = parent_obj;  // Set back-pointer to parent object
             std::vector< sbol::SBOLObject* >& object_store = this->sbol_owner->owned_objects[this->type];
+            record_object_added(this->sbol_owner, this->type, child_obj);
             object_store.push_back((SBOLObject*)child_obj);
+            notify_property_change(this->sbol_owner, this->type);
+            notify_change(SBOL_CHANGE_OBJECT_ADDED, this->sbol_owner, this->type, child_obj);
 
             // The following effectively adds the child object to the Document by setting its back-pointer.  However, the Document itself only maintains a register of TopLevel objects, otherwise the returned object will not be registered
             if (parent_doc)
                 child_obj->doc = parent_doc;
             if (CHECK_TOP_LEVEL && parent_doc)
+            {
+                record_registration(parent_doc, child_id);
                 parent_doc->SBOLObjects[child_id] = (SBOLObject*)child_obj;
+                notify_change(SBOL_CHANGE_TOPLEVEL_ADDED, parent_doc, "", child_obj);
+            }
             
             this->validate(child_obj);
             return *child_obj;
         }
         else
         {
-            if (parent_doc && parent_doc->find(uri))
+            if (parent_doc && !parent_doc->bulk_insert_depth && parent_doc->find(uri))
                 throw SBOLError(DUPLICATE_URI_ERROR, "An object with URI " + uri + " is already in the Document");
             
             // Construct a new child object
@@ -617,6 +1276,7 @@ namespace sbol {
     template < class SBOLSubClass >
     SBOLSubClass& OwnedObject<SBOLClass>::create(std::string uri)
     {
+        check_mutable(this->sbol_owner);
         // This is a roundabout way of checking if SBOLClass is TopLevel in the Document
         int CHECK_TOP_LEVEL;
         Document* parent_doc = dynamic_cast<Document*>(this->sbol_owner);
@@ -655,14 +1315,19 @@ namespace sbol {
             std::string child_persistent_id =  persistent_id + "/" + uri;
             std::string child_id = child_persistent_id + "/" + version;
             
-            // Check for uniqueness of URI in the Document
-            if (parent_doc && parent_doc->find(child_id))
-                throw SBOLError(DUPLICATE_URI_ERROR, "An object with URI " + child_id + " is already in the Document");
-            if (this->find(child_id))
-                throw SBOLError(DUPLICATE_URI_ERROR, "An object with URI " + child_id + " is already in the " + this->type + " property");
+            // Check for uniqueness of URI in the Document. Inside a BulkInsert scope, this check is deferred until the scope is committed
+            if (!parent_doc || !parent_doc->bulk_insert_depth)
+            {
+                if (parent_doc && parent_doc->find(child_id))
+                    throw SBOLError(DUPLICATE_URI_ERROR, "An object with URI " + child_id + " is already in the Document");
+                if (this->find(child_id))
+                    throw SBOLError(DUPLICATE_URI_ERROR, "An object with URI " + child_id + " is already in the " + this->type + " property");
+            }
 
             // Construct a new child object
             SBOLSubClass* child_obj = new SBOLSubClass();
+            SBOL_STATS_COUNT("objects_created", 1);
+            record_created(this->sbol_owner, child_obj);
             
             // Initialize SBOLCompliant properties
             child_obj->identity.set(child_id);
@@ -674,24 +1339,33 @@ namespace sbol {
             // this->add(*child_obj);   Can't use this because the add method is prohibited in SBOLCompliant mode!!!
             child_obj->parent = parent_obj;  // Set back-pointer to parent object
             std::vector< sbol::SBOLObject* >& object_store = this->sbol_owner->owned_objects[this->type];
+            record_object_added(this->sbol_owner, this->type, child_obj);
             object_store.push_back(child_obj);
+            notify_property_change(this->sbol_owner, this->type);
+            notify_change(SBOL_CHANGE_OBJECT_ADDED, this->sbol_owner, this->type, child_obj);
             
             // The following effectively adds the child object to the Document by setting its back-pointer.  However, the Document itself only maintains a register of TopLevel objects, otherwise the returned object will not be registered
             if (parent_doc)
                 child_obj->doc = parent_doc;
             if (CHECK_TOP_LEVEL)
+            {
+                record_registration(parent_doc, child_id);
                 parent_doc->SBOLObjects[child_id] = (SBOLObject*)child_obj;
+                notify_change(SBOL_CHANGE_TOPLEVEL_ADDED, parent_doc, "", child_obj);
+            }
 
             this->validate(child_obj);
             return *child_obj;
         }
         else
         {
-            if (parent_doc && parent_doc->find(uri))
+            if (parent_doc && !parent_doc->bulk_insert_depth && parent_doc->find(uri))
                 throw SBOLError(DUPLICATE_URI_ERROR, "An object with URI " + uri + " is already in the Document");
             
             // Construct an SBOLObject with emplacement
             SBOLSubClass* child_obj = new SBOLSubClass(uri);
+            SBOL_STATS_COUNT("objects_created", 1);
+            record_created(this->sbol_owner, child_obj);
             Identified* parent_obj = (Identified*)this->sbol_owner;
             
             child_obj->identity.set(uri);
@@ -711,6 +1385,7 @@ namespace sbol {
     template < class SBOLClass>
     void OwnedObject<SBOLClass>::set(SBOLClass& sbol_obj)
     {
+        check_mutable(this->sbol_owner);
         TopLevel* check_top_level = dynamic_cast<TopLevel*>(&sbol_obj);
         if (check_top_level && this->sbol_owner->doc)
         {
@@ -720,13 +1395,21 @@ namespace sbol {
         
         // Add to parent object
         if (!this->sbol_owner->owned_objects[this->type].size())
+        {
+            record_object_added(this->sbol_owner, this->type, &sbol_obj);
             this->sbol_owner->owned_objects[this->type].push_back((SBOLObject *)&sbol_obj);
+        }
         else
             throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "This property is already set. Call remove before attempting to overwrite the value.");
+        record_links(this->sbol_owner, &sbol_obj);
         sbol_obj.parent = this->sbol_owner;  // Set back-pointer to parent object
+        if (this->sbol_owner->doc)
+            this->sbol_owner->doc->index_new_object(sbol_obj);
         
         // Update URI for the argument object and all its children, if SBOL-compliance is enabled.
         sbol_obj.update_uri();
+        notify_property_change(this->sbol_owner, this->type);
+        notify_change(SBOL_CHANGE_OBJECT_ADDED, this->sbol_owner, this->type, &sbol_obj);
         
         // Run validation rules
         this->validate(&sbol_obj);
@@ -735,6 +1418,7 @@ namespace sbol {
     template <class SBOLClass>
     void OwnedObject<SBOLClass>::add(SBOLClass& sbol_obj)
     {
+        check_mutable(this->sbol_owner);
         if (this->sbol_owner)
         {
             TopLevel* check_top_level = dynamic_cast<TopLevel*>(&sbol_obj);
@@ -746,21 +1430,27 @@ namespace sbol {
             else
             {
                 std::vector< sbol::SBOLObject* >& object_store = this->sbol_owner->owned_objects[this->type];
-                if (std::find(object_store.begin(), object_store.end(), &sbol_obj) != object_store.end())
+                bool defer_checks = this->sbol_owner->doc && this->sbol_owner->doc->bulk_insert_depth;
+                if (!defer_checks && std::find(object_store.begin(), object_store.end(), &sbol_obj) != object_store.end())
                     throw SBOLError(DUPLICATE_URI_ERROR, "The object " + sbol_obj.identity.get() + " is already contained by the " + this->type + " property");
 
                 // Add to Document and check for uniqueness of URI
+                record_links(this->sbol_owner, &sbol_obj);
                 if (this->sbol_owner->doc)
                 {
                     sbol_obj.doc = this->sbol_owner->doc;
+                    sbol_obj.doc->index_new_object(sbol_obj);
                 }
                 
                 // Add to parent object
+                record_object_added(this->sbol_owner, this->type, &sbol_obj);
                 object_store.push_back((SBOLObject *)&sbol_obj);
                 sbol_obj.parent = this->sbol_owner;  // Set back-pointer to parent object
                 
                 // Update URI for the argument object and all its children, if SBOL-compliance is enabled.
                 sbol_obj.update_uri();
+                notify_property_change(this->sbol_owner, this->type);
+                notify_change(SBOL_CHANGE_OBJECT_ADDED, this->sbol_owner, this->type, &sbol_obj);
                 
                 // Run validation rules
                 this->validate(&sbol_obj);
@@ -1192,6 +1882,7 @@ namespace sbol {
         
         PyObject* create(std::string uri)
         {
+            check_mutable(this->sbol_owner);
             // This is a roundabout way of checking if SBOLClass is TopLevel in the Document
             int CHECK_TOP_LEVEL;
             Document* parent_doc = dynamic_cast<Document*>(this->sbol_owner);
@@ -1237,7 +1928,7 @@ namespace sbol {
                 std::string child_id = child_persistent_id + "/" + version;
                 
                 // Check for uniqueness of URI in the Document
-                if (parent_doc && parent_doc->find(child_id))
+                if (parent_doc && !parent_doc->bulk_insert_depth && parent_doc->find(child_id))
                     throw SBOLError(DUPLICATE_URI_ERROR, "An object with URI " + child_id + " is already in the Document");
                 
                 // Construct a new child object
@@ -1254,13 +1945,20 @@ namespace sbol {
                 // this->add(*child_obj);   Can't use this because the add method is prohibited in SBOLCompliant mode!!!
                 child_obj->parent = parent_obj;  // Set back-pointer to parent object
                 std::vector< sbol::SBOLObject* >& object_store = this->sbol_owner->owned_objects[this->type];
+                record_object_added(this->sbol_owner, this->type, child_obj);
                 object_store.push_back((SBOLObject*)child_obj);
+                notify_property_change(this->sbol_owner, this->type);
+                notify_change(SBOL_CHANGE_OBJECT_ADDED, this->sbol_owner, this->type, child_obj);
                 
                 // The following effectively adds the child object to the Document by setting its back-pointer.  However, the Document itself only maintains a register of TopLevel objects, otherwise the returned object will not be registered
                 if (parent_doc)
                     child_obj->doc = parent_doc;
                 if (CHECK_TOP_LEVEL)
+                {
+                    record_registration(parent_doc, child_id);
                     parent_doc->SBOLObjects[child_id] = (SBOLObject*)child_obj;
+                    notify_change(SBOL_CHANGE_TOPLEVEL_ADDED, parent_doc, "", child_obj);
+                }
                 
                 this->sbol_owner->PythonObjects[child_id] = py_obj;
                 return py_obj;
@@ -1282,7 +1980,10 @@ namespace sbol {
                 
                 // Add to this property's object store
                 std::vector< sbol::SBOLObject* >& object_store = this->sbol_owner->owned_objects[this->type];
+                record_object_added(this->sbol_owner, this->type, child_obj);
                 object_store.push_back((SBOLObject*)child_obj);
+                notify_property_change(this->sbol_owner, this->type);
+                notify_change(SBOL_CHANGE_OBJECT_ADDED, this->sbol_owner, this->type, child_obj);
                 
 //                this->add(*child_obj);
                 // Set pointer to Document
@@ -1390,6 +2091,7 @@ namespace sbol {
     template <class SBOLClass>
     SBOLClass& OwnedObject<SBOLClass>::remove(std::string uri)
     {
+        check_mutable(this->sbol_owner);
         if (this->sbol_owner)
         {
 
@@ -1402,15 +2104,27 @@ namespace sbol {
                     SBOLObject* obj = object_store[i_obj];
                     if (uri.compare(obj->identity.get()) == 0)
                     {
+                        record_object_removed(this->sbol_owner, this->type, i_obj);
                         this->sbol_owner->owned_objects[this->type].erase( this->sbol_owner->owned_objects[this->type].begin() + i_obj);
+                        notify_property_change(this->sbol_owner, this->type);
+                        notify_change(SBOL_CHANGE_OBJECT_REMOVED, this->sbol_owner, this->type, obj);
+                        if (obj->doc)
+                            obj->doc->unindex_object(*obj);
 
                         // Erase TopLevel objects from Document
                         if (this->sbol_owner->type == SBOL_DOCUMENT)
+                        {
+                            record_registration(this->sbol_owner, uri);
                             obj->doc->SBOLObjects.erase(uri);
+                            notify_change(SBOL_CHANGE_TOPLEVEL_CLOSED, this->sbol_owner, "", obj);
+                        }
                         
                         // Erase nested, hidden TopLevel objects from Document
                         if (obj->doc && !obj->doc->find(uri))
+                        {
+                            record_links(this->sbol_owner, obj);
                             obj->doc = NULL;
+                        }
                         SBOLClass* cast_obj = dynamic_cast<SBOLClass*>(cast_obj);
                         return *cast_obj;
                     }
@@ -1452,17 +2166,23 @@ namespace sbol {
     template <class SBOLClass>
     void OwnedObject<SBOLClass>::clear()
     {
+        check_mutable(this->sbol_owner);
         if (this->sbol_owner)
         {
             if (this->sbol_owner->owned_objects.find(this->type) != this->sbol_owner->owned_objects.end())
             {
-                std::vector<SBOLObject*>& object_store = this->sbol_owner->owned_objects[this->type];
-                for (auto i_obj = object_store.begin(); i_obj != object_store.end(); ++i_obj)
+                std::vector<SBOLObject*> removed_objects;
+                record_object_store(this->sbol_owner, this->type);
+                removed_objects.swap(this->sbol_owner->owned_objects[this->type]);
+                notify_property_change(this->sbol_owner, this->type);
+                for (auto i_obj = removed_objects.begin(); i_obj != removed_objects.end(); ++i_obj)
                 {
                     SBOLObject* obj = *i_obj;
-                    obj->close();
+                    notify_change(SBOL_CHANGE_OBJECT_REMOVED, this->sbol_owner, this->type, obj);
+                    if (this->sbol_owner->doc)
+                        this->sbol_owner->doc->unindex_object(*obj);
+                    release_object(this->sbol_owner, obj);
                 }
-                object_store.clear();
             }
         }
     };
@@ -1499,6 +2219,8 @@ namespace sbol {
     {
         std::string uri = ns + class_name;
         SBOL_DATA_MODEL_REGISTER.insert(make_pair(uri, (SBOLObject&(*)())&create<ExtensionClass>));
+        if (!ClassRegistry::find(uri))
+            ClassRegistry::add<ExtensionClass>(uri);
         namespaces[ns_prefix] = ns;  // Register extension namespace
     };
 
@@ -0,0 +1,185 @@
+/**
+ * @file    fragments.cpp
+ * @brief   Incremental serialization of Documents from the cached text of unchanged TopLevel objects
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+#include "document.h"
+
+#include <algorithm>
+
+using namespace sbol;
+using namespace std;
+
+namespace
+{
+    // A key for the Document's namespaces that does not depend on the order of the hash table
+    string namespace_key(const unordered_map<string, string>& namespaces)
+    {
+        map<string, string> sorted_namespaces(namespaces.begin(), namespaces.end());
+        string key;
+        for (auto & i_ns : sorted_namespaces)
+            key += i_ns.first + "\n" + i_ns.second + "\n";
+        return key;
+    };
+
+    // Split a standalone RDF/XML document into the rdf:RDF start tag, the body and the end tag
+    bool split_rdfxml(const string& rdfxml, string& header, string& body, string& footer)
+    {
+        size_t root = rdfxml.find("<rdf:RDF");
+        size_t body_start = rdfxml.find('\n', rdfxml.find('>', root));
+        size_t body_end = rdfxml.rfind("</rdf:RDF>");
+        if (root == string::npos || body_start == string::npos || body_end == string::npos || body_end <= body_start)
+            return false;
+        ++body_start;
+        header = rdfxml.substr(0, body_start);
+        body = rdfxml.substr(body_start, body_end - body_start);
+        footer = rdfxml.substr(body_end);
+        return true;
+    };
+}
+
+void Document::collect_namespaces(SBOLObject& obj)
+{
+    for (auto & i_ns : obj.namespaces)
+    {
+        // Namespaces already declared are not assigned again, so that a frozen Document is not modified
+        auto i_declared = namespaces.find(i_ns.first);
+        if (i_declared == namespaces.end() || i_declared->second != i_ns.second)
+            namespaces[i_ns.first] = i_ns.second;
+    }
+    for (auto & i_store : obj.owned_objects)
+        for (auto & child : i_store.second)
+            collect_namespaces(*child);
+};
+
+bool Document::serialize_fragments(std::string format, std::string& buffer)
+{
+    SBOL_STATS_TIMER("serialize");
+    bool rdfxml = (format == "rdfxml");
+    if (rdfxml && SBOLObjects.empty())
+        return false;  // There is no fragment to take the rdf:RDF element from
+    SerializationCache& cache = serialization_caches[format];
+
+    // Find the objects that changed since they were cached. The extension namespaces of the others were propagated to the Document when they were cached
+    vector<SBOLObject*> stale;
+    for (auto & i_obj : SBOLObjects)
+    {
+        auto i_fragment = cache.fragments.find(i_obj.second);
+        if (i_fragment == cache.fragments.end() || i_fragment->second.revision != i_obj.second->revision)
+        {
+            stale.push_back(i_obj.second);
+            collect_namespaces(*i_obj.second);
+        }
+    }
+
+    // Every fragment depends on the Document's namespaces, which abbreviate the URIs in it
+    string ns_key = namespace_key(namespaces);
+    if (ns_key != cache.namespaces)
+    {
+        cache.fragments.clear();
+        stale.clear();
+        for (auto & i_obj : SBOLObjects)
+        {
+            stale.push_back(i_obj.second);
+            collect_namespaces(*i_obj.second);
+        }
+        cache.namespaces = namespace_key(namespaces);
+    }
+    SBOL_STATS_COUNT("fragments_serialized", stale.size());
+    SBOL_STATS_COUNT("fragments_reused", SBOLObjects.size() - stale.size());
+
+    if (rdfxml)
+    {
+        string header, body, footer;
+        for (auto obj : stale)
+        {
+            // Namespaces that are not declared by the Document are declared where they are used, with prefixes numbered across the whole output
+            if (!split_rdfxml(serialize_rdfxml_fragment(*obj), header, body, footer) || body.find("xmlns:") != string::npos)
+            {
+                cache.fragments.clear();
+                cache.namespaces.clear();  // The cache is kept, though empty, since readers of a frozen Document may be looking it up
+                return false;
+            }
+            cache.header = header;
+            cache.footer = footer;
+            cache.fragments[obj] = { obj->revision, body };
+        }
+    }
+    else
+    {
+        vector<string> texts;
+        serialize_triples_fragments(format, stale, texts, cache.header);
+        for (size_t i_obj = 0; i_obj < stale.size(); ++i_obj)
+            cache.fragments[stale[i_obj]] = { stale[i_obj]->revision, std::move(texts[i_obj]) };
+    }
+
+    // Drop the fragments of objects that were removed from the Document
+    if (cache.fragments.size() > SBOLObjects.size())
+    {
+        unordered_map<SBOLObject*, SerializedFragment> fragments;
+        for (auto & i_obj : SBOLObjects)
+            fragments[i_obj.second] = std::move(cache.fragments[i_obj.second]);
+        cache.fragments.swap(fragments);
+    }
+
+    assemble_fragments(format, cache, buffer);
+    if (frozen)
+        cache.complete.value.store(true, memory_order_release);
+    return true;
+};
+
+void Document::assemble_fragments(const std::string& format, const SerializationCache& cache, std::string& buffer)
+{
+    // The triple formats are written in the order of the register. RDF/XML is written in the order of the raptor serializer, which sorts subjects by URI
+    vector<const SerializedFragment*> fragments;
+    fragments.reserve(SBOLObjects.size());
+    for (auto & i_obj : SBOLObjects)
+        fragments.push_back(&cache.fragments.find(i_obj.second)->second);
+    if (format == "rdfxml")
+    {
+        vector<pair<const string*, const SerializedFragment*>> sorted;
+        sorted.reserve(SBOLObjects.size());
+        size_t i_fragment = 0;
+        for (auto & i_obj : SBOLObjects)
+            sorted.push_back({ &i_obj.second->properties.find(SBOL_IDENTITY)->second.front(), fragments[i_fragment++] });
+        std::sort(sorted.begin(), sorted.end(), [](const pair<const string*, const SerializedFragment*>& a, const pair<const string*, const SerializedFragment*>& b)
+        {
+            // Identities are stored with flanking angle brackets, which must not take part in the comparison
+            const string& uri_a = *a.first;
+            const string& uri_b = *b.first;
+            return uri_a.compare(1, uri_a.size() - 2, uri_b, 1, uri_b.size() - 2) < 0;
+        });
+        for (size_t i = 0; i < sorted.size(); ++i)
+            fragments[i] = sorted[i].second;
+    }
+
+    size_t size = cache.header.size() + cache.footer.size();
+    for (auto fragment : fragments)
+        size += fragment->text.size();
+    buffer.clear();
+    buffer.reserve(size);
+    buffer += cache.header;
+    for (auto fragment : fragments)
+        buffer += fragment->text;
+    buffer += cache.footer;
+};
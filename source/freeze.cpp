@@ -0,0 +1,135 @@
+/**
+ * @file    freeze.cpp
+ * @brief   Read-only Documents that many threads can read at once, and property values pinned while they are viewed
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+
+#include "document.h"
+
+using namespace sbol;
+using namespace std;
+
+namespace
+{
+    // While no Document is frozen, modifications are not checked
+    atomic<int> n_frozen_documents(0);
+
+    // Serializations of frozen Documents take turns on this lock until their caches are complete
+    mutex frozen_serialization_lock;
+
+    // While no property values are pinned, the pins are not looked up
+    atomic<int> n_pinned_values(0);
+    mutex pinned_values_lock;
+    map< pair<SBOLObject*, rdf_type>, int > pinned_values;
+}
+
+void sbol::check_mutable(SBOLObject* owner, const rdf_type& property_type)
+{
+    if (!owner)
+        return;
+    if (n_pinned_values.load(memory_order_relaxed) && property_type.size())
+    {
+        lock_guard<mutex> lock(pinned_values_lock);
+        if (pinned_values.count({ owner, property_type }))
+            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot modify " + property_type + " while a view of its values is in use");
+    }
+    if (!n_frozen_documents.load(memory_order_relaxed))
+        return;
+    Document* doc = owning_document(owner);
+    if (doc && doc->frozen)
+        throw SBOLError(SBOL_ERROR_FROZEN_DOCUMENT, "Cannot modify a frozen Document");
+};
+
+void sbol::pin_values(SBOLObject* owner, const rdf_type& property_type)
+{
+    lock_guard<mutex> lock(pinned_values_lock);
+    ++pinned_values[{ owner, property_type }];
+    ++n_pinned_values;
+};
+
+void sbol::unpin_values(SBOLObject* owner, const rdf_type& property_type)
+{
+    lock_guard<mutex> lock(pinned_values_lock);
+    auto i_pin = pinned_values.find({ owner, property_type });
+    if (i_pin == pinned_values.end())
+        return;
+    if (--i_pin->second == 0)
+        pinned_values.erase(i_pin);
+    --n_pinned_values;
+};
+
+void Document::freeze()
+{
+    if (frozen)
+        return;
+    SBOL_STATS_TIMER("freeze");
+
+    // Build the indexes that are otherwise built by the first query, so that queries only read them
+    index_terms();
+    index_text();
+    index_lineage();
+
+    // The namespaces of extension objects are propagated to the Document, and the serialization caches are created, before any reader can look them up
+    for (auto & i_obj : SBOLObjects)
+        collect_namespaces(*i_obj.second);
+    for (auto format : { "rdfxml", "ntriples", "turtle" })
+        serialization_caches[format];
+
+    frozen = true;
+    ++n_frozen_documents;
+};
+
+bool Document::isFrozen()
+{
+    return frozen;
+};
+
+void Document::release_frozen()
+{
+    if (!frozen)
+        return;
+    frozen = false;
+    --n_frozen_documents;
+};
+
+bool Document::serialize_frozen(const std::string& format, std::string& buffer, std::unique_lock<std::mutex>& lock)
+{
+    auto i_cache = serialization_caches.find(format);
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        if (i_cache != serialization_caches.end() && i_cache->second.complete.value.load(memory_order_acquire))
+        {
+            SBOL_STATS_TIMER("serialize");
+            SBOL_STATS_COUNT("fragments_reused", SBOLObjects.size());
+            assemble_fragments(format, i_cache->second, buffer);
+            SBOL_STATS_COUNT("bytes_serialized", buffer.size());
+            if (lock.owns_lock())
+                lock.unlock();
+            return true;
+        }
+        // The cache may be completed by another thread while this one waits for the lock
+        if (!attempt)
+            lock = unique_lock<mutex>(frozen_serialization_lock);
+    }
+    return false;
+};
@@ -51,6 +51,8 @@ namespace sbol
         name(this, SBOL_NAME, '0', '1', ValidationRules({})),
         description(this, SBOL_DESCRIPTION, '0', '1', ValidationRules({}))
         {
+            if (DeserializationScope::active())
+                return;  // The parser assigns the identity and all other values from the triple store
             if(Config::getOption("sbol_compliant_uris").compare("True") == 0)
             {
                 displayId.set(uri);
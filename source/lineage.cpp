@@ -0,0 +1,174 @@
+/**
+ * @file    lineage.cpp
+ * @brief   Indexed provenance lineage queries
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+
+#include "document.h"
+
+#include <deque>
+#include <unordered_set>
+
+using namespace sbol;
+using namespace std;
+
+namespace
+{
+    // The properties whose values become edges of the provenance graph
+    const rdf_type lineage_properties[] = { SBOL_WAS_DERIVED_FROM, PROVO_WAS_GENERATED_BY, PROVO_WAS_INFORMED_BY, PROVO_ENTITY };
+
+    // Add edges from an object to each URI value of one of its properties
+    void add_lineage_edges(Document& doc, const string& uri, SBOLObject& obj, const rdf_type& property_type)
+    {
+        auto i_property = obj.properties.find(property_type);
+        if (i_property == obj.properties.end())
+            return;
+        for (auto & value : i_property->second)
+        {
+            if (value.length() <= 2 || value.front() != '<')
+                continue;  // Unset property
+            string parent_uri = value.substr(1, value.length() - 2);
+            doc.lineage_parents[uri].push_back(parent_uri);
+            doc.lineage_children[parent_uri].push_back(uri);
+        }
+    };
+
+    // Breadth-first search over one direction of the provenance graph. The search only touches the nodes it returns and their edges
+    vector<string> traverse_lineage(const unordered_map<string, vector<string>>& edges, const string& start, int depth, const string& goal = "")
+    {
+        vector<string> visited_order;
+        unordered_map<string, string> came_from;
+        came_from[start] = "";
+        deque<pair<string, int>> queue = { { start, 0 } };
+        while (queue.size())
+        {
+            string uri = queue.front().first;
+            int distance = queue.front().second;
+            queue.pop_front();
+            if (depth >= 0 && distance >= depth)
+                continue;
+            auto i_edges = edges.find(uri);
+            if (i_edges == edges.end())
+                continue;
+            for (auto & next_uri : i_edges->second)
+            {
+                if (came_from.find(next_uri) != came_from.end())
+                    continue;
+                came_from[next_uri] = uri;
+                if (next_uri == goal)
+                {
+                    // Walk back to the start to recover the path
+                    vector<string> path = { goal };
+                    for (string step = uri; step != ""; step = came_from[step])
+                        path.push_back(step);
+                    std::reverse(path.begin(), path.end());
+                    return path;
+                }
+                visited_order.push_back(next_uri);
+                queue.push_back({ next_uri, distance + 1 });
+            }
+        }
+        if (goal != "")
+            return {};
+        return visited_order;
+    };
+}
+
+void Document::index_lineage()
+{
+    if (lineage_valid)
+        return;
+    SBOL_STATS_TIMER("index_lineage");
+    lineage_parents.clear();
+    lineage_children.clear();
+
+    // Walk every object in the Document once. Usages are not nodes of the graph. Instead, an Activity links directly to the entities its Usages refer to
+    vector<SBOLObject*> stack;
+    for (auto & i_obj : SBOLObjects)
+        stack.push_back(i_obj.second);
+    while (stack.size())
+    {
+        SBOLObject& obj = *stack.back();
+        stack.pop_back();
+        string uri = obj.identity.get();
+        add_lineage_edges(*this, uri, obj, SBOL_WAS_DERIVED_FROM);
+        add_lineage_edges(*this, uri, obj, PROVO_WAS_GENERATED_BY);
+        if (obj.type == PROVO_ACTIVITY)
+        {
+            add_lineage_edges(*this, uri, obj, PROVO_WAS_INFORMED_BY);
+            auto i_usages = obj.owned_objects.find(PROVO_QUALIFIED_USAGE);
+            if (i_usages != obj.owned_objects.end())
+                for (auto & usage : i_usages->second)
+                    add_lineage_edges(*this, uri, *usage, PROVO_ENTITY);
+        }
+        for (auto & i_store : obj.owned_objects)
+            for (auto & child : i_store.second)
+                stack.push_back(child);
+    }
+    SBOL_STATS_COUNT("lineage_nodes", lineage_parents.size());
+    lineage_valid = true;
+};
+
+bool Document::carries_lineage(SBOLObject& obj)
+{
+    vector<SBOLObject*> stack = { &obj };
+    while (stack.size())
+    {
+        SBOLObject& carrier = *stack.back();
+        stack.pop_back();
+        for (auto & property_type : lineage_properties)
+        {
+            auto i_property = carrier.properties.find(property_type);
+            if (i_property != carrier.properties.end())
+                for (auto & value : i_property->second)
+                    if (value.length() > 2 && value.front() == '<')
+                        return true;
+        }
+        for (auto & i_store : carrier.owned_objects)
+            stack.insert(stack.end(), i_store.second.begin(), i_store.second.end());
+    }
+    return false;
+};
+
+vector<string> Document::ancestors(string uri, int depth)
+{
+    index_lineage();
+    return traverse_lineage(lineage_parents, uri, depth);
+};
+
+vector<string> Document::descendants(string uri, int depth)
+{
+    index_lineage();
+    return traverse_lineage(lineage_children, uri, depth);
+};
+
+vector<string> Document::lineagePath(string from_uri, string to_uri)
+{
+    if (from_uri == to_uri)
+        return { from_uri };
+    index_lineage();
+    vector<string> path = traverse_lineage(lineage_parents, from_uri, -1, to_uri);
+    if (path.empty())
+        path = traverse_lineage(lineage_children, from_uri, -1, to_uri);
+    return path;
+};
@@ -0,0 +1,303 @@
+/**
+ * @file    memory.cpp
+ * @brief   Estimates of the memory held by Documents and their objects
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+
+#include "document.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <typeinfo>
+
+using namespace sbol;
+using namespace std;
+
+namespace
+{
+    // The heap memory owned by a value, excluding the value itself. Containers are counted at their capacity, with the nodes of node-based
+    // containers estimated from the layout of the common standard libraries
+    template < class T > size_t heap(const T&) { return 0; };
+    size_t heap(const string& value);
+    size_t heap(const SerializedFragment& fragment);
+    size_t heap(const SerializationCache& cache);
+    template < class A, class B > size_t heap(const pair<A, B>& value);
+    template < class T > size_t heap(const vector<T>& values);
+    template < class K, class V > size_t heap(const map<K, V>& values);
+    template < class K, class V > size_t heap(const unordered_map<K, V>& values);
+    template < class K > size_t heap(const unordered_set<K>& values);
+
+    size_t heap(const string& value)
+    {
+        static const size_t small_capacity = string().capacity();  // Short strings are stored inside the string object
+        return value.capacity() > small_capacity ? value.capacity() + 1 : 0;
+    };
+
+    size_t heap(const SerializedFragment& fragment)
+    {
+        return heap(fragment.text);
+    };
+
+    size_t heap(const SerializationCache& cache)
+    {
+        return heap(cache.namespaces) + heap(cache.header) + heap(cache.footer) + heap(cache.fragments);
+    };
+
+    template < class A, class B > size_t heap(const pair<A, B>& value)
+    {
+        return heap(value.first) + heap(value.second);
+    };
+
+    template < class T > size_t heap(const vector<T>& values)
+    {
+        size_t size = values.capacity() * sizeof(T);
+        for (auto & value : values)
+            size += heap(value);
+        return size;
+    };
+
+    template < class K, class V > size_t heap(const map<K, V>& values)
+    {
+        size_t size = values.size() * (4 * sizeof(void*) + sizeof(pair<const K, V>));  // Color, parent and child links
+        for (auto & value : values)
+            size += heap(value.first) + heap(value.second);
+        return size;
+    };
+
+    template < class K, class V > size_t heap(const unordered_map<K, V>& values)
+    {
+        size_t size = values.bucket_count() * sizeof(void*) + values.size() * (2 * sizeof(void*) + sizeof(pair<const K, V>));  // Next link and cached hash
+        for (auto & value : values)
+            size += heap(value.first) + heap(value.second);
+        return size;
+    };
+
+    template < class K > size_t heap(const unordered_set<K>& values)
+    {
+        size_t size = values.bucket_count() * sizeof(void*) + values.size() * (2 * sizeof(void*) + sizeof(K));
+        for (auto & value : values)
+            size += heap(value);
+        return size;
+    };
+
+    const char* CATEGORIES[] = { "objects", "property_strings", "owned_object_vectors", "maps", "namespaces", "annotation_objects", "indexes" };
+}
+
+MemoryUsage Document::memoryUsage(int n_largest)
+{
+    MemoryUsage usage;
+    for (auto category : CATEGORIES)
+        usage.categories[category] = 0;
+
+    // Visits each object once and attributes its memory to a category and to its class
+    struct Measurement
+    {
+        MemoryUsage& usage;
+        unordered_set<SBOLObject*> visited;
+
+        Measurement(MemoryUsage& usage) : usage(usage) {};
+
+        // Measure the fields of one object, excluding its children
+        void measure_fields(SBOLObject& obj, map<string, size_t>& categories)
+        {
+            const ClassTraits* traits = ClassRegistry::find(type_index(typeid(obj)));
+            size_t size = traits ? traits->size : (dynamic_cast<Document*>(&obj) ? sizeof(Document) : dynamic_cast<TopLevel*>(&obj) ? sizeof(TopLevel) : sizeof(SBOLObject));
+            for (auto & i_property : obj.properties)
+            {
+                size += heap(i_property.first);  // Each member property keeps a copy of its URI
+                categories["property_strings"] += heap(i_property.second);
+            }
+            for (auto & i_store : obj.owned_objects)
+            {
+                size += heap(i_store.first);
+                categories["owned_object_vectors"] += i_store.second.capacity() * sizeof(SBOLObject*);
+            }
+            categories["objects"] += size;
+            categories["property_strings"] += heap(obj.hidden_properties);
+            categories["maps"] += obj.properties.size() * (4 * sizeof(void*) + sizeof(pair<const rdf_type, vector<string>>)) + obj.owned_objects.size() * (4 * sizeof(void*) + sizeof(pair<const rdf_type, vector<SBOLObject*>>));
+            for (auto & i_property : obj.properties)
+                categories["maps"] += heap(i_property.first);
+            for (auto & i_store : obj.owned_objects)
+                categories["maps"] += heap(i_store.first);
+            categories["namespaces"] += heap(obj.namespaces);
+        };
+
+        // Measure an object and its children. Returns their total size
+        size_t measure(SBOLObject* obj, bool in_annotation)
+        {
+            if (!visited.insert(obj).second)
+                return 0;
+            bool annotation = in_annotation || typeid(*obj) == typeid(SBOLObject);  // Custom annotation objects are generic SBOLObjects
+            map<string, size_t> categories;
+            measure_fields(*obj, categories);
+            size_t size = 0;
+            for (auto & i_category : categories)
+            {
+                usage.categories[annotation ? "annotation_objects" : i_category.first] += i_category.second;
+                size += i_category.second;
+            }
+            MemoryUsage::ClassUsage& class_usage = usage.classes[obj->type];
+            class_usage.count += 1;
+            class_usage.size += size;
+
+            ++usage.object_count;
+            ++usage.triple_count;  // rdf:type
+            for (auto & i_property : obj->properties)
+                if (std::find(obj->hidden_properties.begin(), obj->hidden_properties.end(), i_property.first) == obj->hidden_properties.end())
+                    for (auto & value : i_property.second)
+                        if (value.length() > 2 && i_property.first != SBOL_IDENTITY)  // Unset values are not serialized
+                            ++usage.triple_count;
+            for (auto & i_store : obj->owned_objects)
+            {
+                if (std::find(obj->hidden_properties.begin(), obj->hidden_properties.end(), i_store.first) == obj->hidden_properties.end())
+                    usage.triple_count += i_store.second.size();
+                for (auto & child : i_store.second)
+                    size += measure(child, annotation);
+            }
+            return size;
+        };
+    };
+
+    Measurement measurement(usage);
+    measurement.visited.insert(this);
+    vector<pair<string, size_t>> toplevel_sizes;
+    toplevel_sizes.reserve(SBOLObjects.size());
+    for (auto & i_obj : SBOLObjects)
+        toplevel_sizes.push_back({ i_obj.first, measurement.measure(i_obj.second, false) });
+    for (auto & i_store : owned_objects)
+        for (auto & obj : i_store.second)
+            measurement.measure(obj, false);  // TopLevels that are not registered, if any
+
+    // The Document's own properties and namespaces
+    map<string, size_t> document_categories;
+    measurement.measure_fields(*this, document_categories);
+    for (auto & i_category : document_categories)
+        usage.categories[i_category.first] += i_category.second;
+
+    usage.categories["indexes"] += heap(SBOLObjects) + heap(lineage_parents) + heap(lineage_children) + heap(indexed_properties) + heap(term_index) +
+        heap(term_index_entries) + heap(term_index_dirty) + heap(text_properties) + heap(text_index) + heap(text_index_objects) + heap(text_index_ids) +
+        heap(text_index_classes) + heap(text_index_class_uris) + heap(text_index_dirty) + heap(serialization_caches) + heap(existing_children) +
+        heap(annotation_references);
+
+    size_t n = min((size_t)max(n_largest, 0), toplevel_sizes.size());
+    std::partial_sort(toplevel_sizes.begin(), toplevel_sizes.begin() + n, toplevel_sizes.end(), [](const pair<string, size_t>& a, const pair<string, size_t>& b)
+    {
+        return a.second > b.second || (a.second == b.second && a.first < b.first);
+    });
+    toplevel_sizes.resize(n);
+    usage.largest_objects = std::move(toplevel_sizes);
+    return usage;
+};
+
+size_t MemoryUsage::getTotal()
+{
+    size_t total = 0;
+    for (auto & i_category : categories)
+        total += i_category.second;
+    return total;
+};
+
+size_t MemoryUsage::getObjectCount()
+{
+    return object_count;
+};
+
+size_t MemoryUsage::getTripleCount()
+{
+    return triple_count;
+};
+
+std::vector<std::string> MemoryUsage::getCategories()
+{
+    return vector<string>(std::begin(CATEGORIES), std::end(CATEGORIES));
+};
+
+size_t MemoryUsage::getCategorySize(std::string category)
+{
+    auto i_category = categories.find(category);
+    if (i_category == categories.end())
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Invalid memory category " + category);
+    return i_category->second;
+};
+
+std::vector<std::string> MemoryUsage::getClasses()
+{
+    vector<string> class_uris;
+    for (auto & i_class : classes)
+        class_uris.push_back(i_class.first);
+    std::stable_sort(class_uris.begin(), class_uris.end(), [this](const string& a, const string& b) { return classes[a].size > classes[b].size; });
+    return class_uris;
+};
+
+size_t MemoryUsage::getClassCount(std::string class_uri)
+{
+    auto i_class = classes.find(class_uri);
+    return i_class == classes.end() ? 0 : i_class->second.count;
+};
+
+size_t MemoryUsage::getClassSize(std::string class_uri)
+{
+    auto i_class = classes.find(class_uri);
+    return i_class == classes.end() ? 0 : i_class->second.size;
+};
+
+double MemoryUsage::getClassAverage(std::string class_uri)
+{
+    auto i_class = classes.find(class_uri);
+    return i_class == classes.end() ? 0 : (double)i_class->second.size / i_class->second.count;
+};
+
+std::vector<std::string> MemoryUsage::getLargestObjects()
+{
+    vector<string> uris;
+    for (auto & i_obj : largest_objects)
+        uris.push_back(i_obj.first);
+    return uris;
+};
+
+size_t MemoryUsage::getObjectSize(std::string uri)
+{
+    for (auto & i_obj : largest_objects)
+        if (i_obj.first == uri)
+            return i_obj.second;
+    throw SBOLError(SBOL_ERROR_NOT_FOUND, uri + " is not among the largest objects");
+};
+
+std::string MemoryUsage::report()
+{
+    ostringstream out;
+    out << left << setw(28) << "Category" << right << setw(14) << "Bytes" << endl;
+    for (auto & category : getCategories())
+        out << left << setw(28) << category << right << setw(14) << categories[category] << endl;
+    out << left << setw(28) << "total" << right << setw(14) << getTotal() << endl;
+    out << endl;
+    out << left << setw(60) << "Class" << right << setw(10) << "Objects" << setw(14) << "Bytes" << setw(10) << "Average" << endl;
+    for (auto & class_uri : getClasses())
+        out << left << setw(60) << class_uri << right << setw(10) << classes[class_uri].count << setw(14) << classes[class_uri].size << setw(10) << fixed << setprecision(0) << getClassAverage(class_uri) << endl;
+    out << endl;
+    out << left << setw(60) << "Largest objects" << right << setw(14) << "Bytes" << endl;
+    for (auto & i_obj : largest_objects)
+        out << left << setw(60) << i_obj.first << right << setw(14) << i_obj.second << endl;
+    return out.str();
+};
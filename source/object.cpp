@@ -24,10 +24,12 @@
  * ------------------------------------------------------------------------->*/
 
 #include "object.h"
+#include "document.h"
 #include <raptor2.h>
 #include <string>
 #include <vector>
 #include <functional>
+#include <atomic>
 #include <iostream>
 
 #if defined(SBOL_BUILD_PYTHON2) || defined(SBOL_BUILD_PYTHON3)
@@ -388,9 +390,11 @@ vector<SBOLObject*> SBOLObject::find_property_value(string uri, string value, ve
             matches.insert(matches.end(), more_matches.begin(), more_matches.end());
         }
     }
-    if (properties.find(uri) == properties.end())
-        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot find property value. " + uri + " is not a valid property type.");
-    std::vector<std::string> value_store = properties[uri];
+    // Objects that do not have this property, eg, the container of the matching children, are skipped
+    auto i_property = properties.find(uri);
+    if (i_property == properties.end())
+        return matches;
+    std::vector<std::string>& value_store = i_property->second;
     for (auto & val : value_store)
     {
         if (val.compare("\"" + value + "\"") == 0)
@@ -456,6 +460,8 @@ std::string SBOLObject::getPropertyValue(std::string property_uri)
 
 void SBOLObject::setPropertyValue(std::string property_uri, std::string val)
 {
+    check_mutable(this, property_uri);
+    record_values(this, property_uri);
 
         if (val[0] == '<' && val[val.length() - 1] == '>')
         {
@@ -467,6 +473,8 @@ void SBOLObject::setPropertyValue(std::string property_uri, std::string val)
             // ...else treat the value as a literal
             properties[property_uri].push_back("\"" + val + "\"");
         }
+        notify_property_change(this, property_uri);
+        notify_change(SBOL_CHANGE_PROPERTY_ADDED, this, property_uri, val);
 };
 
 std::vector < std::string > SBOLObject::getPropertyValues(std::string property_uri)
@@ -518,6 +526,49 @@ std::string SBOLObject::__str__()
 }
 
 
+int& DeserializationScope::depth()
+{
+    // Per thread, so that objects constructed by one thread are unaffected while another thread reads a Document
+    static thread_local int depth = 0;
+    return depth;
+}
+
+uint64_t sbol::next_revision()
+{
+    static std::atomic<uint64_t> revision(0);
+    return ++revision;
+}
+
+void sbol::notify_property_change(SBOLObject* owner, const rdf_type& property_type)
+{
+    if (!owner)
+        return;
+
+    // The change makes the cached serializations of the object and of every object that contains it stale. The same walk
+    // finds the Document. Nested objects added before their parent joined a Document may not have a back-pointer yet
+    uint64_t revision = next_revision();
+    Document* doc = NULL;
+    for (SBOLObject* obj = owner; obj; obj = obj->parent)
+    {
+        obj->revision = revision;
+        if (!doc)
+            doc = obj->doc;
+    }
+    if (!doc)
+        return;
+
+    // Properties that define the provenance graph. An object's identity is included, because the graph is keyed by identity
+    if (property_type == SBOL_WAS_DERIVED_FROM || property_type == PROVO_WAS_GENERATED_BY || property_type == PROVO_WAS_INFORMED_BY ||
+        property_type == PROVO_ENTITY || property_type == SBOL_IDENTITY)
+        doc->lineage_valid = false;
+    if (doc->term_index_valid && doc->indexed_properties.count(property_type))
+        doc->term_index_dirty[owner];
+    if (doc->text_index_valid)
+        for (auto & text_property : doc->text_properties)
+            if (text_property.first == property_type)
+                doc->text_index_dirty[owner];
+}
+
 URIProperty::URIProperty(void *property_owner, rdf_type type_uri, char lower_bound, char upper_bound, ValidationRules validation_rules, std::string initial_value) :
     Property(property_owner, type_uri, lower_bound, upper_bound, validation_rules, "<" + initial_value + ">")
 {
@@ -704,6 +755,8 @@ reference_type_uri(reference_type_uri)
 
 void ReferencedObject::set(std::string uri)
 {
+    check_mutable(this->sbol_owner, this->type);
+    record_values(this->sbol_owner, this->type);
     if (this->sbol_owner)
     {
         //sbol_owner->properties[type].push_back( new_value );
@@ -712,12 +765,16 @@ void ReferencedObject::set(std::string uri)
         {
             this->sbol_owner->properties[this->type][0] = "<" + uri + ">";
         }
+        notify_property_change(this->sbol_owner, this->type);
+        notify_change(SBOL_CHANGE_PROPERTY_SET, this->sbol_owner, this->type, uri);
         validate((void *)&uri);
     }
 };
 
 void ReferencedObject::add(std::string uri)
 {
+    check_mutable(this->sbol_owner, this->type);
+    record_values(this->sbol_owner, this->type);
     if (sbol_owner)
     {
         std::string current_value = this->sbol_owner->properties[this->type][0];
@@ -728,6 +785,8 @@ void ReferencedObject::add(std::string uri)
             else
                 this->sbol_owner->properties[this->type].push_back("<" + uri + ">");
         }
+        notify_property_change(this->sbol_owner, this->type);
+        notify_change(SBOL_CHANGE_PROPERTY_ADDED, this->sbol_owner, this->type, uri);
         validate((void *)&uri);  //  Call validation rules associated with this Property
     }
 };
@@ -783,6 +842,10 @@ std::string ReferencedObject::operator[] (const int nIndex)
 
 void ReferencedObject::addReference(const std::string uri)
 {
+    check_mutable(this->sbol_owner, this->type);
+    record_values(this->sbol_owner, this->type);
     this->sbol_owner->properties[this->type].push_back("<" + uri + ">");
+    notify_property_change(this->sbol_owner, this->type);
+    notify_change(SBOL_CHANGE_PROPERTY_ADDED, this->sbol_owner, this->type, uri);
 };
 
@@ -57,6 +57,8 @@ namespace sbol
         
         template < class SBOLClass >
         friend class AliasedProperty;
+
+        friend class TripleSerializer;  // Defined in triples.cpp
     
     protected:
         /// @cond
@@ -79,7 +81,9 @@ namespace sbol
         /// @cond
         Document *doc = NULL;
         rdf_type type;
-        SBOLObject* parent;
+        SBOLObject* parent = NULL;
+        /// Renewed whenever a property or child of this object or of one of its descendants changes, so a serialization cached for an earlier revision is known to be stale
+        uint64_t revision = next_revision();
         
         std::map<sbol::rdf_type, std::vector< std::string > > properties;
         std::map<sbol::rdf_type, std::vector< sbol::SBOLObject* > > owned_objects;
@@ -113,7 +117,7 @@ namespace sbol
         /// Search this object recursively to see if it contains a member property with the given RDF type and indicated property value.
         /// @param uri The RDF type of the property to search for.
         /// @param value The property value to match
-        /// @return A vector containing all objects found that contain a member property with the specified RDF type
+        /// @return A vector containing all objects found that contain a member property with the specified RDF type and value. Objects that do not have the property are skipped, so the vector is empty if nothing matches
         std::vector<SBOLObject*> find_property_value(std::string uri, std::string value, std::vector<SBOLObject*> matches = {});
 
         /// Search this object recursively to see if it contains a member property with the given RDF type and indicated property value.
@@ -178,7 +182,7 @@ namespace sbol
             namespaces({}),
             identity(this, SBOL_IDENTITY, '0', '1', ValidationRules({ sbol_rule_10202 }), uri)
         {
-            if (hasHomespace())
+            if (!DeserializationScope::active() && hasHomespace())
                 identity.set(getHomespace() + "/" + uri);
         };
 
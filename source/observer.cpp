@@ -0,0 +1,149 @@
+/**
+ * @file    observer.cpp
+ * @brief   Observers that are notified of the changes made to a Document
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+
+
+#include "document.h"
+
+using namespace sbol;
+using namespace std;
+
+namespace
+{
+    // While no Document has an observer, changes are not tracked
+    atomic<int> n_observed_documents(0);
+
+    // The Document whose observers are notified of a change to the owner, or NULL if it has none
+    Document* observing_document(SBOLObject* owner)
+    {
+        if (!owner || !n_observed_documents.load(memory_order_relaxed))
+            return NULL;
+        Document* doc = owning_document(owner);
+        if (doc && doc->observers.size())
+            return doc;
+        return NULL;
+    };
+}
+
+bool sbol::is_observed(SBOLObject* owner)
+{
+    return observing_document(owner) != NULL;
+};
+
+void sbol::notify_change(ChangeType type, SBOLObject* owner, const rdf_type& property_type, const std::string& value)
+{
+    Document* doc = observing_document(owner);
+    if (doc)
+        doc->deliver_change(ChangeEvent(type, owner->identity.get(), property_type, value));
+};
+
+void sbol::notify_change(ChangeType type, SBOLObject* owner, const rdf_type& property_type, SBOLObject* obj)
+{
+    Document* doc = observing_document(owner);
+    if (!doc)
+        return;
+    if (type == SBOL_CHANGE_TOPLEVEL_ADDED || type == SBOL_CHANGE_TOPLEVEL_CLOSED)
+        doc->deliver_change(ChangeEvent(type, obj->identity.get(), "", ""));
+    else if (owner != doc)
+        doc->deliver_change(ChangeEvent(type, owner->identity.get(), property_type, obj->identity.get()));
+};
+
+ReloadScope::ReloadScope(Document& doc) :
+    doc(doc)
+{
+    ++doc.reload_depth;
+};
+
+ReloadScope::~ReloadScope()
+{
+    --doc.reload_depth;
+};
+
+void Document::deliver_change(ChangeEvent&& change)
+{
+    if (reload_depth && change.type != SBOL_CHANGE_RELOADED)
+        return;
+    if (batch_depth)
+    {
+        queued_changes.push_back(std::move(change));
+        return;
+    }
+    vector<ChangeEvent> changes;
+    changes.push_back(std::move(change));
+    // An observer may register or unregister observers while it is notified
+    vector<DocumentObserver*> receivers = observers;
+    for (auto & observer : receivers)
+        if (std::find(observers.begin(), observers.end(), observer) != observers.end())
+            observer->changed(*this, changes);
+};
+
+void Document::addObserver(DocumentObserver& observer)
+{
+    if (std::find(observers.begin(), observers.end(), &observer) != observers.end())
+        return;
+    if (observers.empty())
+        ++n_observed_documents;
+    observers.push_back(&observer);
+};
+
+void Document::removeObserver(DocumentObserver& observer)
+{
+    auto i_observer = std::find(observers.begin(), observers.end(), &observer);
+    if (i_observer == observers.end())
+        return;
+    observers.erase(i_observer);
+    if (observers.empty())
+        --n_observed_documents;
+};
+
+void Document::beginBatch()
+{
+    ++batch_depth;
+};
+
+void Document::endBatch()
+{
+    if (!batch_depth)
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot end batch. No batch is open");
+    if (--batch_depth || queued_changes.empty())
+        return;
+    vector<ChangeEvent> changes;
+    changes.swap(queued_changes);
+    vector<DocumentObserver*> receivers = observers;
+    for (auto & observer : receivers)
+        if (std::find(observers.begin(), observers.end(), observer) != observers.end())
+            observer->changed(*this, changes);
+};
+
+void Document::release_observers()
+{
+    for (auto & observer : owned_observers)
+        delete observer;
+    owned_observers.clear();
+    if (observers.empty())
+        return;
+    observers.clear();
+    --n_observed_documents;
+};
@@ -121,7 +121,7 @@ SearchResponse& sbol::PartShop::search(SearchQuery& q)
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
         
         /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
+        res = perform_request(curl);
         /* Check for errors */
         if(res != CURLE_OK)
             throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to validate online failed with " + string(curl_easy_strerror(res)));
@@ -208,7 +208,7 @@ SearchResponse& sbol::PartShop::search(std::string search_text, rdf_type object_
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
         
         /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
+        res = perform_request(curl);
         /* Check for errors */
         if(res != CURLE_OK)
             throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to validate online failed with " + string(curl_easy_strerror(res)));
@@ -287,7 +287,7 @@ SearchResponse& sbol::PartShop::search(std::string search_text, rdf_type object_
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
         
         /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
+        res = perform_request(curl);
         /* Check for errors */
         if(res != CURLE_OK)
             throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to validate online failed with " + string(curl_easy_strerror(res)));
@@ -390,7 +390,7 @@ int sbol::PartShop::searchCount(SearchQuery& q)
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
         
         /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
+        res = perform_request(curl);
         /* Check for errors */
         if(res != CURLE_OK)
             throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to validate online failed with " + string(curl_easy_strerror(res)));
@@ -462,7 +462,7 @@ int sbol::PartShop::searchCount(std::string search_text, rdf_type object_type, s
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
         
         /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
+        res = perform_request(curl);
         /* Check for errors */
         if(res != CURLE_OK)
             throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to validate online failed with " + string(curl_easy_strerror(res)));
@@ -526,7 +526,7 @@ int sbol::PartShop::searchCount(std::string search_text, rdf_type object_type)
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
         
         /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
+        res = perform_request(curl);
         /* Check for errors */
         if(res != CURLE_OK)
             throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to validate online failed with " + string(curl_easy_strerror(res)));
@@ -584,7 +584,7 @@ void sbol::PartShop::login(std::string email, std::string password)
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
         
         /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
+        res = perform_request(curl);
         /* Check for errors */
         if(res != CURLE_OK)
             throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to validate online failed with " + string(curl_easy_strerror(res)));
@@ -665,7 +665,7 @@ std::string sbol::PartShop::submit(Document& doc, std::string collection, int ov
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
         
         /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
+        res = perform_request(curl);
         /* Check for errors */
         if(res != CURLE_OK)
             throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "HTTP post request failed with: " + string(curl_easy_strerror(res)));
@@ -842,7 +842,7 @@ std::string PartShop::searchRootCollections()
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
         
         /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
+        res = perform_request(curl);
         /* Check for errors */
         if(res != CURLE_OK)
             throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to retrieve root collections failed with: " + std::string(curl_easy_strerror(res)));
@@ -887,7 +887,7 @@ std::string PartShop::searchSubCollections(std::string uri)
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
         
         /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
+        res = perform_request(curl);
         /* Check for errors */
         if(res != CURLE_OK)
             throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to count objects failed with " + std::string(curl_easy_strerror(res)));
@@ -949,7 +949,7 @@ std::string http_get_request(std::string get_request, unordered_map<string, stri
         curl_easy_setopt(curl, CURLOPT_HEADERDATA, response_headers);
 
         /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
+        res = perform_request(curl);
         
         /* Check for errors */
         if(res != CURLE_OK)
@@ -1041,7 +1041,7 @@ void PartShop::attachFile(std::string topleveluri, std::string filename)
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
         
         /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
+        res = perform_request(curl);
         /* Check for errors */
         if(res != CURLE_OK)
         throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to upload attachment failed with " + string(curl_easy_strerror(res)));
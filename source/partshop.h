@@ -297,7 +297,7 @@ namespace sbol
             curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
             
             /* Perform the request, res will get the return code */
-            res = curl_easy_perform(curl);
+            res = perform_request(curl);
             /* Check for errors */
             if(res != CURLE_OK)
                 throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to count objects failed with " + std::string(curl_easy_strerror(res)));
@@ -349,7 +349,7 @@ namespace sbol
             curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
             
             /* Perform the request, res will get the return code */
-            res = curl_easy_perform(curl);
+            res = perform_request(curl);
             /* Check for errors */
             if(res != CURLE_OK)
                 throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to access PartShop failed with " + std::string(curl_easy_strerror(res)));
@@ -416,13 +416,13 @@ namespace sbol
         VersionProperty(void *property_owner, rdf_type type_uri, char lower_bound, char upper_bound, std::string initial_value) :
             TextProperty(property_owner, type_uri, lower_bound, upper_bound, ValidationRules({}), initial_value)
             {
-                std::string v = this->get();
                 // @TODO move this error checking to validation rules to be run on VersionProperty::set() and VersionProperty()::VersionProperty()
                 // sbol-10207 The version property of an Identified object is OPTIONAL and MAY contain a String that MUST be composed of only alphanumeric characters, underscores, hyphens, or periods and MUST begin with a digit. 20 Reference: Section 7.4 on page 16 21
                 // sbol-10208 The version property of an Identified object SHOULD follow the conventions of semantic 22 versioning as implemented by Maven.
-                if (Config::getOption("sbol_compliant_uris").compare("True") == 0)
+                if (!DeserializationScope::active() && Config::getOption("sbol_compliant_uris").compare("True") == 0)
                 {
-                    std::regex v_rgx("[0-9]+[a-zA-Z0-9_\\\\.-]*");
+                    std::string v = this->get();
+                    static const std::regex v_rgx("[0-9]+[a-zA-Z0-9_\\\\.-]*");  // Compiled once, since every Identified object constructs a VersionProperty
                     if (!std::regex_match(v.begin(), v.end(), v_rgx))
                         throw SBOLError(SBOL_ERROR_NONCOMPLIANT_VERSION, "SBOL-compliant versions require a major, minor, and patch number in accordance with Maven versioning schemes. Use toggleSBOLCompliance() to relax these versioning requirements.");
                 }
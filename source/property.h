@@ -32,6 +32,7 @@
 
 #include <raptor2.h>
 #include <string>
+#include <cstdint>
 #include <vector>
 #include <iostream>
 #include <map>
@@ -57,6 +58,82 @@ namespace sbol
 	// All SBOLProperties have a pointer back to the object which the property belongs to.  This requires forward declaration of the SBOLObject class
 	class SBOLObject;
 
+    /// The kinds of change to a Document that are reported to a DocumentObserver
+    enum ChangeType
+    {
+        SBOL_CHANGE_PROPERTY_SET,       ///< A property was set or cleared. The value is the new value, or empty if the property was cleared
+        SBOL_CHANGE_PROPERTY_ADDED,     ///< A value was added to a property
+        SBOL_CHANGE_PROPERTY_REMOVED,   ///< A value was removed from a property
+        SBOL_CHANGE_OBJECT_ADDED,       ///< A child object was created in, or added to, an owned-object property. The value is the URI of the child
+        SBOL_CHANGE_OBJECT_REMOVED,     ///< A child object was removed from an owned-object property
+        SBOL_CHANGE_TOPLEVEL_ADDED,     ///< A TopLevel object, together with its children, was added to the Document. The subject is the URI of the object
+        SBOL_CHANGE_TOPLEVEL_CLOSED,    ///< A TopLevel object was closed or removed from the Document
+        SBOL_CHANGE_URI_CHANGED,        ///< A child object was given a new URI by update_uri. The subject is the new URI and the value is the old one
+        SBOL_CHANGE_RELOADED            ///< Objects were read into the Document from a file, string or snapshot, without individual changes being reported
+    };
+    
+    /// @cond
+    /// The single hook called after a property value or an object store of an object changes. It gives the object and every object that contains it a new revision, which invalidates their cached serializations, and marks the lineage graph, term index and full-text index of the Document that contains them out of date where the property is one they index. Defined in object.cpp
+    SBOL_DECLSPEC void notify_property_change(SBOLObject* owner, const rdf_type& property_type);
+
+    /// Throw an SBOLError if the object belongs to a frozen Document, or if the values of the property are pinned. Called before a property or child object is modified. Defined in freeze.cpp
+    /// @param property_type The property whose values are about to change, or empty if none are
+    SBOL_DECLSPEC void check_mutable(SBOLObject* owner, const rdf_type& property_type = "");
+
+    /// Pin the values of a property while a buffer that points into them is exported, so that changing them throws an SBOLError instead of leaving the buffer dangling. Pins are counted, and each is released by a call to unpin_values
+    SBOL_DECLSPEC void pin_values(SBOLObject* owner, const rdf_type& property_type);
+
+    SBOL_DECLSPEC void unpin_values(SBOLObject* owner, const rdf_type& property_type);
+
+    /// The functions below record state in the undo log of the owner's Document just before it changes, if a transaction is open on the Document, so that Document::rollback can restore it. Defined in transaction.cpp
+    /// Record the values of a property
+    SBOL_DECLSPEC void record_values(SBOLObject* owner, const rdf_type& property_type);
+
+    /// Record that an object is about to be appended to an object store
+    SBOL_DECLSPEC void record_object_added(SBOLObject* owner, const rdf_type& store, SBOLObject* obj);
+
+    /// Record that the object at an index is about to be erased from an object store
+    SBOL_DECLSPEC void record_object_removed(SBOLObject* owner, const rdf_type& store, size_t index);
+
+    /// Record all the objects in an object store, before the store is cleared
+    SBOL_DECLSPEC void record_object_store(SBOLObject* owner, const rdf_type& store);
+
+    /// Record the parent and Document back-pointers of an object that is about to be attached to or detached from the owner
+    SBOL_DECLSPEC void record_links(SBOLObject* owner, SBOLObject* obj);
+
+    /// Record the object registered in the owner's Document under a URI, before the registration changes
+    SBOL_DECLSPEC void record_registration(SBOLObject* owner, const std::string& uri);
+
+    /// Record that an object was constructed for the owner, so that it is deleted if the transaction is rolled back
+    SBOL_DECLSPEC void record_created(SBOLObject* owner, SBOLObject* obj);
+
+    /// Close an object that was removed from the owner. Inside a transaction, the object is kept until the outermost transaction is committed, so that a rollback can restore it
+    SBOL_DECLSPEC void release_object(SBOLObject* owner, SBOLObject* obj);
+
+    /// Report a change to the observers of the owner's Document. The value is a property value, or the URI of the subject for URI_CHANGED. Defined in observer.cpp
+    SBOL_DECLSPEC void notify_change(ChangeType type, SBOLObject* owner, const rdf_type& property_type, const std::string& value);
+
+    /// Report a change that concerns a child or TopLevel object. Changes to the object stores of the Document itself are reported as TopLevel changes, where the Document registers the object, and are skipped here
+    SBOL_DECLSPEC void notify_change(ChangeType type, SBOLObject* owner, const rdf_type& property_type, SBOLObject* obj);
+
+    /// Whether the owner's Document has observers, so that a value that is only needed for a change report can be skipped
+    SBOL_DECLSPEC bool is_observed(SBOLObject* owner);
+
+    /// Returns a revision number that has never been returned before, for SBOLObject::revision. Defined in object.cpp
+    SBOL_DECLSPEC uint64_t next_revision();
+
+    /// Opened by the parser while it constructs objects from a triple store. While a scope is open on the current thread, Property constructors register an empty "<>" or "\"\"" slot in their owner without validating or assigning a default value, and Identified and TopLevel constructors skip URI construction, because every value is replaced by the parsed triples anyway
+    class SBOL_DECLSPEC DeserializationScope
+    {
+    public:
+        DeserializationScope() { ++depth(); };
+        ~DeserializationScope() { --depth(); };
+        static bool active() { return depth() > 0; };
+    private:
+        static int& depth();
+    };
+    /// @endcond
+
     /// Member properties of all SBOL objects are defined using a Property object.  The Property class provides a generic interface for accessing SBOL objects.  At a low level, the Property class converts SBOL data structures into RDF triples.
     /// @tparam The SBOL specification currently supports string, URI, and integer literal values.
     /// @ingroup extension_layer
@@ -192,6 +269,12 @@ namespace sbol
     template <class LiteralType>
 	Property<LiteralType>::Property(void *property_owner, rdf_type type_uri, char lower_bound, char upper_bound, ValidationRules validation_rules, std::string initial_value) : Property(property_owner, type_uri, lower_bound, upper_bound, validation_rules)
 	{
+        if (DeserializationScope::active())
+        {
+            if (initial_value[0] == '<')
+                this->sbol_owner->properties[type_uri][0] = "<>";
+            return;
+        }
         std::string trim_value = initial_value.substr(1, initial_value.length() - 2);
         validate(&trim_value);
         this->sbol_owner->properties[type_uri][0] = initial_value;
@@ -201,6 +284,8 @@ namespace sbol
 	template <class LiteralType>
 	Property<LiteralType>::Property(void *property_owner, rdf_type type_uri, char lower_bound, char upper_bound, ValidationRules validation_rules, int initial_value) : Property(property_owner, type_uri, lower_bound, upper_bound, validation_rules)
 	{
+        if (DeserializationScope::active())
+            return;
         validate(&initial_value);
 		this->sbol_owner->properties[type_uri][0] = "\"" + std::to_string(initial_value) + "\"";
 	}
@@ -209,6 +294,8 @@ namespace sbol
     template <class LiteralType>
     Property<LiteralType>::Property(void *property_owner, rdf_type type_uri, char lower_bound, char upper_bound, ValidationRules validation_rules, double initial_value) : Property(property_owner, type_uri, lower_bound, upper_bound, validation_rules)
     {
+        if (DeserializationScope::active())
+            return;
         validate(&initial_value);
         this->sbol_owner->properties[type_uri][0] = "\"" + std::to_string(initial_value) + "\"";
 
@@ -238,6 +325,8 @@ namespace sbol
     template <class LiteralType>
     void Property<LiteralType>::set(std::string new_value)
     {
+        check_mutable(this->sbol_owner, this->type);
+        record_values(this->sbol_owner, this->type);
         if (sbol_owner)
         {
             //sbol_owner->properties[type].push_back( new_value );
@@ -250,7 +339,8 @@ namespace sbol
             {
                 this->sbol_owner->properties[this->type][0] = "\"" + new_value + "\"";
             }
-            
+            notify_property_change(this->sbol_owner, this->type);
+            notify_change(SBOL_CHANGE_PROPERTY_SET, this->sbol_owner, this->type, new_value);
         }
         validate((void *)&new_value);
     };
@@ -259,10 +349,15 @@ namespace sbol
     template <class LiteralType>
     void Property<LiteralType>::set(int new_value)
     {
+        check_mutable(this->sbol_owner, this->type);
+        record_values(this->sbol_owner, this->type);
         if (new_value)
         {
             // TODO:  need to convert new_value to string
-            this->sbol_owner->properties[type][0] = "\"" + std::to_string(new_value) + "\"";
+            std::string value = std::to_string(new_value);
+            this->sbol_owner->properties[type][0] = "\"" + value + "\"";
+            notify_property_change(this->sbol_owner, this->type);
+            notify_change(SBOL_CHANGE_PROPERTY_SET, this->sbol_owner, this->type, value);
         }
         validate((void *)&new_value);  //  Call validation rules associated with this Property
     };
@@ -271,10 +366,15 @@ namespace sbol
     template <class LiteralType>
     void Property<LiteralType>::set(double new_value)
     {
+        check_mutable(this->sbol_owner, this->type);
+        record_values(this->sbol_owner, this->type);
         if (new_value)
         {
             // TODO:  need to convert new_value to string
-            this->sbol_owner->properties[type][0] = "\"" + std::to_string(new_value) + "\"";
+            std::string value = std::to_string(new_value);
+            this->sbol_owner->properties[type][0] = "\"" + value + "\"";
+            notify_property_change(this->sbol_owner, this->type);
+            notify_change(SBOL_CHANGE_PROPERTY_SET, this->sbol_owner, this->type, value);
         }
         validate((void *)&new_value);  //  Call validation rules associated with this Property
     };
@@ -291,6 +391,8 @@ namespace sbol
     template <class LiteralType>
     void Property<LiteralType>::clear()
     {
+        check_mutable(this->sbol_owner, this->type);
+        record_values(this->sbol_owner, this->type);
         std::string current_value = this->sbol_owner->properties[this->type][0];
         this->sbol_owner->properties[type].clear();
         if (current_value[0] == '<')  //  this property is a uri
@@ -301,6 +403,8 @@ namespace sbol
         {
             this->sbol_owner->properties[this->type].push_back("\"\"");
         }
+        notify_property_change(this->sbol_owner, this->type);
+        notify_change(SBOL_CHANGE_PROPERTY_SET, this->sbol_owner, this->type, "");
     }
     
     template <class LiteralType>
@@ -341,18 +445,24 @@ namespace sbol
             }
             
 #if defined(SBOL_BUILD_PYTHON2) || defined(SBOL_BUILD_PYTHON3)
-            for (auto & rule : pythonValidationRules)
+            if (pythonValidationRules.size())
             {
-                PyObject* validate_fx = rule.first;
-                PyObject* property_to_validate = rule.second;
-                PyObject* py_tuple = PyTuple_New(1);
-                PyTuple_SetItem(py_tuple, 0, property_to_validate);
-                PyObject_CallObject(validate_fx, py_tuple);
-                if (PyErr_Occurred() != NULL)
+                PyGILState_STATE gil_state = PyGILState_Ensure();  // The caller may be running with the GIL released
+                for (auto & rule : pythonValidationRules)
                 {
-                    PyErr_Clear();
-                    throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Validation failed.");
+                    PyObject* validate_fx = rule.first;
+                    PyObject* property_to_validate = rule.second;
+                    PyObject* py_tuple = PyTuple_New(1);
+                    PyTuple_SetItem(py_tuple, 0, property_to_validate);
+                    PyObject_CallObject(validate_fx, py_tuple);
+                    if (PyErr_Occurred() != NULL)
+                    {
+                        PyErr_Clear();
+                        PyGILState_Release(gil_state);
+                        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Validation failed.");
+                    }
                 }
+                PyGILState_Release(gil_state);
             }
 #endif
         }
@@ -372,6 +482,8 @@ namespace sbol
     template <class LiteralType>
     void Property<LiteralType>::add(std::string new_value)
     {
+        check_mutable(this->sbol_owner, this->type);
+        record_values(this->sbol_owner, this->type);
         if (sbol_owner)
         {
             std::string current_value = this->sbol_owner->properties[this->type][0];
@@ -389,6 +501,8 @@ namespace sbol
                 else
                     this->sbol_owner->properties[this->type].push_back("\"" + new_value + "\"");
             }
+            notify_property_change(this->sbol_owner, this->type);
+            notify_change(SBOL_CHANGE_PROPERTY_ADDED, this->sbol_owner, this->type, new_value);
             validate((void *)&new_value);  //  Call validation rules associated with this Property
         }
     };
@@ -396,6 +510,8 @@ namespace sbol
     template <class LiteralType>
     void Property<LiteralType>::remove(int index)
     {
+        check_mutable(this->sbol_owner, this->type);
+        record_values(this->sbol_owner, this->type);
         if (this->sbol_owner)
         {
             if (this->sbol_owner->properties.find(this->type) != this->sbol_owner->properties.end())
@@ -405,7 +521,15 @@ namespace sbol
                 if (this->sbol_owner->properties[this->type].size() == 1)
                     this->clear();  // If this is the only value in the property, then clearing it will properly re-initialize the property
                 else
-                    this->sbol_owner->properties[this->type].erase( this->sbol_owner->properties[this->type].begin() + index);
+                {
+                    std::vector<std::string>& values = this->sbol_owner->properties[this->type];
+                    bool observed = is_observed(this->sbol_owner);
+                    std::string removed_value = observed ? values[index].substr(1, values[index].length() - 2) : "";
+                    values.erase(values.begin() + index);
+                    notify_property_change(this->sbol_owner, this->type);
+                    if (observed)
+                        notify_change(SBOL_CHANGE_PROPERTY_REMOVED, this->sbol_owner, this->type, removed_value);
+                }
             }
         }
     };
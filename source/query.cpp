@@ -0,0 +1,312 @@
+/**
+ * @file    query.cpp
+ * @brief   Inverted index of the URI-valued properties of a Document
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+#include "document.h"
+
+using namespace sbol;
+using namespace std;
+
+namespace
+{
+    const string RDF_TYPE = RDF_URI "type";
+
+    // Withdraw an object's entries from the inverted index
+    void remove_term_entries(Document& doc, SBOLObject* obj)
+    {
+        auto i_entries = doc.term_index_entries.find(obj);
+        if (i_entries == doc.term_index_entries.end())
+            return;
+        for (auto & entry : i_entries->second)
+        {
+            auto& values = doc.term_index[entry.first];
+            auto i_postings = values.find(entry.second);
+            if (i_postings == values.end())
+                continue;
+            i_postings->second.erase(obj);
+            if (i_postings->second.empty())
+                values.erase(i_postings);
+        }
+        doc.term_index_entries.erase(i_entries);
+    };
+
+    // Enter the current URI values of an object's indexed properties into the inverted index
+    void add_term_entries(Document& doc, SBOLObject* obj)
+    {
+        vector<pair<string, string>> entries;
+        for (auto & property_uri : doc.indexed_properties)
+        {
+            if (property_uri == RDF_TYPE)
+            {
+                entries.emplace_back(RDF_TYPE, obj->type);
+                continue;
+            }
+            auto i_property = obj->properties.find(property_uri);
+            if (i_property == obj->properties.end())
+                continue;
+            for (auto & value : i_property->second)
+                if (value.length() > 2 && value.front() == '<')
+                    entries.emplace_back(property_uri, value.substr(1, value.length() - 2));
+        }
+        for (auto & entry : entries)
+            doc.term_index[entry.first][entry.second].insert(obj);
+        doc.term_index_entries[obj] = move(entries);
+    };
+
+    void check_query(Document& doc, const TermQuery& condition)
+    {
+        if (condition.op == TermQuery::TERM && doc.indexed_properties.find(condition.property_uri) == doc.indexed_properties.end())
+            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot query " + condition.property_uri + " because it is not indexed. Call Document::indexProperty first");
+        for (auto & operand : condition.operands)
+            check_query(doc, operand);
+    };
+
+    const unordered_set<SBOLObject*>* find_postings(Document& doc, const TermQuery& condition)
+    {
+        auto i_values = doc.term_index.find(condition.property_uri);
+        if (i_values == doc.term_index.end())
+            return NULL;
+        auto i_postings = i_values->second.find(condition.value);
+        if (i_postings == i_values->second.end())
+            return NULL;
+        return &i_postings->second;
+    };
+
+    // An upper bound on the number of matches, so a conjunction can start from its most selective operand
+    size_t estimate_matches(Document& doc, const TermQuery& condition)
+    {
+        if (condition.op == TermQuery::TERM)
+        {
+            auto postings = find_postings(doc, condition);
+            return postings ? postings->size() : 0;
+        }
+        size_t estimate = condition.op == TermQuery::AND ? SIZE_MAX : 0;
+        for (auto & operand : condition.operands)
+        {
+            if (condition.op == TermQuery::AND)
+                estimate = min(estimate, estimate_matches(doc, operand));
+            else
+                estimate += estimate_matches(doc, operand);
+        }
+        return estimate;
+    };
+
+    bool matches(Document& doc, const TermQuery& condition, SBOLObject* obj)
+    {
+        if (condition.op == TermQuery::TERM)
+        {
+            auto postings = find_postings(doc, condition);
+            return postings && postings->count(obj);
+        }
+        for (auto & operand : condition.operands)
+            if (matches(doc, operand, obj) == (condition.op == TermQuery::OR))
+                return condition.op == TermQuery::OR;
+        return condition.op == TermQuery::AND;
+    };
+
+    // Append the objects that satisfy a condition and have not been seen yet
+    void collect_matches(Document& doc, const TermQuery& condition, unordered_set<SBOLObject*>& seen, vector<SBOLObject*>& results)
+    {
+        if (condition.op == TermQuery::TERM)
+        {
+            auto postings = find_postings(doc, condition);
+            if (postings)
+                for (auto obj : *postings)
+                    if (seen.insert(obj).second)
+                        results.push_back(obj);
+        }
+        else if (condition.op == TermQuery::OR)
+        {
+            for (auto & operand : condition.operands)
+                collect_matches(doc, operand, seen, results);
+        }
+        else
+        {
+            // Enumerate the most selective operand and test the candidates against the others
+            size_t i_first = 0;
+            size_t first_estimate = SIZE_MAX;
+            for (size_t i_operand = 0; i_operand < condition.operands.size(); ++i_operand)
+            {
+                size_t estimate = estimate_matches(doc, condition.operands[i_operand]);
+                if (estimate < first_estimate)
+                {
+                    i_first = i_operand;
+                    first_estimate = estimate;
+                }
+            }
+            unordered_set<SBOLObject*> candidates_seen;
+            vector<SBOLObject*> candidates;
+            collect_matches(doc, condition.operands[i_first], candidates_seen, candidates);
+            for (auto obj : candidates)
+            {
+                bool all = true;
+                for (size_t i_operand = 0; i_operand < condition.operands.size() && all; ++i_operand)
+                    if (i_operand != i_first)
+                        all = matches(doc, condition.operands[i_operand], obj);
+                if (all && seen.insert(obj).second)
+                    results.push_back(obj);
+            }
+        }
+    };
+
+    TermQuery combine(TermQuery::Operator op, const TermQuery& a, const TermQuery& b)
+    {
+        TermQuery combined("", "");
+        combined.op = op;
+        for (auto operand : { &a, &b })
+        {
+            // Flatten chains of the same operator, so a & b & c is one conjunction
+            if (operand->op == op)
+                combined.operands.insert(combined.operands.end(), operand->operands.begin(), operand->operands.end());
+            else
+                combined.operands.push_back(*operand);
+        }
+        return combined;
+    };
+}
+
+TermQuery::TermQuery(std::string property_uri, std::string value) :
+    op(TERM),
+    property_uri(property_uri),
+    value(value)
+{
+};
+
+TermQuery TermQuery::ofType(std::string class_uri)
+{
+    return TermQuery(RDF_TYPE, class_uri);
+};
+
+TermQuery TermQuery::operator&(const TermQuery& other) const
+{
+    return combine(AND, *this, other);
+};
+
+TermQuery TermQuery::operator|(const TermQuery& other) const
+{
+    return combine(OR, *this, other);
+};
+
+void Document::index_new_object(SBOLObject& obj)
+{
+    if (lineage_valid && carries_lineage(obj))
+        lineage_valid = false;
+    if (term_index_valid)
+        term_index_dirty[&obj] = true;
+    if (text_index_valid)
+        text_index_dirty[&obj] = true;
+};
+
+void Document::unindex_object(SBOLObject& obj)
+{
+    if (lineage_valid && carries_lineage(obj))
+        lineage_valid = false;
+    if (!term_index_valid && !text_index_valid)
+        return;
+    vector<SBOLObject*> stack = { &obj };
+    while (stack.size())
+    {
+        SBOLObject* removed_obj = stack.back();
+        stack.pop_back();
+        if (term_index_valid)
+        {
+            remove_term_entries(*this, removed_obj);
+            term_index_dirty.erase(removed_obj);
+        }
+        if (text_index_valid)
+            unindex_text(*removed_obj);
+        for (auto & i_store : removed_obj->owned_objects)
+            stack.insert(stack.end(), i_store.second.begin(), i_store.second.end());
+    }
+};
+
+void Document::invalidate_indices()
+{
+    lineage_valid = false;
+    term_index_valid = false;
+    term_index_dirty.clear();
+    text_index_valid = false;
+    text_index_dirty.clear();
+};
+
+void Document::index_terms()
+{
+    if (term_index_valid)
+    {
+        if (term_index_dirty.empty())
+            return;  // Nothing to update. Queries on a frozen Document only read the index
+
+        // Re-index only the objects that were edited or added since the last query
+        vector<SBOLObject*> stack;
+        for (auto & i_dirty : term_index_dirty)
+        {
+            stack.push_back(i_dirty.first);
+            while (stack.size())
+            {
+                SBOLObject* obj = stack.back();
+                stack.pop_back();
+                remove_term_entries(*this, obj);
+                add_term_entries(*this, obj);
+                if (i_dirty.second)
+                    for (auto & i_store : obj->owned_objects)
+                        stack.insert(stack.end(), i_store.second.begin(), i_store.second.end());
+            }
+        }
+        term_index_dirty.clear();
+        return;
+    }
+    SBOL_STATS_TIMER("index_terms");
+    term_index.clear();
+    term_index_entries.clear();
+    term_index_dirty.clear();
+    vector<SBOLObject*> stack;
+    for (auto & i_obj : SBOLObjects)
+        stack.push_back(i_obj.second);
+    while (stack.size())
+    {
+        SBOLObject* obj = stack.back();
+        stack.pop_back();
+        add_term_entries(*this, obj);
+        for (auto & i_store : obj->owned_objects)
+            stack.insert(stack.end(), i_store.second.begin(), i_store.second.end());
+    }
+    SBOL_STATS_COUNT("indexed_objects", term_index_entries.size());
+    term_index_valid = true;
+};
+
+void Document::indexProperty(std::string property_uri)
+{
+    if (indexed_properties.insert(property_uri).second)
+        term_index_valid = false;
+};
+
+vector<SBOLObject*> Document::query(TermQuery condition)
+{
+    check_query(*this, condition);
+    index_terms();
+    unordered_set<SBOLObject*> seen;
+    vector<SBOLObject*> results;
+    collect_matches(*this, condition, seen, results);
+    return results;
+};
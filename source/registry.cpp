@@ -0,0 +1,211 @@
+/**
+ * @file    registry.cpp
+ * @brief   Integer ids and precomputed traits for the classes of the data model
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+#include "document.h"
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+
+using namespace sbol;
+using namespace std;
+
+namespace
+{
+    struct Registry
+    {
+        deque<ClassTraits> classes;  // A deque, so that references returned by ClassRegistry::get stay valid as classes are registered
+        unordered_map<string, int> ids_by_type;
+        unordered_map<type_index, int> ids_by_class;
+
+        // The class hierarchy is computed on first use after a registration, since it requires constructing an instance of each class
+        deque< vector<int> > bases;
+        deque< vector<int> > derived;
+        atomic<bool> hierarchy_valid;
+        mutex hierarchy_lock;
+
+        Registry() : hierarchy_valid(false) {};
+    };
+
+    void insert(Registry& registry, ClassTraits traits)
+    {
+        traits.id = (int)registry.classes.size();
+        registry.ids_by_type[traits.type] = traits.id;
+        if (registry.ids_by_class.count(traits.cpp_type) == 0)
+            registry.ids_by_class.insert({ traits.cpp_type, traits.id });
+        registry.classes.push_back(traits);
+        registry.hierarchy_valid = false;
+    }
+
+    Registry* register_core_classes()
+    {
+        Registry* registry = new Registry();
+        insert(*registry, ClassRegistry::traits<SBOLObject>(UNDEFINED));
+        insert(*registry, ClassRegistry::traits<ComponentDefinition>(SBOL_COMPONENT_DEFINITION));
+        insert(*registry, ClassRegistry::traits<SequenceAnnotation>(SBOL_SEQUENCE_ANNOTATION));
+        insert(*registry, ClassRegistry::traits<Sequence>(SBOL_SEQUENCE));
+        insert(*registry, ClassRegistry::traits<Component>(SBOL_COMPONENT));
+        insert(*registry, ClassRegistry::traits<FunctionalComponent>(SBOL_FUNCTIONAL_COMPONENT));
+        insert(*registry, ClassRegistry::traits<ModuleDefinition>(SBOL_MODULE_DEFINITION));
+        insert(*registry, ClassRegistry::traits<Module>(SBOL_MODULE));
+        insert(*registry, ClassRegistry::traits<Interaction>(SBOL_INTERACTION));
+        insert(*registry, ClassRegistry::traits<Participation>(SBOL_PARTICIPATION));
+        insert(*registry, ClassRegistry::traits<Model>(SBOL_MODEL));
+        insert(*registry, ClassRegistry::traits<SequenceConstraint>(SBOL_SEQUENCE_CONSTRAINT));
+        insert(*registry, ClassRegistry::traits<Range>(SBOL_RANGE));
+        insert(*registry, ClassRegistry::traits<MapsTo>(SBOL_MAPS_TO));
+        insert(*registry, ClassRegistry::traits<Cut>(SBOL_CUT));
+        insert(*registry, ClassRegistry::traits<Collection>(SBOL_COLLECTION));
+        insert(*registry, ClassRegistry::traits<GenericLocation>(SBOL_GENERIC_LOCATION));
+        insert(*registry, ClassRegistry::traits<Plan>(PROVO_PLAN));
+        insert(*registry, ClassRegistry::traits<Activity>(PROVO_ACTIVITY));
+        insert(*registry, ClassRegistry::traits<Agent>(PROVO_AGENT));
+        insert(*registry, ClassRegistry::traits<Usage>(PROVO_USAGE));
+        insert(*registry, ClassRegistry::traits<Attachment>(SBOL_ATTACHMENT));
+        insert(*registry, ClassRegistry::traits<CombinatorialDerivation>(SBOL_COMBINATORIAL_DERIVATION));
+        insert(*registry, ClassRegistry::traits<VariableComponent>(SBOL_VARIABLE_COMPONENT));
+        insert(*registry, ClassRegistry::traits<Implementation>(SBOL_IMPLEMENTATION));
+        insert(*registry, ClassRegistry::traits<Design>(SYSBIO_DESIGN));
+        insert(*registry, ClassRegistry::traits<Analysis>(SYSBIO_ANALYSIS));
+        insert(*registry, ClassRegistry::traits<SampleRoster>(SYSBIO_SAMPLE_ROSTER, SYSBIO_SAMPLE_ROSTER));
+        insert(*registry, ClassRegistry::traits<Build>(SYSBIO_BUILD, SYSBIO_BUILD));
+        insert(*registry, ClassRegistry::traits<Test>(SYSBIO_TEST, SYSBIO_TEST));
+        return registry;
+    }
+
+    Registry& registry()
+    {
+        static Registry* registry = register_core_classes();
+        return *registry;
+    }
+
+    // A class derives from every other registered class of which an instance of it is an instance
+    void index_hierarchy(Registry& registry)
+    {
+        if (registry.hierarchy_valid)
+            return;
+        lock_guard<mutex> lock(registry.hierarchy_lock);
+        if (registry.hierarchy_valid)
+            return;
+        size_t n = registry.classes.size();
+        vector<SBOLObject*> prototypes;
+        {
+            DeserializationScope constructing;  // Prototypes need no default values
+            for (auto &traits : registry.classes)
+                prototypes.push_back(&traits.constructor());
+        }
+        registry.bases.assign(n, {});
+        registry.derived.assign(n, {});
+        for (size_t i = 0; i < n; ++i)
+        {
+            registry.derived[i].push_back(i);
+            for (size_t j = 0; j < n; ++j)
+                if (i != j && registry.classes[j].is_instance(prototypes[i]) && !registry.classes[i].is_instance(prototypes[j]))
+                {
+                    registry.bases[i].push_back(j);
+                    registry.derived[j].push_back(i);
+                }
+        }
+        // The nearest base class is the one with the most bases of its own
+        for (auto &bases : registry.bases)
+            std::sort(bases.begin(), bases.end(), [&](int a, int b) { return registry.bases[a].size() > registry.bases[b].size(); });
+        for (auto &obj : prototypes)
+            delete obj;
+        registry.hierarchy_valid = true;
+    }
+}
+
+int ClassRegistry::add(ClassTraits traits)
+{
+    Registry& r = registry();
+    insert(r, traits);
+    return r.classes.back().id;
+}
+
+const ClassTraits* ClassRegistry::find(const rdf_type& type)
+{
+    Registry& r = registry();
+    auto i_id = r.ids_by_type.find(type);
+    if (i_id == r.ids_by_type.end())
+        return NULL;
+    return &r.classes[i_id->second];
+}
+
+const ClassTraits* ClassRegistry::find(type_index cpp_type)
+{
+    Registry& r = registry();
+    auto i_id = r.ids_by_class.find(cpp_type);
+    if (i_id == r.ids_by_class.end())
+        return NULL;
+    return &r.classes[i_id->second];
+}
+
+const ClassTraits& ClassRegistry::get(int id)
+{
+    Registry& r = registry();
+    if (id < 0 || id >= (int)r.classes.size())
+        throw SBOLError(SBOL_ERROR_NOT_FOUND, "No class is registered with id " + to_string(id));
+    return r.classes[id];
+}
+
+int ClassRegistry::size()
+{
+    return (int)registry().classes.size();
+}
+
+const vector<int>& ClassRegistry::bases(int id)
+{
+    get(id);
+    Registry& r = registry();
+    index_hierarchy(r);
+    return r.bases[id];
+}
+
+const vector<int>& ClassRegistry::derived(int id)
+{
+    get(id);
+    Registry& r = registry();
+    index_hierarchy(r);
+    return r.derived[id];
+}
+
+bool ClassRegistry::is_a(SBOLObject* obj, int id)
+{
+    const ClassTraits* traits = find(type_index(typeid(*obj)));
+    if (!traits)
+        return get(id).is_instance(obj);  // An unregistered subclass, such as a Python extension class
+    if (traits->id == id)
+        return true;
+    const vector<int>& class_bases = bases(traits->id);
+    return std::find(class_bases.begin(), class_bases.end(), id) != class_bases.end();
+}
+
+unordered_map<string, SBOLObject&(*)()> ClassRegistry::constructors()
+{
+    unordered_map<string, SBOLObject&(*)()> constructors;
+    for (auto &traits : registry().classes)
+        constructors[traits.type] = traits.constructor;
+    return constructors;
+}
@@ -49,7 +49,8 @@ namespace sbol
                          SBOL_ERROR_ORPHAN_OBJECT,
                          SBOL_ERROR_TYPE_MISMATCH,
                          SBOL_ERROR_BAD_HTTP_REQUEST,
-                         SBOL_ERROR_URI_NOT_UNIQUE
+                         SBOL_ERROR_URI_NOT_UNIQUE,
+                         SBOL_ERROR_FROZEN_DOCUMENT
                         };
 
 	//SBOLErrorCode SBOLError(SBOLErrorCode error_code, const std::string message);
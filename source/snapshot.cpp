@@ -0,0 +1,511 @@
+/**
+ * @file    snapshot.cpp
+ * @brief   Binary snapshot format for fast saving and loading of Documents
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+#include "document.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+
+#if defined(_WIN32)
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace sbol;
+using namespace std;
+
+// A snapshot file consists of a fixed header followed by flat tables. All integers are written in the byte order of the machine
+// that saved the snapshot, and all cross-references are indices into other tables, so loading never has to parse text.
+//
+//   strings     Every distinct string in the Document, as an array of n + 1 offsets into a blob of characters
+//   objects     One record per SBOLObject, in pre-order, so every parent precedes its children
+//   properties  One record per property of each object, pointing to a run of values
+//   values      String table indices of property values
+//   namespaces  Prefix and namespace pairs of the Document and its objects
+//   toplevels   The Document's property stores (componentDefinitions, sequences, etc.) and their members, in order
+//   register    The objects in the Document's object register, in iteration order
+namespace
+{
+    const char SNAPSHOT_MAGIC[8] = { 'S', 'B', 'O', 'L', 'S', 'N', 'A', 'P' };
+    const uint32_t SNAPSHOT_VERSION = 1;
+    const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+    const uint32_t NO_PARENT = 0xFFFFFFFF;
+    const uint32_t DOCUMENT_PARENT = 0xFFFFFFFE;
+
+    enum SnapshotObjectFlags
+    {
+        SNAPSHOT_TOP_LEVEL = 1,   // The object can be cast to TopLevel. Used to rebuild generic TopLevels whose class is not registered
+    };
+
+    struct SnapshotSection
+    {
+        uint64_t offset;
+        uint64_t count;
+    };
+
+    struct SnapshotHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        SnapshotSection strings;
+        SnapshotSection objects;
+        SnapshotSection properties;
+        SnapshotSection values;
+        SnapshotSection namespaces;
+        SnapshotSection toplevels;
+        SnapshotSection object_register;
+        uint32_t first_document_property;
+        uint32_t n_document_properties;
+    };
+
+    struct SnapshotObject
+    {
+        uint32_t type;              // String index of the RDF type
+        uint32_t flags;
+        uint32_t parent;            // Object index of the parent, or NO_PARENT or DOCUMENT_PARENT
+        uint32_t owner_property;    // String index of the parent's property that owns this object
+        uint32_t first_property;
+        uint32_t n_properties;
+    };
+
+    struct SnapshotProperty
+    {
+        uint32_t uri;
+        uint32_t first_value;
+        uint32_t n_values;
+    };
+
+    struct SnapshotNamespace
+    {
+        uint32_t object;            // Object index, or DOCUMENT_PARENT for the Document's own namespaces
+        uint32_t prefix;
+        uint32_t ns;
+    };
+
+    struct SnapshotTopLevel
+    {
+        uint32_t store;
+        uint32_t object;
+    };
+
+    // Accumulates the tables of a snapshot in memory while a Document is traversed
+    class SnapshotWriter
+    {
+    public:
+        vector<SnapshotObject> objects;
+        vector<SnapshotProperty> properties;
+        vector<uint32_t> values;
+        vector<SnapshotNamespace> namespaces;
+        vector<SnapshotTopLevel> toplevels;
+        vector<uint32_t> object_register;
+        vector<uint64_t> string_offsets = { 0 };
+        string string_blob;
+        unordered_map<string, uint32_t> string_index;
+        unordered_map<SBOLObject*, uint32_t> object_index;
+
+        uint32_t intern(const string& s)
+        {
+            auto i_string = string_index.find(s);
+            if (i_string != string_index.end())
+                return i_string->second;
+            uint32_t id = (uint32_t)string_offsets.size() - 1;
+            string_blob += s;
+            string_offsets.push_back(string_blob.size());
+            string_index[s] = id;
+            return id;
+        };
+
+        void add_properties(SBOLObject& obj, uint32_t& first_property, uint32_t& n_properties)
+        {
+            first_property = (uint32_t)properties.size();
+            n_properties = (uint32_t)obj.properties.size();
+            for (auto & i_property : obj.properties)
+            {
+                SnapshotProperty property;
+                property.uri = intern(i_property.first);
+                property.first_value = (uint32_t)values.size();
+                property.n_values = (uint32_t)i_property.second.size();
+                for (auto & value : i_property.second)
+                    values.push_back(intern(value));
+                properties.push_back(property);
+            }
+        };
+
+        // Record an object. Objects it owns are recorded separately, after it
+        uint32_t add_object(SBOLObject& obj, uint32_t parent, const string& owner_property)
+        {
+            uint32_t i_obj = (uint32_t)objects.size();
+            object_index[&obj] = i_obj;
+            SnapshotObject record;
+            record.type = intern(obj.type);
+            record.flags = dynamic_cast<TopLevel*>(&obj) ? SNAPSHOT_TOP_LEVEL : 0;
+            record.parent = parent;
+            record.owner_property = intern(owner_property);
+            add_properties(obj, record.first_property, record.n_properties);
+            objects.push_back(record);
+            return i_obj;
+        };
+    };
+
+    // A read-only view of a snapshot file. The file is memory-mapped where the platform supports it
+    class SnapshotFile
+    {
+    public:
+        const char* data = NULL;
+        uint64_t size = 0;
+
+        SnapshotFile(string filename)
+        {
+#if defined(_WIN32)
+            ifstream fh(filename.c_str(), ios::binary);
+            if (!fh)
+                throw SBOLError(SBOL_ERROR_FILE_NOT_FOUND, "File " + filename + " not found");
+            buffer.assign(istreambuf_iterator<char>(fh), istreambuf_iterator<char>());
+            data = buffer.data();
+            size = buffer.size();
+#else
+            fd = open(filename.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw SBOLError(SBOL_ERROR_FILE_NOT_FOUND, "File " + filename + " not found");
+            struct stat file_status;
+            if (fstat(fd, &file_status) != 0)
+            {
+                close(fd);
+                throw SBOLError(SBOL_ERROR_FILE_NOT_FOUND, "File " + filename + " could not be opened");
+            }
+            size = (uint64_t)file_status.st_size;
+            if (size)
+            {
+                void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapping == MAP_FAILED)
+                {
+                    close(fd);
+                    throw SBOLError(SBOL_ERROR_FILE_NOT_FOUND, "File " + filename + " could not be mapped into memory");
+                }
+                data = (const char*)mapping;
+            }
+#endif
+        };
+
+        ~SnapshotFile()
+        {
+#if !defined(_WIN32)
+            if (data)
+                munmap((void*)data, size);
+            if (fd >= 0)
+                close(fd);
+#endif
+        };
+
+        // Get a table of records, checking that it lies inside the file
+        template < class Record > const Record* table(const SnapshotSection& section, string name) const
+        {
+            if (section.offset > size || section.offset % alignof(Record) || section.count > (size - section.offset) / sizeof(Record))
+                throw SBOLError(SBOL_ERROR_SERIALIZATION, "Invalid snapshot. The " + name + " table is truncated or misaligned");
+            return (const Record*)(data + section.offset);
+        };
+
+    private:
+#if defined(_WIN32)
+        vector<char> buffer;
+#else
+        int fd = -1;
+#endif
+    };
+
+    void check_index(uint64_t index, uint64_t count, const char* table)
+    {
+        if (index >= count)
+            throw SBOLError(SBOL_ERROR_SERIALIZATION, string("Invalid snapshot. Reference out of range in the ") + table + " table");
+    };
+
+    void check_range(uint64_t first, uint64_t n, uint64_t count, const char* table)
+    {
+        if (first > count || n > count - first)
+            throw SBOLError(SBOL_ERROR_SERIALIZATION, string("Invalid snapshot. Range out of bounds in the ") + table + " table");
+    };
+}
+
+void Document::saveSnapshot(std::string filename)
+{
+    SBOL_STATS_TIMER("snapshot_save");
+    SnapshotWriter writer;
+
+    // Objects are recorded in pre-order, starting from the object register and then the property stores, so that ownership
+    // edges can be restored in their original order simply by appending each object to its parent
+    function<void(SBOLObject&, uint32_t, const string&)> traverse = [&](SBOLObject& obj, uint32_t parent, const string& owner_property)
+    {
+        if (writer.object_index.count(&obj))
+            return;  // Objects referenced from more than one place are recorded once
+        uint32_t i_obj = writer.add_object(obj, parent, owner_property);
+        for (auto & i_ns : obj.namespaces)
+            writer.namespaces.push_back({ i_obj, writer.intern(i_ns.first), writer.intern(i_ns.second) });
+        for (auto & i_store : obj.owned_objects)
+            for (auto & child : i_store.second)
+                traverse(*child, i_obj, i_store.first);
+    };
+    for (auto & i_obj : SBOLObjects)
+    {
+        SBOLObject& obj = *i_obj.second;
+        traverse(obj, obj.parent == this ? DOCUMENT_PARENT : NO_PARENT, "");
+        writer.object_register.push_back(writer.object_index[&obj]);
+    }
+    for (auto & i_store : owned_objects)
+        for (auto & obj : i_store.second)
+        {
+            traverse(*obj, obj->parent == this ? DOCUMENT_PARENT : NO_PARENT, "");
+            writer.toplevels.push_back({ writer.intern(i_store.first), writer.object_index[obj] });
+        }
+
+    uint32_t first_document_property, n_document_properties;
+    writer.add_properties(*this, first_document_property, n_document_properties);
+    for (auto & i_ns : namespaces)
+        writer.namespaces.push_back({ DOCUMENT_PARENT, writer.intern(i_ns.first), writer.intern(i_ns.second) });
+    if (writer.string_offsets.size() > NO_PARENT || writer.objects.size() >= DOCUMENT_PARENT || writer.values.size() > NO_PARENT)
+        throw SBOLError(SBOL_ERROR_SERIALIZATION, "Cannot save snapshot. The Document is too large for the snapshot format");
+
+    // Lay out the tables one after another, each aligned to 8 bytes
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.first_document_property = first_document_property;
+    header.n_document_properties = n_document_properties;
+
+    uint64_t offset = sizeof(SnapshotHeader);
+    auto place = [&](SnapshotSection& section, uint64_t count, uint64_t record_size)
+    {
+        offset = (offset + 7) & ~(uint64_t)7;
+        section.offset = offset;
+        section.count = count;
+        offset += count * record_size;
+    };
+    place(header.strings, writer.string_offsets.size() - 1, sizeof(uint64_t));
+    offset += sizeof(uint64_t) + writer.string_blob.size();  // The final offset and the character blob follow the offsets
+    place(header.objects, writer.objects.size(), sizeof(SnapshotObject));
+    place(header.properties, writer.properties.size(), sizeof(SnapshotProperty));
+    place(header.values, writer.values.size(), sizeof(uint32_t));
+    place(header.namespaces, writer.namespaces.size(), sizeof(SnapshotNamespace));
+    place(header.toplevels, writer.toplevels.size(), sizeof(SnapshotTopLevel));
+    place(header.object_register, writer.object_register.size(), sizeof(uint32_t));
+
+    ofstream fh(filename.c_str(), ios::binary | ios::trunc);
+    if (!fh)
+        throw SBOLError(SBOL_ERROR_FILE_NOT_FOUND, "Cannot save snapshot. File " + filename + " could not be opened");
+    auto write_at = [&](uint64_t position, const void* bytes, uint64_t n_bytes)
+    {
+        static const char padding[8] = { 0 };
+        uint64_t current = (uint64_t)fh.tellp();
+        if (position > current)
+            fh.write(padding, position - current);
+        if (n_bytes)
+            fh.write((const char*)bytes, n_bytes);
+    };
+    write_at(0, &header, sizeof(header));
+    write_at(header.strings.offset, writer.string_offsets.data(), writer.string_offsets.size() * sizeof(uint64_t));
+    write_at(header.strings.offset + writer.string_offsets.size() * sizeof(uint64_t), writer.string_blob.data(), writer.string_blob.size());
+    write_at(header.objects.offset, writer.objects.data(), writer.objects.size() * sizeof(SnapshotObject));
+    write_at(header.properties.offset, writer.properties.data(), writer.properties.size() * sizeof(SnapshotProperty));
+    write_at(header.values.offset, writer.values.data(), writer.values.size() * sizeof(uint32_t));
+    write_at(header.namespaces.offset, writer.namespaces.data(), writer.namespaces.size() * sizeof(SnapshotNamespace));
+    write_at(header.toplevels.offset, writer.toplevels.data(), writer.toplevels.size() * sizeof(SnapshotTopLevel));
+    write_at(header.object_register.offset, writer.object_register.data(), writer.object_register.size() * sizeof(uint32_t));
+    if (!fh)
+        throw SBOLError(SBOL_ERROR_SERIALIZATION, "Cannot save snapshot. Writing " + filename + " failed");
+};
+
+void Document::loadSnapshot(std::string filename)
+{
+    SBOL_STATS_TIMER("snapshot_load");
+    check_mutable(this);
+    check_no_transaction("load a snapshot into");
+    ReloadScope reloading(*this);
+    SnapshotFile file(filename);
+
+    // Check the header and every table before the Document is touched, so a corrupt file leaves the Document intact
+    if (file.size < sizeof(SnapshotHeader) || memcmp(file.data, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+        throw SBOLError(SBOL_ERROR_SERIALIZATION, "Cannot load snapshot. " + filename + " is not an SBOL snapshot");
+    SnapshotHeader header;
+    memcpy(&header, file.data, sizeof(header));
+    if (header.version != SNAPSHOT_VERSION)
+        throw SBOLError(SBOL_ERROR_SERIALIZATION, "Cannot load snapshot. " + filename + " was written in snapshot format version " + to_string(header.version) + " but this version of libSBOL reads version " + to_string(SNAPSHOT_VERSION));
+    if (header.byte_order != SNAPSHOT_BYTE_ORDER)
+        throw SBOLError(SBOL_ERROR_SERIALIZATION, "Cannot load snapshot. " + filename + " was written on a machine with a different byte order");
+
+    SnapshotSection string_offsets_section = { header.strings.offset, header.strings.count + 1 };
+    const uint64_t* string_offsets = file.table<uint64_t>(string_offsets_section, "string");
+    const char* string_blob = file.data + header.strings.offset + string_offsets_section.count * sizeof(uint64_t);
+    uint64_t blob_size = file.size - (string_blob - file.data);
+    for (uint64_t i_string = 0; i_string < header.strings.count; ++i_string)
+        if (string_offsets[i_string] > string_offsets[i_string + 1] || string_offsets[i_string + 1] > blob_size)
+            throw SBOLError(SBOL_ERROR_SERIALIZATION, "Invalid snapshot. The string table is corrupt");
+    const SnapshotObject* objects = file.table<SnapshotObject>(header.objects, "object");
+    const SnapshotProperty* snapshot_properties = file.table<SnapshotProperty>(header.properties, "property");
+    const uint32_t* values = file.table<uint32_t>(header.values, "value");
+    const SnapshotNamespace* snapshot_namespaces = file.table<SnapshotNamespace>(header.namespaces, "namespace");
+    const SnapshotTopLevel* toplevels = file.table<SnapshotTopLevel>(header.toplevels, "toplevel");
+    const uint32_t* object_register = file.table<uint32_t>(header.object_register, "register");
+
+    for (uint64_t i_value = 0; i_value < header.values.count; ++i_value)
+        check_index(values[i_value], header.strings.count, "value");
+    for (uint64_t i_property = 0; i_property < header.properties.count; ++i_property)
+    {
+        check_index(snapshot_properties[i_property].uri, header.strings.count, "property");
+        check_range(snapshot_properties[i_property].first_value, snapshot_properties[i_property].n_values, header.values.count, "property");
+    }
+    check_range(header.first_document_property, header.n_document_properties, header.properties.count, "property");
+    for (uint64_t i_obj = 0; i_obj < header.objects.count; ++i_obj)
+    {
+        const SnapshotObject& record = objects[i_obj];
+        check_index(record.type, header.strings.count, "object");
+        check_index(record.owner_property, header.strings.count, "object");
+        check_range(record.first_property, record.n_properties, header.properties.count, "object");
+        if (record.parent != NO_PARENT && record.parent != DOCUMENT_PARENT && record.parent >= i_obj)
+            throw SBOLError(SBOL_ERROR_SERIALIZATION, "Invalid snapshot. An object precedes its parent in the object table");
+    }
+    for (uint64_t i_ns = 0; i_ns < header.namespaces.count; ++i_ns)
+    {
+        if (snapshot_namespaces[i_ns].object != DOCUMENT_PARENT)
+            check_index(snapshot_namespaces[i_ns].object, header.objects.count, "namespace");
+        check_index(snapshot_namespaces[i_ns].prefix, header.strings.count, "namespace");
+        check_index(snapshot_namespaces[i_ns].ns, header.strings.count, "namespace");
+    }
+    for (uint64_t i_toplevel = 0; i_toplevel < header.toplevels.count; ++i_toplevel)
+    {
+        check_index(toplevels[i_toplevel].store, header.strings.count, "toplevel");
+        check_index(toplevels[i_toplevel].object, header.objects.count, "toplevel");
+    }
+    for (uint64_t i_register = 0; i_register < header.object_register.count; ++i_register)
+        check_index(object_register[i_register], header.objects.count, "register");
+
+    // Each string is copied out of the mapped file into the Document. Nothing refers to the mapping once loading is done
+    auto get_string = [&](uint32_t id)
+    {
+        return string(string_blob + string_offsets[id], string_offsets[id + 1] - string_offsets[id]);
+    };
+    auto load_properties = [&](SBOLObject& obj, uint32_t first_property, uint32_t n_properties)
+    {
+        for (uint32_t i_property = first_property; i_property < first_property + n_properties; ++i_property)
+        {
+            const SnapshotProperty& property = snapshot_properties[i_property];
+            vector<string>& value_store = obj.properties[get_string(property.uri)];
+            value_store.clear();
+            value_store.reserve(property.n_values);
+            for (uint32_t i_value = property.first_value; i_value < property.first_value + property.n_values; ++i_value)
+                value_store.push_back(get_string(values[i_value]));
+        }
+    };
+
+    wipe();
+    load_properties(*this, header.first_document_property, header.n_document_properties);
+
+    // Construct objects with the same classes the RDF parser would choose. Property values from the snapshot replace the
+    // defaults assigned by constructors, so no default values need to be wiped first
+    vector<SBOLObject*> loaded_objects(header.objects.count, NULL);
+    for (uint64_t i_obj = 0; i_obj < header.objects.count; ++i_obj)
+    {
+        const SnapshotObject& record = objects[i_obj];
+        string type = get_string(record.type);
+        SBOLObject* new_obj = NULL;
+#if defined(SBOL_BUILD_PYTHON2) || defined(SBOL_BUILD_PYTHON3)
+        typedef struct {
+            PyObject_HEAD
+            void *ptr; // This is the pointer to the actual C++ instance
+            void *ty;  // swig_type_info originally, but shouldn't matter
+            int own;
+            PyObject *next;
+        } SwigPyObject;
+        PyObject* py_obj = NULL;
+        if (Config::PYTHON_DATA_MODEL_REGISTER.count(type) == 1)
+        {
+            PyObject* constructor = Config::PYTHON_DATA_MODEL_REGISTER[type];
+            PyGILState_STATE gil_state = PyGILState_Ensure();  // The Python wrapper releases the GIL while loading
+            py_obj = PyObject_CallFunction(constructor, NULL);
+            SwigPyObject* swig_py_object = (SwigPyObject*)PyObject_GetAttrString(py_obj, "this");
+            new_obj = (SBOLObject *)swig_py_object->ptr;
+            Py_DECREF((PyObject*)swig_py_object);  // The wrapper is still referenced by py_obj, which keeps the C++ object alive
+            PyGILState_Release(gil_state);
+        }
+        else
+#endif
+        if (SBOL_DATA_MODEL_REGISTER.count(type) == 1)
+            new_obj = &SBOL_DATA_MODEL_REGISTER[type]();
+        else if (record.flags & SNAPSHOT_TOP_LEVEL)
+            new_obj = new TopLevel(type);
+        else
+        {
+            new_obj = new SBOLObject();
+            new_obj->type = type;
+        }
+        load_properties(*new_obj, record.first_property, record.n_properties);
+        new_obj->doc = this;
+
+        if (record.parent == DOCUMENT_PARENT)
+            new_obj->parent = this;
+        else if (record.parent == NO_PARENT)
+            new_obj->parent = NULL;
+        else
+        {
+            SBOLObject* parent_obj = loaded_objects[record.parent];
+            new_obj->parent = parent_obj;
+            parent_obj->owned_objects[get_string(record.owner_property)].push_back(new_obj);
+        }
+#if defined(SBOL_BUILD_PYTHON2) || defined(SBOL_BUILD_PYTHON3)
+        if (py_obj)
+        {
+            if (record.parent == DOCUMENT_PARENT || record.parent == NO_PARENT)
+                PythonObjects[new_obj->identity.get()] = py_obj;
+            else
+                loaded_objects[record.parent]->PythonObjects[new_obj->identity.get()] = py_obj;
+        }
+#endif
+        loaded_objects[i_obj] = new_obj;
+    }
+    SBOL_STATS_COUNT("objects_created", header.objects.count);
+
+    for (uint64_t i_toplevel = 0; i_toplevel < header.toplevels.count; ++i_toplevel)
+        owned_objects[get_string(toplevels[i_toplevel].store)].push_back(loaded_objects[toplevels[i_toplevel].object]);
+    SBOLObjects.reserve(header.object_register.count);
+    for (uint64_t i_register = 0; i_register < header.object_register.count; ++i_register)
+    {
+        SBOLObject* obj = loaded_objects[object_register[i_register]];
+        SBOLObjects[obj->identity.get()] = obj;
+    }
+    for (uint64_t i_ns = 0; i_ns < header.namespaces.count; ++i_ns)
+    {
+        const SnapshotNamespace& ns = snapshot_namespaces[i_ns];
+        SBOLObject& obj = ns.object == DOCUMENT_PARENT ? *this : *loaded_objects[ns.object];
+        obj.namespaces[get_string(ns.prefix)] = get_string(ns.ns);
+    }
+    notify_change(SBOL_CHANGE_RELOADED, this, "", "");
+};
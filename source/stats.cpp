@@ -0,0 +1,251 @@
+/**
+ * @file    stats.cpp
+ * @brief   Performance counters, phase timers and trace events
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+#include "stats.h"
+
+#include <map>
+#include <mutex>
+#include <thread>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+using namespace sbol;
+using namespace std;
+
+namespace
+{
+    struct PhaseTimer
+    {
+        double seconds = 0;
+        long long calls = 0;
+    };
+
+    struct TraceEvent
+    {
+        const char* phase;
+        long long start_us;
+        long long duration_us;
+        size_t thread_id;
+    };
+
+    // All collected values are guarded by one mutex, which is only taken while collection is enabled. Counters are the exception. Each is looked up once per instrumented site and then incremented atomically
+    std::mutex stats_mutex;
+    map<string, PhaseTimer> phase_timers;
+    map<string, unique_ptr<StatsCounter>> counters;
+    vector<TraceEvent> trace_events;
+    chrono::steady_clock::time_point trace_epoch = chrono::steady_clock::now();
+
+    // Phases currently open on this thread, used to fold re-entrant calls into the outermost call
+    thread_local vector<const char*> open_phases;
+
+    string escape_json(const string& text)
+    {
+        string escaped;
+        for (auto c : text)
+        {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    };
+}
+
+std::atomic<bool> Stats::enabled(false);
+std::atomic<bool> Stats::tracing(false);
+
+void Stats::enable(bool trace)
+{
+    tracing.store(trace);
+    enabled.store(true);
+};
+
+void Stats::disable()
+{
+    enabled.store(false);
+    tracing.store(false);
+};
+
+void Stats::reset()
+{
+    lock_guard<mutex> lock(stats_mutex);
+    phase_timers.clear();
+    // The instrumented sites keep references to their counters, so counters are zeroed rather than removed
+    for (auto & counter : counters)
+    {
+        counter.second->value.store(0);
+        counter.second->used.store(false);
+    }
+    trace_events.clear();
+    trace_epoch = chrono::steady_clock::now();
+};
+
+double Stats::getTime(std::string phase)
+{
+    lock_guard<mutex> lock(stats_mutex);
+    auto i_timer = phase_timers.find(phase);
+    if (i_timer == phase_timers.end())
+        return 0;
+    return i_timer->second.seconds;
+};
+
+long long Stats::getCalls(std::string phase)
+{
+    lock_guard<mutex> lock(stats_mutex);
+    auto i_timer = phase_timers.find(phase);
+    if (i_timer == phase_timers.end())
+        return 0;
+    return i_timer->second.calls;
+};
+
+long long Stats::getCount(std::string counter)
+{
+    lock_guard<mutex> lock(stats_mutex);
+    auto i_counter = counters.find(counter);
+    if (i_counter == counters.end())
+        return 0;
+    return i_counter->second->value.load();
+};
+
+vector<string> Stats::getPhases()
+{
+    lock_guard<mutex> lock(stats_mutex);
+    vector<string> phases;
+    for (auto & timer : phase_timers)
+        phases.push_back(timer.first);
+    return phases;
+};
+
+vector<string> Stats::getCounters()
+{
+    lock_guard<mutex> lock(stats_mutex);
+    vector<string> counter_names;
+    for (auto & counter : counters)
+        if (counter.second->used.load())
+            counter_names.push_back(counter.first);
+    return counter_names;
+};
+
+string Stats::report()
+{
+    lock_guard<mutex> lock(stats_mutex);
+    ostringstream out;
+    out << left << setw(28) << "Phase" << right << setw(14) << "Seconds" << setw(10) << "Calls" << endl;
+    for (auto & timer : phase_timers)
+        out << left << setw(28) << timer.first << right << setw(14) << fixed << setprecision(6) << timer.second.seconds << setw(10) << timer.second.calls << endl;
+    out << endl;
+    out << left << setw(28) << "Counter" << right << setw(14) << "Value" << endl;
+    for (auto & counter : counters)
+        if (counter.second->used.load())
+            out << left << setw(28) << counter.first << right << setw(14) << counter.second->value.load() << endl;
+    return out.str();
+};
+
+string Stats::getTrace()
+{
+    lock_guard<mutex> lock(stats_mutex);
+    ostringstream out;
+    out << "{\"traceEvents\":[";
+    for (size_t i_event = 0; i_event < trace_events.size(); ++i_event)
+    {
+        TraceEvent& event = trace_events[i_event];
+        if (i_event)
+            out << ",";
+        out << "\n{\"name\":\"" << escape_json(event.phase) << "\",\"cat\":\"sbol\",\"ph\":\"X\",\"ts\":" << event.start_us << ",\"dur\":" << event.duration_us << ",\"pid\":1,\"tid\":" << event.thread_id << "}";
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return out.str();
+};
+
+void Stats::writeTrace(std::string filename)
+{
+    ofstream fh(filename.c_str());
+    if (!fh)
+        throw SBOLError(SBOL_ERROR_FILE_NOT_FOUND, "Cannot write trace. File " + filename + " could not be opened");
+    fh << getTrace();
+};
+
+void Stats::add_time(const char* phase, chrono::steady_clock::time_point start, chrono::steady_clock::time_point end)
+{
+    lock_guard<mutex> lock(stats_mutex);
+    PhaseTimer& timer = phase_timers[phase];
+    timer.seconds += chrono::duration<double>(end - start).count();
+    timer.calls += 1;
+    if (tracing.load(memory_order_relaxed))
+    {
+        TraceEvent event;
+        event.phase = phase;
+        event.start_us = chrono::duration_cast<chrono::microseconds>(start - trace_epoch).count();
+        event.duration_us = chrono::duration_cast<chrono::microseconds>(end - start).count();
+        event.thread_id = hash<thread::id>()(this_thread::get_id()) % 100000;
+        trace_events.push_back(event);
+    }
+};
+
+StatsCounter& Stats::get_counter(const char* counter)
+{
+    lock_guard<mutex> lock(stats_mutex);
+    unique_ptr<StatsCounter>& handle = counters[counter];
+    if (!handle)
+        handle.reset(new StatsCounter());
+    return *handle;
+};
+
+void StatsTimer::begin()
+{
+    for (auto & open_phase : open_phases)
+        if (strcmp(open_phase, phase) == 0)
+            return;
+    open_phases.push_back(phase);
+    active = true;
+    start = chrono::steady_clock::now();
+};
+
+void StatsTimer::end()
+{
+    Stats::add_time(phase, start, chrono::steady_clock::now());
+    open_phases.erase(std::find(open_phases.begin(), open_phases.end(), phase));  // Only the outermost timer of a phase is active
+};
+
+CURLcode sbol::perform_request(CURL* curl)
+{
+    if (!Stats::isEnabled())
+        return curl_easy_perform(curl);
+
+    SBOL_STATS_TIMER("http_request");
+    CURLcode res = curl_easy_perform(curl);
+    curl_off_t bytes_sent = 0;
+    curl_off_t bytes_received = 0;
+    curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD_T, &bytes_sent);
+    curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &bytes_received);
+    SBOL_STATS_COUNT("http_requests", 1);
+    SBOL_STATS_COUNT("http_bytes_sent", (long long)bytes_sent);
+    SBOL_STATS_COUNT("http_bytes_received", (long long)bytes_received);
+    return res;
+};
@@ -0,0 +1,186 @@
+/**
+ * @file    stats.h
+ * @brief   Performance counters, phase timers and trace events
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+#ifndef STATS_INCLUDED
+#define STATS_INCLUDED
+
+#include "config.h"
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+
+namespace sbol
+{
+    /// Collects timers and counters for the phases of reading, writing, copying and online requests. Like Config, Stats is used as a static class. Collection is off by default, and while it is off each instrumented site costs a single flag check.
+    /// | Phase                     | Description                                                    |
+    /// | :------------------------ | :------------------------------------------------------------- |
+    /// | read                      | Total time spent in Document::read, append and readString      |
+    /// | parse_objects             | First raptor pass, which constructs SBOL objects               |
+    /// | parse_properties          | Second raptor pass, which assigns property values              |
+    /// | parse_annotation_objects  | Resolution of nested annotation objects                        |
+    /// | parse_extension_objects   | Conversion of objects outside the SBOL core, eg, Build and Test |
+    /// | write                     | Total time spent in Document::write and writeString            |
+    /// | serialize                 | Generation of flat RDF by raptor                               |
+    /// | nest                      | Conversion of flat RDF/XML into nested SBOL                    |
+    /// | compress                  | Compression of files written with a .gz or .zst extension      |
+    /// | freeze                    | Document::freeze, which builds the indices read by queries     |
+    /// | rollback                  | Document::rollback, which undoes the changes in a transaction  |
+    /// | validate                  | Online validation                                              |
+    /// | copy                      | Identified::copy, counted once per outermost call               |
+    /// | http_request              | Latency of HTTP requests to the validator and to PartShops     |
+    ///
+    /// | Counter                   | Description                                                    |
+    /// | :------------------------ | :------------------------------------------------------------- |
+    /// | triples_parsed            | Triples read from RDF                                          |
+    /// | objects_created           | Objects constructed by the parser or by OwnedObject::create    |
+    /// | find_calls                | Searches of the whole Document by URI                          |
+    /// | bytes_serialized          | Bytes of SBOL produced by write and writeString                |
+    /// | bytes_compressed          | Bytes of compressed SBOL written to .gz and .zst files         |
+    /// | changes_rolled_back       | Entries of the undo log applied by Document::rollback          |
+    /// | http_requests             | Number of HTTP requests                                        |
+    /// | http_bytes_sent           | Bytes uploaded by HTTP requests                                |
+    /// | http_bytes_received       | Bytes downloaded by HTTP requests                              |
+    /// @cond
+    // A counter, interned once per instrumented site, so incrementing it takes neither a lock nor a lookup by name
+    class SBOL_DECLSPEC StatsCounter
+    {
+    public:
+        std::atomic<long long> value;
+        std::atomic<bool> used;  // Set by the first increment after a reset, so the counter is listed
+
+        StatsCounter() :
+            value(0),
+            used(false)
+        {};
+
+        void add(long long n)
+        {
+            value.fetch_add(n, std::memory_order_relaxed);
+            if (!used.load(std::memory_order_relaxed))
+                used.store(true, std::memory_order_relaxed);
+        };
+    };
+    /// @endcond
+
+    class SBOL_DECLSPEC Stats
+    {
+    friend class StatsTimer;
+
+    private:
+        static std::atomic<bool> enabled;
+        static std::atomic<bool> tracing;
+
+    public:
+        /// Start collecting timers and counters
+        /// @param trace If true, each timed phase is also recorded as a trace event
+        static void enable(bool trace = false);
+
+        /// Stop collecting. Values collected so far are retained until reset is called
+        static void disable();
+
+        /// @return True if timers and counters are being collected
+        static bool isEnabled()
+        {
+            return enabled.load(std::memory_order_relaxed);
+        };
+
+        /// Discard all timers, counters and trace events
+        static void reset();
+
+        /// @param phase The name of a phase, eg, "parse_properties"
+        /// @return The total time in seconds spent in the phase
+        static double getTime(std::string phase);
+
+        /// @param phase The name of a phase, eg, "parse_properties"
+        /// @return The number of times the phase was entered
+        static long long getCalls(std::string phase);
+
+        /// @param counter The name of a counter, eg, "triples_parsed"
+        /// @return The current value of the counter
+        static long long getCount(std::string counter);
+
+        /// @return The names of all phases that have been timed
+        static std::vector<std::string> getPhases();
+
+        /// @return The names of all counters that have been incremented
+        static std::vector<std::string> getCounters();
+
+        /// @return A human-readable table of all timers and counters
+        static std::string report();
+
+        /// @return Recorded trace events in the Chrome trace-event JSON format, which can be loaded in chrome://tracing or Perfetto
+        static std::string getTrace();
+
+        /// Write recorded trace events to a file in the Chrome trace-event JSON format
+        /// @param filename The full path of the output file
+        static void writeTrace(std::string filename);
+
+        /// @cond
+        static void add_time(const char* phase, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+        static StatsCounter& get_counter(const char* counter);
+        /// @endcond
+    };
+
+    /// @cond
+    // Times the enclosing scope as a phase. Re-entrant calls to the same phase on a thread are folded into the outermost call.
+    class SBOL_DECLSPEC StatsTimer
+    {
+    private:
+        const char* phase;
+        bool active;
+        std::chrono::steady_clock::time_point start;
+        void begin();
+        void end();
+
+    public:
+        StatsTimer(const char* phase) :
+            phase(phase),
+            active(false)
+        {
+            if (Stats::isEnabled())
+                begin();
+        };
+        ~StatsTimer()
+        {
+            if (active)
+                end();
+        };
+    };
+
+    // Perform a curl request, recording its latency and the number of bytes transferred
+    SBOL_DECLSPEC CURLcode perform_request(CURL* curl);
+    /// @endcond
+}
+
+/// @cond
+#define SBOL_STATS_CONCAT_(a, b) a ## b
+#define SBOL_STATS_CONCAT(a, b) SBOL_STATS_CONCAT_(a, b)
+#define SBOL_STATS_TIMER(phase) sbol::StatsTimer SBOL_STATS_CONCAT(sbol_stats_timer_, __LINE__)(phase)
+#define SBOL_STATS_COUNT(counter, n) do { if (sbol::Stats::isEnabled()) { static sbol::StatsCounter& sbol_stats_counter = sbol::Stats::get_counter(counter); sbol_stats_counter.add(n); } } while (0)
+/// @endcond
+
+#endif /* STATS_INCLUDED */
@@ -0,0 +1,413 @@
+/**
+ * @file    textsearch.cpp
+ * @brief   Embedded full-text search of a Document
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+#include "document.h"
+#include "partshop.h"
+
+#include <cmath>
+#include <cctype>
+
+using namespace sbol;
+using namespace std;
+
+namespace
+{
+    // A search condition on the words in one indexed text property, or in any of them if field is -1
+    struct TextCriterion
+    {
+        int field;
+        string token;
+    };
+
+    // Split text into lower-case tokens at every character that is not a letter or digit. The bytes of multi-byte UTF-8 characters are kept in tokens
+    void tokenize(const string& text, vector<string>& tokens)
+    {
+        string token;
+        for (char c : text)
+        {
+            if (isalnum((unsigned char)c) || (unsigned char)c >= 0x80)
+                token.push_back((char)tolower((unsigned char)c));
+            else if (token.size())
+            {
+                tokens.push_back(token);
+                token.clear();
+            }
+        }
+        if (token.size())
+            tokens.push_back(token);
+    };
+
+    // Get the first value of a property without the angle brackets or quotes it is stored with
+    string stored_text(SBOLObject& obj, const string& property_uri)
+    {
+        auto i_property = obj.properties.find(property_uri);
+        if (i_property == obj.properties.end() || i_property->second.empty() || i_property->second.front().length() < 2)
+            return "";
+        const string& value = i_property->second.front();
+        return value.substr(1, value.length() - 2);
+    };
+
+    void remove_text_postings(Document& doc, SBOLObject* obj)
+    {
+        auto i_id = doc.text_index_ids.find(obj);
+        if (i_id == doc.text_index_ids.end())
+            return;
+        doc.text_index_objects[i_id->second] = NULL;
+        doc.text_index_ids.erase(i_id);
+    };
+
+    void add_text_postings(Document& doc, SBOLObject* obj)
+    {
+        uint32_t object_id = (uint32_t)doc.text_index_objects.size();
+        bool indexed = false;
+        vector<string> tokens;
+        for (uint32_t field = 0; field < doc.text_properties.size(); ++field)
+        {
+            auto i_property = obj->properties.find(doc.text_properties[field].first);
+            if (i_property == obj->properties.end())
+                continue;
+            tokens.clear();
+            for (auto & value : i_property->second)
+                if (value.length() > 2 && value.front() == '"')
+                    tokenize(value.substr(1, value.length() - 2), tokens);
+            sort(tokens.begin(), tokens.end());
+            tokens.erase(unique(tokens.begin(), tokens.end()), tokens.end());
+            for (auto & token : tokens)
+                doc.text_index[token].push_back({ object_id, field });
+            indexed = indexed || tokens.size();
+        }
+        if (indexed)
+        {
+            doc.text_index_objects.push_back(obj);
+            doc.text_index_ids[obj] = object_id;
+            auto i_class = find(doc.text_index_class_uris.begin(), doc.text_index_class_uris.end(), obj->type);
+            if (i_class == doc.text_index_class_uris.end())
+                i_class = doc.text_index_class_uris.insert(i_class, obj->type);
+            doc.text_index_classes.push_back((uint32_t)(i_class - doc.text_index_class_uris.begin()));
+        }
+    };
+
+    // An object that satisfies a search, with its relevance and its position among the matches before ranking
+    struct SearchHit
+    {
+        SBOLObject* obj;
+        float score;
+        size_t order;
+    };
+
+    // Object ids with their scores, sorted by id
+    typedef vector<pair<uint32_t, float>> ScoredIds;
+
+    // Find the objects with an indexed word that starts with a search token. A match scores the weight of the property it is in,
+    // halved if the token is only the start of the word, and scaled by how rare the token is
+    ScoredIds match_token(Document& doc, const TextCriterion& criterion)
+    {
+        ScoredIds matches;
+        size_t n_words = 0;
+        for (auto i_word = doc.text_index.lower_bound(criterion.token); i_word != doc.text_index.end() && i_word->first.compare(0, criterion.token.size(), criterion.token) == 0; ++i_word)
+        {
+            float completeness = i_word->first.size() == criterion.token.size() ? 1.0f : 0.5f;
+            for (auto & posting : i_word->second)
+                if ((criterion.field < 0 || posting.field == (uint32_t)criterion.field) && doc.text_index_objects[posting.object_id])
+                    matches.push_back({ posting.object_id, doc.text_properties[posting.field].second * completeness });
+            ++n_words;
+        }
+
+        // Postings are appended in order of object id, so the matches of a single word are already sorted
+        if (n_words > 1)
+            sort(matches.begin(), matches.end());
+        size_t n_unique = 0;
+        for (size_t i_match = 0; i_match < matches.size(); ++i_match)
+        {
+            if (n_unique && matches[n_unique - 1].first == matches[i_match].first)
+                matches[n_unique - 1].second = max(matches[n_unique - 1].second, matches[i_match].second);
+            else
+                matches[n_unique++] = matches[i_match];
+        }
+        matches.resize(n_unique);
+        float rarity = log(1.0f + (float)doc.text_index_ids.size() / max((size_t)1, matches.size()));
+        for (auto & match : matches)
+            match.second *= rarity;
+        return matches;
+    };
+
+    // Find the objects that match every search token, starting from the rarest token
+    ScoredIds match_text(Document& doc, vector<TextCriterion>& criteria)
+    {
+        vector<ScoredIds> token_matches;
+        for (auto & criterion : criteria)
+            token_matches.push_back(match_token(doc, criterion));
+        sort(token_matches.begin(), token_matches.end(), [](const ScoredIds& a, const ScoredIds& b) { return a.size() < b.size(); });
+        ScoredIds scores = move(token_matches.front());
+        for (size_t i_token = 1; i_token < token_matches.size() && scores.size(); ++i_token)
+        {
+            size_t n_kept = 0;
+            auto i_match = token_matches[i_token].begin();
+            for (auto & score : scores)
+            {
+                i_match = lower_bound(i_match, token_matches[i_token].end(), make_pair(score.first, -HUGE_VALF));
+                if (i_match == token_matches[i_token].end())
+                    break;
+                if (i_match->first == score.first)
+                    scores[n_kept++] = { score.first, score.second + i_match->second };
+            }
+            scores.resize(n_kept);
+        }
+        return scores;
+    };
+
+    // Find the objects of a type that satisfy all criteria, with their scores. Criteria on URI-valued properties in the inverted index
+    // are looked up there, and other exact criteria are checked against each candidate
+    vector<SearchHit> run_search(Document& doc, const string& object_type, vector<TextCriterion>& text_criteria, vector<pair<string, string>>& exact_criteria)
+    {
+        SBOL_STATS_TIMER("search");
+        vector<SearchHit> candidates;
+        if (text_criteria.size())
+        {
+            doc.index_text();
+            uint32_t object_class = (uint32_t)(find(doc.text_index_class_uris.begin(), doc.text_index_class_uris.end(), object_type) - doc.text_index_class_uris.begin());
+            for (auto & score : match_text(doc, text_criteria))
+                if (object_type == "" || doc.text_index_classes[score.first] == object_class)
+                    candidates.push_back({ doc.text_index_objects[score.first], score.second, candidates.size() });
+        }
+        else
+        {
+            TermQuery condition = TermQuery::ofType(object_type);
+            for (auto i_criterion = exact_criteria.begin(); i_criterion != exact_criteria.end(); )
+            {
+                const string& value = i_criterion->second;
+                if (value.front() == '<' && doc.indexed_properties.count(i_criterion->first))
+                {
+                    condition = condition & TermQuery(i_criterion->first, value.substr(1, value.length() - 2));
+                    i_criterion = exact_criteria.erase(i_criterion);
+                }
+                else
+                    ++i_criterion;
+            }
+            for (auto obj : doc.query(condition))
+                candidates.push_back({ obj, 0.0f, candidates.size() });
+        }
+
+        auto satisfies = [&](const SearchHit& candidate)
+        {
+            for (auto & criterion : exact_criteria)
+            {
+                auto i_property = candidate.obj->properties.find(criterion.first);
+                if (i_property == candidate.obj->properties.end() || find(i_property->second.begin(), i_property->second.end(), criterion.second) == i_property->second.end())
+                    return false;
+            }
+            return true;
+        };
+        candidates.erase(remove_if(candidates.begin(), candidates.end(), [&](const SearchHit& candidate) { return !satisfies(candidate); }), candidates.end());
+        return candidates;
+    };
+
+    SearchResponse& make_response(vector<SearchHit>& candidates, int offset, int limit)
+    {
+        SearchResponse& search_response = * new SearchResponse();
+        size_t begin = (size_t)max(offset, 0);
+        size_t end = min(candidates.size(), begin + (size_t)max(limit, 0));
+        if (begin >= end)
+            return search_response;
+
+        // Rank only as many records as are returned. Ties keep the order in which the objects were indexed, so paging through the records is stable
+        auto ranks_before = [](const SearchHit& a, const SearchHit& b)
+        {
+            if (a.score != b.score)
+                return a.score > b.score;
+            return a.order < b.order;
+        };
+        partial_sort(candidates.begin(), candidates.begin() + end, candidates.end(), ranks_before);
+        for (size_t i = begin; i < end; ++i)
+        {
+            SBOLObject& obj = *candidates[i].obj;
+            Identified* record = new Identified(SBOL_IDENTIFIED, "dummy", "0");
+            record->identity.set(stored_text(obj, SBOL_IDENTITY));
+            record->displayId.set(stored_text(obj, SBOL_DISPLAY_ID));
+            record->name.set(stored_text(obj, SBOL_NAME));
+            record->description.set(stored_text(obj, SBOL_DESCRIPTION));
+            record->version.set(stored_text(obj, SBOL_VERSION));
+            search_response.records.push_back(record);
+        }
+        return search_response;
+    };
+
+    // Translate a general search into search criteria
+    vector<TextCriterion> general_criteria(const string& search_text)
+    {
+        vector<string> tokens;
+        tokenize(search_text, tokens);
+        vector<TextCriterion> criteria;
+        for (auto & token : tokens)
+            criteria.push_back({ -1, token });
+        return criteria;
+    };
+
+    // Translate the criteria of a SearchQuery, as PartShop::search does. Values that start with http are URIs
+    string parse_search_query(Document& doc, SearchQuery& q, vector<TextCriterion>& text_criteria, vector<pair<string, string>>& exact_criteria)
+    {
+        if (q["objectType"].size() != 1)
+            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "SearchQuery is invalid because it does not have an objectType specified");
+        vector<string> search_criteria = q.getProperties();
+        for (string ignored : { SBOL_IDENTITY, SBOL_URI "#objectType", SBOL_URI "#offset", SBOL_URI "#limit" })
+            search_criteria.erase(std::remove(search_criteria.begin(), search_criteria.end(), ignored), search_criteria.end());
+        for (auto & property_uri : search_criteria)
+        {
+            // SearchQuery keys criteria by SBOL_URI "#" + key, so name and description criteria are matched against their Dublin Core terms
+            string target_uri = property_uri;
+            if (property_uri == SBOL_URI "#name")
+                target_uri = SBOL_NAME;
+            else if (property_uri == SBOL_URI "#description")
+                target_uri = SBOL_DESCRIPTION;
+            int field = -1;
+            for (size_t i_field = 0; i_field < doc.text_properties.size(); ++i_field)
+                if (doc.text_properties[i_field].first == target_uri)
+                    field = (int)i_field;
+            for (auto & property_val : q.getPropertyValues(property_uri))
+            {
+                if (property_val.length() == 0)
+                    continue;
+                if (property_val.find("http") == 0)
+                    exact_criteria.push_back({ target_uri, "<" + property_val + ">" });
+                else if (field < 0)
+                    exact_criteria.push_back({ target_uri, "\"" + property_val + "\"" });
+                else
+                {
+                    vector<string> tokens;
+                    tokenize(property_val, tokens);
+                    for (auto & token : tokens)
+                        text_criteria.push_back({ field, token });
+                }
+            }
+        }
+        return q.objectType.get();
+    };
+}
+
+void Document::unindex_text(SBOLObject& obj)
+{
+    remove_text_postings(*this, &obj);
+    text_index_dirty.erase(&obj);
+
+    // Rebuild the index on the next search once most of its postings belong to removed objects
+    if (text_index_objects.size() - text_index_ids.size() > text_index_ids.size())
+        text_index_valid = false;
+};
+
+void Document::index_text()
+{
+    if (text_index_valid && text_index_dirty.empty())
+        return;  // Nothing to update. Searches on a frozen Document only read the index
+    if (text_index_valid)
+    {
+        // Re-index only the objects that were edited or added since the last search
+        vector<SBOLObject*> stack;
+        for (auto & i_dirty : text_index_dirty)
+        {
+            stack.push_back(i_dirty.first);
+            while (stack.size())
+            {
+                SBOLObject* obj = stack.back();
+                stack.pop_back();
+                remove_text_postings(*this, obj);
+                add_text_postings(*this, obj);
+                if (i_dirty.second)
+                    for (auto & i_store : obj->owned_objects)
+                        stack.insert(stack.end(), i_store.second.begin(), i_store.second.end());
+            }
+        }
+        text_index_dirty.clear();
+
+        // Rebuild the index once most of its postings belong to objects that were re-indexed
+        if (text_index_objects.size() - text_index_ids.size() <= text_index_ids.size())
+            return;
+    }
+    SBOL_STATS_TIMER("index_text");
+    text_index.clear();
+    text_index_objects.clear();
+    text_index_ids.clear();
+    text_index_classes.clear();
+    text_index_class_uris.clear();
+    text_index_dirty.clear();
+    vector<SBOLObject*> stack;
+    for (auto & i_obj : SBOLObjects)
+        stack.push_back(i_obj.second);
+    while (stack.size())
+    {
+        SBOLObject* obj = stack.back();
+        stack.pop_back();
+        add_text_postings(*this, obj);
+        for (auto & i_store : obj->owned_objects)
+            stack.insert(stack.end(), i_store.second.begin(), i_store.second.end());
+    }
+    SBOL_STATS_COUNT("text_tokens", text_index.size());
+    text_index_valid = true;
+};
+
+void Document::indexText(std::string property_uri, float weight)
+{
+    for (auto & text_property : text_properties)
+    {
+        if (text_property.first == property_uri)
+        {
+            text_property.second = weight;
+            return;
+        }
+    }
+    text_properties.push_back({ property_uri, weight });
+    text_index_valid = false;
+};
+
+SearchResponse& Document::search(std::string search_text, std::string object_type, int offset, int limit)
+{
+    vector<TextCriterion> text_criteria = general_criteria(search_text);
+    vector<pair<string, string>> exact_criteria;
+    vector<SearchHit> candidates = run_search(*this, object_type, text_criteria, exact_criteria);
+    return make_response(candidates, offset, limit);
+};
+
+SearchResponse& Document::search(SearchQuery& q)
+{
+    vector<TextCriterion> text_criteria;
+    vector<pair<string, string>> exact_criteria;
+    string object_type = parse_search_query(*this, q, text_criteria, exact_criteria);
+    vector<SearchHit> candidates = run_search(*this, object_type, text_criteria, exact_criteria);
+    return make_response(candidates, q.offset.get(), q.limit.get());
+};
+
+int Document::searchCount(std::string search_text, std::string object_type)
+{
+    vector<TextCriterion> text_criteria = general_criteria(search_text);
+    vector<pair<string, string>> exact_criteria;
+    return (int)run_search(*this, object_type, text_criteria, exact_criteria).size();
+};
+
+int Document::searchCount(SearchQuery& q)
+{
+    vector<TextCriterion> text_criteria;
+    vector<pair<string, string>> exact_criteria;
+    string object_type = parse_search_query(*this, q, text_criteria, exact_criteria);
+    return (int)run_search(*this, object_type, text_criteria, exact_criteria).size();
+};
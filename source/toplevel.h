@@ -47,7 +47,7 @@ namespace sbol
             Identified(type_uri, uri, version),
             attachments(this, SBOL_ATTACHMENTS, SBOL_ATTACHMENT, '0', '*', ValidationRules({}))
         {
-            if  (Config::getOption("sbol_compliant_uris").compare("True") == 0)
+            if  (!DeserializationScope::active() && Config::getOption("sbol_compliant_uris").compare("True") == 0)
             {
                 displayId.set(uri);
                 if (Config::getOption("sbol_typed_uris").compare("True") == 0)
@@ -0,0 +1,296 @@
+/**
+ * @file    transaction.cpp
+ * @brief   Transactions that record changes to a Document so they can be rolled back
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+
+#include "document.h"
+
+using namespace sbol;
+using namespace std;
+
+namespace
+{
+    // While no Document has an open transaction, changes are not recorded
+    atomic<int> n_transaction_documents(0);
+
+    // The Document that records a change to the owner, or NULL if no transaction is open on it
+    Document* recording_document(SBOLObject* owner)
+    {
+        if (!owner || !n_transaction_documents.load(memory_order_relaxed))
+            return NULL;
+        Document* doc = owning_document(owner);
+        if (doc && doc->savepoints.size())
+            return doc;
+        return NULL;
+    };
+}
+
+Document* sbol::owning_document(SBOLObject* obj)
+{
+    for (; obj; obj = obj->parent)
+    {
+        if (obj->doc)
+            return obj->doc;
+        if (!obj->parent)
+            return dynamic_cast<Document*>(obj);
+    }
+    return NULL;
+};
+
+void sbol::record_values(SBOLObject* owner, const rdf_type& property_type)
+{
+    Document* doc = recording_document(owner);
+    if (!doc)
+        return;
+    // A BulkInsert scope only needs to undo registration and ownership, so values are not copied unless a transaction outside one is open
+    if (doc->savepoints.size() <= (size_t)doc->bulk_insert_depth)
+        return;
+    UndoEntry entry(UndoEntry::VALUES, owner, property_type);
+    auto i_values = owner->properties.find(property_type);
+    if (i_values != owner->properties.end())
+    {
+        entry.existed = true;
+        entry.values = i_values->second;
+    }
+    doc->undo_log.push_back(std::move(entry));
+};
+
+void sbol::record_object_added(SBOLObject* owner, const rdf_type& store, SBOLObject* obj)
+{
+    Document* doc = recording_document(owner);
+    if (!doc)
+        return;
+    UndoEntry entry(UndoEntry::OBJECT_ADDED, owner, store);
+    entry.obj = obj;
+    doc->undo_log.push_back(std::move(entry));
+};
+
+void sbol::record_object_removed(SBOLObject* owner, const rdf_type& store, size_t index)
+{
+    Document* doc = recording_document(owner);
+    if (!doc)
+        return;
+    UndoEntry entry(UndoEntry::OBJECT_REMOVED, owner, store);
+    entry.obj = owner->owned_objects[store].at(index);
+    entry.index = index;
+    doc->undo_log.push_back(std::move(entry));
+};
+
+void sbol::record_object_store(SBOLObject* owner, const rdf_type& store)
+{
+    Document* doc = recording_document(owner);
+    if (!doc)
+        return;
+    UndoEntry entry(UndoEntry::OBJECT_STORE, owner, store);
+    entry.objects = owner->owned_objects[store];
+    doc->undo_log.push_back(std::move(entry));
+};
+
+void sbol::record_links(SBOLObject* owner, SBOLObject* obj)
+{
+    Document* doc = recording_document(owner);
+    if (!doc)
+        return;
+    UndoEntry entry(UndoEntry::LINKS, obj);
+    entry.obj = obj->parent;
+    entry.doc = obj->doc;
+    doc->undo_log.push_back(std::move(entry));
+};
+
+void sbol::record_registration(SBOLObject* owner, const std::string& uri)
+{
+    Document* doc = recording_document(owner);
+    if (!doc)
+        return;
+    UndoEntry entry(UndoEntry::REGISTRATION, doc, uri);
+    auto i_obj = doc->SBOLObjects.find(uri);
+    if (i_obj != doc->SBOLObjects.end())
+    {
+        entry.existed = true;
+        entry.obj = i_obj->second;
+    }
+    doc->undo_log.push_back(std::move(entry));
+};
+
+void sbol::record_created(SBOLObject* owner, SBOLObject* obj)
+{
+    Document* doc = recording_document(owner);
+    if (doc)
+        doc->undo_log.push_back(UndoEntry(UndoEntry::CREATED, obj));
+};
+
+void sbol::release_object(SBOLObject* owner, SBOLObject* obj)
+{
+    Document* doc = recording_document(owner);
+    if (doc)
+        doc->undo_log.push_back(UndoEntry(UndoEntry::CLOSED, obj));
+    else
+        obj->close();
+};
+
+void Document::beginTransaction()
+{
+    check_mutable(this);
+    if (savepoints.empty())
+        ++n_transaction_documents;
+    savepoints.push_back(undo_log.size());
+};
+
+void Document::commit()
+{
+    if (savepoints.empty())
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot commit. No transaction is open");
+    savepoints.pop_back();
+    if (savepoints.size())
+        return;  // The changes are now part of the enclosing transaction
+
+    // Objects closed inside the transaction were kept in case it was rolled back
+    vector<UndoEntry> log;
+    log.swap(undo_log);
+    --n_transaction_documents;
+    for (auto & entry : log)
+        if (entry.kind == UndoEntry::CLOSED)
+            entry.owner->close();
+};
+
+void Document::rollback()
+{
+    if (savepoints.empty())
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot roll back. No transaction is open");
+    SBOL_STATS_TIMER("rollback");
+    size_t savepoint = savepoints.back();
+    SBOL_STATS_COUNT("changes_rolled_back", undo_log.size() - savepoint);
+    bool objects_removed = false;
+
+    // Undo the changes in the reverse of the order they were made, so each entry finds the state that followed its change
+    while (undo_log.size() > savepoint)
+    {
+        UndoEntry& entry = undo_log.back();
+        SBOLObject* owner = entry.owner;
+        switch (entry.kind)
+        {
+            case UndoEntry::VALUES:
+            {
+                // Observers are sent the restored value, as if it had been set
+                string value;
+                if (is_observed(owner) && entry.existed && entry.values.size() && entry.values.front().length() > 2)
+                    value = entry.values.front().substr(1, entry.values.front().length() - 2);
+                if (entry.existed)
+                    owner->properties[entry.key] = std::move(entry.values);
+                else
+                    owner->properties.erase(entry.key);
+                notify_property_change(owner, entry.key);
+                notify_change(SBOL_CHANGE_PROPERTY_SET, owner, entry.key, value);
+                break;
+            }
+            case UndoEntry::OBJECT_ADDED:
+            {
+                // The object was appended, so it is usually still the last one in its store
+                vector<SBOLObject*>& store = owner->owned_objects[entry.key];
+                auto i_obj = std::find(store.rbegin(), store.rend(), entry.obj);
+                if (i_obj != store.rend())
+                    store.erase(std::next(i_obj).base());
+                notify_property_change(owner, entry.key);
+                notify_change(SBOL_CHANGE_OBJECT_REMOVED, owner, entry.key, entry.obj);
+                objects_removed = true;
+                break;
+            }
+            case UndoEntry::OBJECT_REMOVED:
+            {
+                vector<SBOLObject*>& store = owner->owned_objects[entry.key];
+                store.insert(store.begin() + std::min(entry.index, store.size()), entry.obj);
+                notify_property_change(owner, entry.key);
+                notify_change(SBOL_CHANGE_OBJECT_ADDED, owner, entry.key, entry.obj);
+                objects_removed = true;
+                break;
+            }
+            case UndoEntry::OBJECT_STORE:
+                owner->owned_objects[entry.key] = std::move(entry.objects);
+                notify_property_change(owner, entry.key);
+                for (auto & obj : owner->owned_objects[entry.key])
+                    notify_change(SBOL_CHANGE_OBJECT_ADDED, owner, entry.key, obj);
+                objects_removed = true;
+                break;
+            case UndoEntry::LINKS:
+                owner->parent = entry.obj;
+                owner->doc = entry.doc;
+                break;
+            case UndoEntry::REGISTRATION:
+                if (entry.existed)
+                {
+                    SBOLObjects[entry.key] = entry.obj;
+                    notify_change(SBOL_CHANGE_TOPLEVEL_ADDED, this, "", entry.obj);
+                }
+                else
+                {
+                    auto i_obj = SBOLObjects.find(entry.key);
+                    if (i_obj != SBOLObjects.end())
+                    {
+                        SBOLObject* obj = i_obj->second;
+                        SBOLObjects.erase(i_obj);
+                        notify_change(SBOL_CHANGE_TOPLEVEL_CLOSED, this, "", obj);
+                    }
+                }
+                objects_removed = true;
+                break;
+            case UndoEntry::CREATED:
+                owner->close();  // Every store it was added to has been restored
+                break;
+            case UndoEntry::CLOSED:
+                break;  // The object was kept, and is back in the store it was removed from
+        }
+        undo_log.pop_back();
+    }
+    savepoints.pop_back();
+    if (savepoints.empty())
+        --n_transaction_documents;
+
+    // The indices are rebuilt on demand, as they are after objects are removed from the Document
+    if (objects_removed)
+        invalidate_indices();
+};
+
+int Document::getTransactionDepth()
+{
+    return (int)savepoints.size();
+};
+
+void Document::check_no_transaction(const std::string& operation)
+{
+    if (savepoints.size())
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot " + operation + " a Document while a transaction is open. Commit or roll back the transaction first");
+};
+
+void Document::release_transactions()
+{
+    if (savepoints.empty())
+        return;
+    // Objects still in the Document are deleted with it. Objects that were closed are not in it anymore
+    savepoints.clear();
+    --n_transaction_documents;
+    for (auto & entry : undo_log)
+        if (entry.kind == UndoEntry::CLOSED)
+            entry.owner->close();
+    undo_log.clear();
+};
@@ -0,0 +1,397 @@
+/**
+ * @file    triples.cpp
+ * @brief   Direct N-Triples and Turtle serialization of Documents
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+#include "document.h"
+
+#include <cstdio>
+#include <cstring>
+#include <functional>
+
+using namespace sbol;
+using namespace std;
+
+namespace
+{
+    const string RDF_TYPE = "http://www.w3.org/1999/02/22-rdf-syntax-ns#type";
+    const string IDENTITY = SBOL_IDENTITY;
+    const size_t FLUSH_SIZE = 1 << 20;
+
+    // The bytes that can be written as they are in URIs and in literals, looked up rather than tested one condition at a time.
+    // The first table of each pair is for UTF-8 output and the second for ASCII output
+    struct SafeBytes
+    {
+        bool uri[2][256];
+        bool literal[2][256];
+
+        SafeBytes()
+        {
+            for (int c = 0; c < 256; ++c)
+            {
+                bool printable = c > 0x20 && c < 0x7F;
+                uri[0][c] = (printable && !strchr("<>\"{}|^`\\", c)) || c >= 0x80;
+                uri[1][c] = printable && !strchr("<>\"{}|^`\\", c);
+                literal[0][c] = c != '"' && c != '\\' && c >= 0x20;
+                literal[1][c] = literal[0][c] && c < 0x7F;
+            }
+        };
+    };
+    const SafeBytes SAFE_BYTES;
+
+    // Appends escaped RDF terms to a buffer, and flushes the buffer to a file in large blocks if a file is given
+    class TripleWriter
+    {
+    public:
+        string& buffer;
+        FILE* fh;
+        size_t total = 0;
+        bool ascii;  // N-Triples output is pure ASCII, with other characters written as \u escapes, as raptor does. Turtle is written in UTF-8
+        const bool* uri_safe;
+        const bool* literal_safe;
+
+        TripleWriter(string& buffer, FILE* fh, bool ascii) :
+            buffer(buffer),
+            fh(fh),
+            ascii(ascii),
+            uri_safe(SAFE_BYTES.uri[ascii]),
+            literal_safe(SAFE_BYTES.literal[ascii])
+        {
+            if (fh)
+                buffer.reserve(FLUSH_SIZE + FLUSH_SIZE / 4);
+        };
+
+        void flush()
+        {
+            total += buffer.size();
+            if (fh)
+            {
+                if (buffer.size() && fwrite(buffer.data(), 1, buffer.size(), fh) != buffer.size())
+                    throw SBOLError(SBOL_ERROR_SERIALIZATION, "Serialization failed. Could not write to file");
+                buffer.clear();
+            }
+        };
+
+        void check_flush()
+        {
+            if (fh && buffer.size() >= FLUSH_SIZE)
+                flush();
+        };
+
+        void put(const char* text, size_t length)
+        {
+            buffer.append(text, length);
+        };
+
+        void put(const string& text)
+        {
+            buffer.append(text);
+        };
+
+        void put(char c)
+        {
+            buffer.push_back(c);
+        };
+
+        void put_code_point(uint32_t code_point)
+        {
+            char escape[11];
+            if (code_point > 0xFFFF)
+                snprintf(escape, sizeof(escape), "\\U%08X", code_point);
+            else
+                snprintf(escape, sizeof(escape), "\\u%04X", code_point);
+            buffer.append(escape);
+        };
+
+        // Decode one UTF-8 sequence starting at text[i]. Invalid bytes are returned on their own
+        uint32_t decode(const unsigned char* text, size_t length, size_t& i)
+        {
+            unsigned char c = text[i];
+            int n_continuation = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+            if (n_continuation == 0 || i + n_continuation >= length)
+                return c;
+            uint32_t code_point = c & (0x3F >> n_continuation);
+            for (int i_byte = 1; i_byte <= n_continuation; ++i_byte)
+            {
+                if ((text[i + i_byte] & 0xC0) != 0x80)
+                    return c;
+                code_point = (code_point << 6) | (text[i + i_byte] & 0x3F);
+            }
+            i += n_continuation;
+            return code_point;
+        };
+
+        void literal(const char* text, size_t length)
+        {
+            put('"');
+            size_t i_start = 0;
+            for (size_t i = 0; i < length; ++i)
+            {
+                unsigned char c = (unsigned char)text[i];
+                if (literal_safe[c])
+                    continue;
+                put(text + i_start, i - i_start);
+                if (c == '"')
+                    put("\\\"", 2);
+                else if (c == '\\')
+                    put("\\\\", 2);
+                else if (c == '\n')
+                    put("\\n", 2);
+                else if (c == '\r')
+                    put("\\r", 2);
+                else if (c == '\t')
+                    put("\\t", 2);
+                else
+                    put_code_point(decode((const unsigned char*)text, length, i));
+                i_start = i + 1;
+            }
+            put(text + i_start, length - i_start);
+            put('"');
+        };
+
+        void uri(const char* text, size_t length)
+        {
+            put('<');
+            size_t i_start = 0;
+            for (size_t i = 0; i < length; ++i)
+            {
+                unsigned char c = (unsigned char)text[i];
+                if (uri_safe[c])
+                    continue;
+                put(text + i_start, i - i_start);
+                put_code_point(decode((const unsigned char*)text, length, i));
+                i_start = i + 1;
+            }
+            put(text + i_start, length - i_start);
+            put('>');
+        };
+
+        // Write a URI stored in libSBOL's convention, ie, flanked by angle brackets
+        void stored_uri(const string& value)
+        {
+            uri(value.data() + 1, value.size() - 2);
+        };
+    };
+
+    // The identity of an object as stored, ie, flanked by angle brackets. An object without one cannot be written
+    const string& stored_identity(SBOLObject& obj)
+    {
+        auto i_identity = obj.properties.find(IDENTITY);
+        if (i_identity == obj.properties.end() || i_identity->second.empty() || i_identity->second.front().length() <= 2)
+            throw SBOLError(SBOL_ERROR_SERIALIZATION, "Serialization failed. An object of type " + obj.type + " has no identity");
+        return i_identity->second.front();
+    };
+
+    bool is_local_name(const string& name)
+    {
+        if (name.empty() || !(isalpha((unsigned char)name[0]) || name[0] == '_'))
+            return false;
+        for (auto c : name)
+            if (!(isalnum((unsigned char)c) || c == '_' || c == '-'))
+                return false;
+        return true;
+    };
+}
+
+namespace sbol
+{
+    // Writes objects as N-Triples or Turtle. In Turtle, predicates and types are abbreviated with the Document's prefixes where the local name allows it
+    class TripleSerializer
+    {
+    public:
+        bool turtle;
+        map<string, string> prefixes;
+        unordered_map<string, string> abbreviations;
+
+        TripleSerializer(const string& format, const unordered_map<string, string>& namespaces) :
+            turtle(format == "turtle"),
+            prefixes(namespaces.begin(), namespaces.end())
+        {
+        };
+
+        void term(TripleWriter& out, const string& uri)
+        {
+            if (!turtle)
+            {
+                out.uri(uri.data(), uri.size());
+                return;
+            }
+            auto i_abbreviation = abbreviations.find(uri);
+            if (i_abbreviation == abbreviations.end())
+            {
+                string abbreviation;
+                for (auto & i_prefix : prefixes)
+                {
+                    const string& ns = i_prefix.second;
+                    if (ns.size() && uri.size() > ns.size() && uri.compare(0, ns.size(), ns) == 0 && is_local_name(uri.substr(ns.size())))
+                    {
+                        abbreviation = i_prefix.first + ":" + uri.substr(ns.size());
+                        break;
+                    }
+                }
+                if (abbreviation.empty())
+                    TripleWriter(abbreviation, NULL, false).uri(uri.data(), uri.size());
+                i_abbreviation = abbreviations.emplace(uri, abbreviation).first;
+            }
+            out.put(i_abbreviation->second);
+        };
+
+        void write_prefixes(TripleWriter& out)
+        {
+            if (!turtle)
+                return;
+            for (auto & i_prefix : prefixes)
+            {
+                out.put("@prefix ", 8);
+                out.put(i_prefix.first);
+                out.put(": ", 2);
+                out.uri(i_prefix.second.data(), i_prefix.second.size());
+                out.put(" .\n", 3);
+            }
+            out.put('\n');
+        };
+
+        // Triples of an object are written in the same order as SBOLObject::serialize and, in Turtle, grouped under one subject.
+        // Owned objects are written before their parent, because the parser only assigns properties to an owned object
+        // while it is still unclaimed by its parent
+        void write_object(TripleWriter& out, SBOLObject& obj)
+        {
+            for (auto & i_store : obj.owned_objects)
+                if (std::find(obj.hidden_properties.begin(), obj.hidden_properties.end(), i_store.first) == obj.hidden_properties.end())
+                    for (auto & child : i_store.second)
+                        write_object(out, *child);
+
+            // The subject is escaped once, rather than for each of its triples
+            string subject;
+            TripleWriter(subject, NULL, out.ascii).stored_uri(stored_identity(obj));
+            subject.push_back(turtle ? '\n' : ' ');
+            bool first_triple = true;
+            auto begin_triple = [&](const string& predicate)
+            {
+                if (turtle)
+                {
+                    if (first_triple)
+                    {
+                        out.put(subject);
+                        out.put("    ", 4);
+                    }
+                    else
+                        out.put(" ;\n    ", 7);
+                    if (predicate == RDF_TYPE)
+                        out.put('a');
+                    else
+                        term(out, predicate);
+                }
+                else
+                {
+                    out.put(subject);
+                    term(out, predicate);
+                }
+                out.put(' ');
+                first_triple = false;
+            };
+            auto end_triple = [&]()
+            {
+                if (!turtle)
+                    out.put(" .\n", 3);
+            };
+
+            begin_triple(RDF_TYPE);
+            term(out, obj.type);
+            end_triple();
+
+            for (auto & i_property : obj.properties)
+            {
+                const string& predicate = i_property.first;
+                if (std::find(obj.hidden_properties.begin(), obj.hidden_properties.end(), predicate) != obj.hidden_properties.end())
+                    continue;
+                for (auto & value : i_property.second)
+                {
+                    if (value.length() <= 2)
+                        continue;  // Unset property
+                    if (value.front() == '<' && value.back() == '>')
+                    {
+                        if (predicate == IDENTITY)
+                            continue;
+                        begin_triple(predicate);
+                        out.stored_uri(value);
+                        end_triple();
+                    }
+                    else if (value.front() == '"' && value.back() == '"')
+                    {
+                        begin_triple(predicate);
+                        out.literal(value.data() + 1, value.size() - 2);
+                        end_triple();
+                    }
+                }
+            }
+
+            for (auto & i_store : obj.owned_objects)
+            {
+                if (std::find(obj.hidden_properties.begin(), obj.hidden_properties.end(), i_store.first) != obj.hidden_properties.end())
+                    continue;
+                for (auto & child : i_store.second)
+                {
+                    begin_triple(i_store.first);
+                    out.stored_uri(stored_identity(*child));
+                    end_triple();
+                }
+            }
+            if (turtle)
+                out.put(" .\n\n", 4);
+            out.check_flush();
+        };
+    };
+}
+
+size_t Document::serialize_triples(std::string format, std::string& buffer, FILE* fh)
+{
+    SBOL_STATS_TIMER("serialize");
+    TripleWriter out(buffer, fh, format != "turtle");
+
+    // Propagate extension namespaces up to the Document, as SBOLObject::serialize does
+    for (auto & i_obj : SBOLObjects)
+        collect_namespaces(*i_obj.second);
+
+    TripleSerializer serializer(format, namespaces);
+    serializer.write_prefixes(out);
+    for (auto & i_obj : SBOLObjects)
+        serializer.write_object(out, *i_obj.second);
+    out.flush();
+    return out.total;
+};
+
+void Document::serialize_triples_fragments(std::string format, const std::vector<SBOLObject*>& objects, std::vector<std::string>& fragments, std::string& header)
+{
+    TripleSerializer serializer(format, namespaces);
+    header.clear();
+    TripleWriter header_out(header, NULL, format != "turtle");
+    serializer.write_prefixes(header_out);
+    fragments.clear();
+    fragments.resize(objects.size());
+    for (size_t i_obj = 0; i_obj < objects.size(); ++i_obj)
+    {
+        TripleWriter out(fragments[i_obj], NULL, format != "turtle");
+        serializer.write_object(out, *objects[i_obj]);
+    }
+};
@@ -167,6 +167,7 @@ void sbol::libsbol_rule_3(void *sbol_obj, void *arg)
         
     
     // Update Reference property to match the OwnedObject property (only the Reference will be serialized)
+    record_values(&design, "http://sys-bio.org#_structure");
     design.properties["http://sys-bio.org#_structure"][0] = "<" + structure.identity.get() + ">";
     
     if (design.function.size() > 0)
@@ -199,6 +200,7 @@ void sbol::libsbol_rule_4(void *sbol_obj, void *arg)
     else if (design.doc != fx.doc)
         throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot use " + fx.identity.get() + " for this Design. The objects must belong to the same Document");
     
+    record_values(&design, "http://sys-bio.org#_function");
     design.properties["http://sys-bio.org#_function"][0] = "<" + fx.identity.get() + ">";
     if (design.structure.size() > 0)
     {
@@ -233,6 +235,7 @@ void sbol::libsbol_rule_5(void *sbol_obj, void *arg)
         
     
     // Update Reference property to match the OwnedObject property (only the Reference will be serialized)
+    record_values(&build, "http://sys-bio.org#_structure");
     build.properties["http://sys-bio.org#_structure"][0] = "<" + structure.identity.get() + ">";
     
     if (build.behavior.size() > 0)
@@ -265,6 +268,7 @@ void sbol::libsbol_rule_6(void *sbol_obj, void *arg)
     else if (build.doc != fx.doc)
         throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot use " + fx.identity.get() + " for this Design. The objects must belong to the same Document");
     
+    record_values(&build, SBOL_URI "#built");
     build.properties[SBOL_URI "#built"][0] = "<" + fx.identity.get() + ">";
     if (build.structure.size() > 0)
     {
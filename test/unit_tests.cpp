@@ -0,0 +1,979 @@
+#define RAPTOR_STATIC
+
+#include "sbol.h"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+using namespace std;
+using namespace sbol;
+
+// Unit tests of the C++ API. Each test returns the number of checks that failed
+#define CHECK(condition) do { if (!(condition)) { cout << "  check failed at line " << __LINE__ << ": " #condition << endl; ++failures; } } while (0)
+
+void setup()
+{
+    setHomespace("http://examples.org");
+    Config::setOption("sbol_compliant_uris", true);
+    Config::setOption("sbol_typed_uris", true);
+    Config::setOption("validate", false);
+}
+
+int testBulkInsertRollback()
+{
+    int failures = 0;
+    Document doc;
+    ComponentDefinition& existing = doc.componentDefinitions.create("cd0");
+    existing.name.set("existing");
+    string before = doc.writeString();
+
+    bool threw = false;
+    {
+        BulkInsert bulk_insert(doc);
+        doc.componentDefinitions.create("cd1");
+        doc.componentDefinitions.create("cd2");
+        doc.add<ComponentDefinition>(*new ComponentDefinition("cd0"));  // Overwrites the registered cd0 until the scope is committed
+        try
+        {
+            bulk_insert.commit();
+        }
+        catch (SBOLError& e)
+        {
+            threw = e.error_code() == DUPLICATE_URI_ERROR;
+        }
+    }
+    CHECK(threw);
+    // The Document is left as it was before the scope was opened
+    CHECK(doc.componentDefinitions.size() == 1);
+    CHECK(doc.find(existing.identity.get()) == &existing);
+    CHECK(doc.getTransactionDepth() == 0);
+    CHECK(doc.writeString() == before);
+
+    // A scope that succeeds keeps its objects
+    {
+        BulkInsert bulk_insert(doc);
+        doc.componentDefinitions.create("cd1");
+        bulk_insert.commit();
+    }
+    CHECK(doc.componentDefinitions.size() == 2);
+    CHECK(doc.getTransactionDepth() == 0);
+
+    // A scope left by an exception is rolled back, not committed. It logs the new objects but not their property values
+    try
+    {
+        BulkInsert bulk_insert(doc);
+        size_t log_size = doc.undo_log.size();
+        doc.componentDefinitions.create("cd2").name.set("unwound");
+        CHECK(doc.undo_log.size() - log_size == 3);  // Creation, ownership and registration
+        throw std::runtime_error("unwind");
+    }
+    catch (std::runtime_error&)
+    {
+    }
+    CHECK(doc.componentDefinitions.size() == 2);
+    CHECK(doc.getTransactionDepth() == 0);
+
+    // Transactions closed inside the scope do not unbalance it
+    {
+        BulkInsert bulk_insert(doc);
+        doc.rollback();
+    }
+    CHECK(doc.getTransactionDepth() == 0);
+    {
+        BulkInsert bulk_insert(doc);
+        doc.beginTransaction();
+        doc.componentDefinitions.create("cd2");
+        bulk_insert.commit();
+    }
+    CHECK(doc.componentDefinitions.size() == 3);
+    CHECK(doc.getTransactionDepth() == 0);
+    return failures;
+}
+
+int testStatsCounters()
+{
+    int failures = 0;
+    Stats::reset();
+    Document doc;
+    doc.componentDefinitions.create("cd0");
+    CHECK(Stats::getCount("objects_created") == 0);  // Nothing is counted while collection is off
+
+    Stats::enable();
+    for (int i = 1; i <= 3; ++i)
+        doc.componentDefinitions.create("cd" + to_string(i));
+    CHECK(Stats::getCount("objects_created") == 3);
+    vector<string> counters = Stats::getCounters();
+    CHECK(find(counters.begin(), counters.end(), "objects_created") != counters.end());
+
+    Stats::reset();
+    CHECK(Stats::getCount("objects_created") == 0);
+    CHECK(Stats::getCounters().empty());
+    doc.componentDefinitions.create("cd4");
+    CHECK(Stats::getCount("objects_created") == 1);
+    Stats::disable();
+    Stats::reset();
+    return failures;
+}
+
+int testVariableComponentRegistered()
+{
+    int failures = 0;
+    Document doc;
+    ComponentDefinition& template_cd = doc.componentDefinitions.create("template");
+    CombinatorialDerivation& derivation = doc.combinatorialderivations.create("derivation");
+    derivation.masterTemplate.set(template_cd.identity.get());
+    VariableComponent& variable = derivation.variableComponents.create("variable");
+    variable.variants.add(template_cd.identity.get());
+
+    // Objects read from SBOL and copies are constructed from the register
+    string sbol = doc.writeString();
+    Document read_doc;
+    read_doc.readString(sbol);
+    CombinatorialDerivation& read_derivation = read_doc.get<CombinatorialDerivation>(derivation.identity.get());
+    CHECK(read_derivation.owned_objects[SBOL_VARIABLE_COMPONENTS].size() == 1);
+    CHECK(dynamic_cast<VariableComponent*>(read_derivation.owned_objects[SBOL_VARIABLE_COMPONENTS].front()) != NULL);
+    Document copy_doc;
+    doc.copy("", &copy_doc);
+    CombinatorialDerivation& copied_derivation = copy_doc.get<CombinatorialDerivation>(derivation.identity.get());
+    CHECK(copied_derivation.variableComponents.size() == 1);
+    CHECK(dynamic_cast<VariableComponent*>(copied_derivation.owned_objects[SBOL_VARIABLE_COMPONENTS].front()) != NULL);
+    return failures;
+}
+
+int testFindPropertyValue()
+{
+    int failures = 0;
+    Document doc;
+    ComponentDefinition& cd = doc.componentDefinitions.create("cd");
+    Component& c = cd.components.create("c");
+    SequenceAnnotation& sa = cd.sequenceAnnotations.create("sa");
+    sa.component.set(c.identity.get());
+
+    // Only the SequenceAnnotation has the property. The ComponentDefinition and the Component that contain it are skipped
+    vector<SBOLObject*> matches = cd.find_property_value(SBOL_COMPONENT_PROPERTY, c.identity.get());
+    CHECK(matches.size() == 1 && matches[0] == &sa);
+    CHECK(cd.find_property_value(SBOL_COMPONENT_PROPERTY, "http://examples.org/missing").empty());
+    CHECK(doc.find_property_value(SBOL_IDENTITY, sa.identity.get()).size() == 1);
+    return failures;
+}
+
+int testCompileNested()
+{
+    int failures = 0;
+    Document doc;
+    // Two levels of composites over four leaf parts
+    vector<string> elements = { "aaa", "cc", "g", "tt" };
+    vector<ComponentDefinition*> leaves;
+    for (size_t i_part = 0; i_part < elements.size(); ++i_part)
+    {
+        ComponentDefinition& cd = doc.componentDefinitions.create("part" + to_string(i_part));
+        Sequence& seq = doc.sequences.create("part" + to_string(i_part) + "_seq");
+        seq.elements.set(elements[i_part]);
+        cd.sequences.set(seq.identity.get());
+        leaves.push_back(&cd);
+    }
+    vector<ComponentDefinition*> composites;
+    for (int i_composite = 0; i_composite < 2; ++i_composite)
+    {
+        ComponentDefinition& cd = doc.componentDefinitions.create("composite" + to_string(i_composite));
+        Sequence& seq = doc.sequences.create("composite" + to_string(i_composite) + "_seq");
+        cd.sequences.set(seq.identity.get());
+        vector<ComponentDefinition*> subcomponents = { leaves[2 * i_composite], leaves[2 * i_composite + 1] };
+        cd.assemblePrimaryStructure(subcomponents);
+        composites.push_back(&cd);
+    }
+    ComponentDefinition& root = doc.componentDefinitions.create("root");
+    Sequence& root_seq = doc.sequences.create("root_seq");
+    root.sequences.set(root_seq.identity.get());
+    root.assemblePrimaryStructure(composites);
+
+    CHECK(root_seq.compile() == "aaaccgtt");
+    // Each composite holds only its own sequence, not the prefix of its parent
+    CHECK(doc.get<Sequence>(composites[0]->sequences.get()).elements.get() == "aaacc");
+    CHECK(doc.get<Sequence>(composites[1]->sequences.get()).elements.get() == "gtt");
+    return failures;
+}
+
+// Terms which verifyTarget uses as the roles of QC annotations
+const string QC_MATCH_ROLE = "http://purl.obolibrary.org/obo/SO_0000347";
+const string QC_SUBSTITUTION_ROLE = "http://purl.obolibrary.org/obo/SO_1000002";
+const string QC_DELETION_ROLE = "http://purl.obolibrary.org/obo/SO_0000159";
+const string QC_INSERTION_ROLE = "http://purl.obolibrary.org/obo/SO_0000667";
+const string QC_AMBIGUOUS_ROLE = "http://purl.obolibrary.org/obo/SO_0000702";
+
+bool near(float actual, float expected)
+{
+    return fabs(actual - expected) < 1e-6;
+}
+
+// Link a target design to a new Analysis through a Design, Build and Test. The target design is added to the Document as the structure of the Design
+Analysis& create_workflow(Document& doc, ComponentDefinition& target, string id)
+{
+    ModuleDefinition& function = *new ModuleDefinition(id + "_function");
+    Design& design = doc.designs.create(id + "_design");
+    design.structure.set(target);
+    design.function.set(function);
+    Build& build = design.generate<Build>(id + "_build");
+    Test& test = build.generate<Test>(id + "_test");
+    return test.generate<Analysis>(id + "_analysis");
+}
+
+// Annotate a ComponentDefinition with one Range, optionally locating a subcomponent
+SequenceAnnotation& annotate(ComponentDefinition& cd, string id, int start, int end, string role, Component* c = NULL)
+{
+    SequenceAnnotation& sa = cd.sequenceAnnotations.create(id);
+    Range& r = sa.locations.create<Range>(id + "_range");
+    r.start.set(start);
+    r.end.set(end);
+    if (role.size())
+        sa.roles.set(role);
+    if (c)
+        sa.component.set(c->identity.get());
+    return sa;
+}
+
+int testReportQC()
+{
+    int failures = 0;
+    Document doc;
+    ComponentDefinition& target = *new ComponentDefinition("target");
+    Analysis& analysis = create_workflow(doc, target, "qc");
+    Sequence& target_seq = doc.sequences.create("target_seq");
+    target_seq.elements.set("acgtacgtacgtacgtacgt");
+    target.sequence.set(target_seq.identity.get());
+
+    // sub2 overlaps sub1, and sub3 is adjacent to sub2
+    vector< pair<int, int> > subregions = { { 1, 10 }, { 8, 14 }, { 15, 20 } };
+    vector<ComponentDefinition*> subcomponents;
+    for (size_t i = 0; i < subregions.size(); ++i)
+    {
+        string id = "sub" + to_string(i + 1);
+        ComponentDefinition& sub = doc.componentDefinitions.create(id);
+        Component& c = target.components.create(id + "_instance");
+        c.definition.set(sub.identity.get());
+        annotate(target, id + "_annotation", subregions[i].first, subregions[i].second, "", &c);
+        subcomponents.push_back(&sub);
+    }
+
+    Build& build = doc.get<Build>(doc.get<Test>(analysis.rawData.get()).samples.get());
+    ComponentDefinition& construct = build.structure.create("construct");
+    annotate(construct, "qc0", 1, 5, QC_MATCH_ROLE);
+    annotate(construct, "qc1", 6, 6, QC_SUBSTITUTION_ROLE);
+    annotate(construct, "qc2", 7, 12, QC_MATCH_ROLE);
+    annotate(construct, "qc3", 12, 13, QC_INSERTION_ROLE);
+    annotate(construct, "qc4", 13, 14, QC_DELETION_ROLE);
+    annotate(construct, "qc5", 15, 16, QC_AMBIGUOUS_ROLE);
+    annotate(construct, "qc6", 17, 20, QC_MATCH_ROLE);
+
+    unordered_map<string, QCStatistics> report = analysis.reportQC();
+    CHECK(report.size() == 4);
+
+    // Expected values are counted by hand from the overlap of each region with each QC annotation
+    QCStatistics& sub1 = report[subcomponents[0]->identity.get()];
+    CHECK(sub1.start == 1 && sub1.end == 10);
+    CHECK(near(sub1.identity, 9.0f / 10.0f));
+    CHECK(near(sub1.error, 1.0f / 10.0f));
+    CHECK(near(sub1.ambiguity, 0.0f));
+    CHECK(near(sub1.coverage, 1.0f));
+
+    QCStatistics& sub2 = report[subcomponents[1]->identity.get()];
+    CHECK(sub2.start == 8 && sub2.end == 14);
+    CHECK(near(sub2.identity, 5.0f / 7.0f));
+    CHECK(near(sub2.error, 4.0f / 9.0f));  // Two deleted and two inserted bases. The inserted bases lengthen the region
+    CHECK(near(sub2.ambiguity, 0.0f));
+    CHECK(near(sub2.coverage, 5.0f / 7.0f + 4.0f / 9.0f));
+
+    QCStatistics& sub3 = report[subcomponents[2]->identity.get()];
+    CHECK(sub3.start == 15 && sub3.end == 20);
+    CHECK(near(sub3.identity, 4.0f / 6.0f));
+    CHECK(near(sub3.error, 0.0f));  // The deletion ends where the adjacent region starts
+    CHECK(near(sub3.ambiguity, 2.0f / 6.0f));
+    CHECK(near(sub3.coverage, 1.0f));
+
+    QCStatistics& whole = report[target.identity.get()];
+    CHECK(whole.start == 1 && whole.end == 20);
+    CHECK(near(whole.identity, 15.0f / 20.0f));
+    CHECK(near(whole.error, 5.0f / 22.0f));
+    CHECK(near(whole.ambiguity, 2.0f / 20.0f));
+    CHECK(near(whole.coverage, 15.0f / 20.0f + 5.0f / 22.0f + 2.0f / 20.0f));
+
+    // The per-statistic reports project the combined report
+    auto identity = analysis.reportIdentity();
+    CHECK(near(get<2>(identity[subcomponents[1]->identity.get()]), sub2.identity));
+    auto error = analysis.reportError();
+    CHECK(near(get<2>(error[target.identity.get()]), whole.error));
+    auto ambiguity = analysis.reportAmbiguity();
+    CHECK(near(get<2>(ambiguity[subcomponents[2]->identity.get()]), sub3.ambiguity));
+    auto coverage = analysis.reportCoverage();
+    CHECK(get<0>(coverage[subcomponents[0]->identity.get()]) == 1 && get<1>(coverage[subcomponents[0]->identity.get()]) == 10);
+    CHECK(near(get<2>(coverage[subcomponents[0]->identity.get()]), sub1.coverage));
+    return failures;
+}
+
+// List the QC annotations of a construct as displayId, role, start and end
+vector<string> list_qc_annotations(ComponentDefinition& construct)
+{
+    vector<string> rows;
+    for (auto & sa : construct.sequenceAnnotations)
+    {
+        Range& r = (Range&)sa.locations[0];
+        rows.push_back(sa.displayId.get() + " " + sa.roles.get() + " " + to_string(r.start.get()) + " " + to_string(r.end.get()));
+    }
+    sort(rows.begin(), rows.end());
+    return rows;
+}
+
+int testQCAnnotations()
+{
+    int failures = 0;
+    Document doc;
+    ComponentDefinition& target = *new ComponentDefinition("target");
+    Analysis& analysis = create_workflow(doc, target, "qc");
+    Sequence& target_seq = doc.sequences.create("target_seq");
+    target_seq.elements.set("acgtac--gtacgtacgtac");
+    target.sequence.set(target_seq.identity.get());
+
+    // The consensus is uncovered at either end, and has a substitution, an insertion, a deletion and an ambiguous base
+    analysis.verifyTarget(*new Sequence("consensus", "-cgaacttgt--gtncgta-"));
+    Build& build = doc.get<Build>(doc.get<Test>(analysis.rawData.get()).samples.get());
+    ComponentDefinition& construct = build.structure.get();
+
+    // The annotations are the same as the per-base scan that preceded the alignment scanner produced for this alignment
+    vector<string> expected = {
+        "qc0 " + QC_MATCH_ROLE + " 2 3",
+        "qc1 " + QC_SUBSTITUTION_ROLE + " 4 4",
+        "qc2 " + QC_MATCH_ROLE + " 5 6",
+        "qc3 " + QC_INSERTION_ROLE + " 6 6",
+        "qc4 " + QC_MATCH_ROLE + " 7 8",
+        "qc5 " + QC_DELETION_ROLE + " 9 10",
+        "qc6 " + QC_MATCH_ROLE + " 11 12",
+        "qc7 " + QC_AMBIGUOUS_ROLE + " 13 13",
+        "qc8 " + QC_MATCH_ROLE + " 14 17",
+    };
+    CHECK(list_qc_annotations(construct) == expected);
+
+    // A second Analysis of the same Build would annotate it with the same URIs. It fails without adding any annotations
+    Analysis& second_analysis = doc.get<Test>(analysis.rawData.get()).generate<Analysis>("qc_second_analysis");
+    bool threw = false;
+    try
+    {
+        second_analysis.verifyTarget(*new Sequence("second_consensus", "acgtac--gtacgtacgtac"));
+    }
+    catch (SBOLError& e)
+    {
+        threw = e.error_code() == DUPLICATE_URI_ERROR;
+    }
+    CHECK(threw);
+    CHECK(list_qc_annotations(construct) == expected);
+    CHECK(doc.getTransactionDepth() == 0);
+    return failures;
+}
+
+// Add a workflow whose target design has two annotated subcomponents. Returns the Analysis and a consensus Sequence for it
+pair<Analysis*, Sequence*> create_verification(Document& doc, int i)
+{
+    string id = "w" + to_string(i);
+    ComponentDefinition& target = *new ComponentDefinition(id + "_target");
+    Analysis& analysis = create_workflow(doc, target, id);
+    string target_elements = "acgtacgtacgtacgtacgtacgt";
+    Sequence& target_seq = doc.sequences.create(id + "_target_seq");
+    target_seq.elements.set(target_elements);
+    target.sequence.set(target_seq.identity.get());
+    for (int i_sub = 0; i_sub < 2; ++i_sub)
+    {
+        ComponentDefinition& sub = doc.componentDefinitions.create(id + "_sub" + to_string(i_sub));
+        Component& c = target.components.create(sub.displayId.get() + "_instance");
+        c.definition.set(sub.identity.get());
+        annotate(target, sub.displayId.get() + "_annotation", 1 + 12 * i_sub, 12 + 12 * i_sub, "", &c);
+    }
+
+    // Each consensus differs from the target at different positions
+    string consensus = target_elements;
+    consensus[(3 * i) % 24] = 'n';
+    consensus[(5 * i + 7) % 24] = '-';
+    consensus[(7 * i + 2) % 24] = (consensus[(7 * i + 2) % 24] == 'a') ? 'c' : 'a';
+    return { &analysis, new Sequence(id + "_consensus", consensus) };
+}
+
+bool same_report(unordered_map<string, QCStatistics>& a, unordered_map<string, QCStatistics>& b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (auto & i_region : a)
+    {
+        if (!b.count(i_region.first))
+            return false;
+        QCStatistics& x = i_region.second;
+        QCStatistics& y = b[i_region.first];
+        if (x.start != y.start || x.end != y.end || x.identity != y.identity || x.error != y.error || x.ambiguity != y.ambiguity || x.coverage != y.coverage)
+            return false;
+    }
+    return true;
+}
+
+int testVerifyTargets()
+{
+    int failures = 0;
+    const int n_verifications = 8;
+
+    // The Analyses of the batch alternate between two Documents. Sequential verification is repeated on a copy of each
+    Document sequential_docs[2];
+    Document parallel_docs[2];
+    vector<Analysis*> analyses;
+    vector<Sequence*> consensus_sequences;
+    vector< unordered_map<string, QCStatistics> > expected_reports;
+    for (int i = 0; i < n_verifications; ++i)
+    {
+        pair<Analysis*, Sequence*> sequential = create_verification(sequential_docs[i % 2], i);
+        sequential.first->verifyTarget(*sequential.second);
+        expected_reports.push_back(sequential.first->reportQC());
+
+        pair<Analysis*, Sequence*> parallel = create_verification(parallel_docs[i % 2], i);
+        analyses.push_back(parallel.first);
+        consensus_sequences.push_back(parallel.second);
+    }
+
+    vector< unordered_map<string, QCStatistics> > reports = Analysis::verifyTargets(analyses, consensus_sequences, 4);
+    CHECK(reports.size() == n_verifications);
+    for (int i = 0; i < n_verifications && i < (int)reports.size(); ++i)
+    {
+        CHECK(same_report(reports[i], expected_reports[i]));
+        unordered_map<string, QCStatistics> report = analyses[i]->reportQC();
+        CHECK(same_report(report, expected_reports[i]));
+    }
+    for (int i_doc = 0; i_doc < 2; ++i_doc)
+    {
+        CHECK(parallel_docs[i_doc].writeString() == sequential_docs[i_doc].writeString());
+        CHECK(parallel_docs[i_doc].getTransactionDepth() == 0);
+    }
+
+    // A batch that fails in one Document leaves the others unchanged too
+    Document failed_docs[2];
+    vector<Analysis*> failed_analyses;
+    vector<Sequence*> failed_sequences;
+    for (int i = 0; i < 2; ++i)
+    {
+        pair<Analysis*, Sequence*> verification = create_verification(failed_docs[i], i);
+        failed_analyses.push_back(verification.first);
+        failed_sequences.push_back(verification.second);
+    }
+    // The second Build already has a QC annotation with the URI that verification would give its first annotation
+    Build& annotated_build = failed_docs[1].get<Build>(failed_docs[1].get<Test>(failed_analyses[1]->rawData.get()).samples.get());
+    ComponentDefinition& annotated_construct = annotated_build.structure.create("w1_build");
+    annotate(annotated_construct, "qc0", 1, 24, QC_MATCH_ROLE);
+    string before[2] = { failed_docs[0].writeString(), failed_docs[1].writeString() };
+    bool threw = false;
+    try
+    {
+        Analysis::verifyTargets(failed_analyses, failed_sequences, 2);
+    }
+    catch (SBOLError& e)
+    {
+        threw = e.error_code() == DUPLICATE_URI_ERROR;
+    }
+    CHECK(threw);
+    for (int i_doc = 0; i_doc < 2; ++i_doc)
+    {
+        CHECK(failed_docs[i_doc].writeString() == before[i_doc]);
+        CHECK(failed_docs[i_doc].getTransactionDepth() == 0);
+    }
+    CHECK(Analysis::verifyTargets({}, {}).empty());
+    return failures;
+}
+
+int testRemoveKeepsIndices()
+{
+    int failures = 0;
+    Document doc;
+    vector<ComponentDefinition*> cds;
+    for (int i = 0; i < 4; ++i)
+    {
+        ComponentDefinition& cd = doc.componentDefinitions.create("gene" + to_string(i));
+        cd.components.create("part" + to_string(i));
+        cd.roles.set(SO_PROMOTER);
+        cds.push_back(&cd);
+    }
+    CHECK(doc.query(TermQuery::ofType(SBOL_COMPONENT)).size() == 4);
+    CHECK(doc.searchCount("gene") == 4);
+
+    // Removing objects withdraws them from the indices, which are not rebuilt
+    Stats::reset();
+    Stats::enable();
+    cds[0]->components.clear();
+    cds[1]->components.remove(cds[1]->components[0].identity.get());
+    doc.close(cds[2]->identity.get());
+    CHECK(doc.query(TermQuery::ofType(SBOL_COMPONENT)).size() == 1);
+    CHECK(doc.query(TermQuery(SBOL_ROLES, SO_PROMOTER)).size() == 3);
+    CHECK(doc.searchCount("gene") == 3);
+    CHECK(doc.searchCount("gene2") == 0);
+    CHECK(Stats::getCalls("index_terms") == 0);
+    CHECK(Stats::getCalls("index_text") == 0);
+    Stats::disable();
+    Stats::reset();
+
+    // Rolled back removals are indexed again
+    doc.beginTransaction();
+    doc.close(cds[3]->identity.get());
+    CHECK(doc.searchCount("gene3") == 0);
+    doc.rollback();
+    CHECK(doc.searchCount("gene3") == 1);
+    CHECK(doc.query(TermQuery::ofType(SBOL_COMPONENT)).size() == 1);
+    return failures;
+}
+
+int testGetByClass()
+{
+    int failures = 0;
+    Document doc;
+    ComponentDefinition& cd = doc.componentDefinitions.create("cd");
+    ModuleDefinition& md = doc.moduleDefinitions.create("md");
+    Implementation& impl = doc.implementations.create("impl");
+    CHECK(&doc.get<ComponentDefinition>(cd.identity.get()) == &cd);
+    CHECK(&doc.get<TopLevel>(md.identity.get()) == &md);
+    CHECK(&doc.get<Implementation>(impl.identity.get()) == &impl);
+
+    // An object of another class is not returned
+    bool threw = false;
+    try
+    {
+        doc.get<ComponentDefinition>(md.identity.get());
+    }
+    catch (SBOLError& e)
+    {
+        threw = e.error_code() == SBOL_ERROR_TYPE_MISMATCH;
+    }
+    CHECK(threw);
+
+    // The latest version is found by persistentIdentity
+    ComponentDefinition& cd2 = *new ComponentDefinition("cd", BIOPAX_DNA, "2");
+    doc.add<ComponentDefinition>(cd2);
+    CHECK(&doc.get<ComponentDefinition>(cd.persistentIdentity.get()) == &cd2);
+    threw = false;
+    try
+    {
+        doc.get<ModuleDefinition>(cd.persistentIdentity.get());
+    }
+    catch (SBOLError& e)
+    {
+        threw = e.error_code() == NOT_FOUND_ERROR;
+    }
+    CHECK(threw);
+    return failures;
+}
+
+// Everything a reader of a frozen Document can do, as one string, so results on different threads can be compared
+string read_frozen(Document& doc, const vector<string>& uris)
+{
+    string result;
+    for (auto & uri : uris)
+        result += doc.find(uri) ? "1" : "0";
+    vector<string> ids;
+    for (auto & obj : doc.query(TermQuery(SBOL_ROLES, SO_PROMOTER)))
+        ids.push_back(obj->identity.get());
+    sort(ids.begin(), ids.end());
+    for (auto & id : ids)
+        result += " " + id;
+    SearchResponse& response = doc.search("gene", SBOL_COMPONENT_DEFINITION, 0, 100);
+    for (auto & record : response.records)
+        result += " " + record->identity.get();
+    delete &response;
+    ids.clear();
+    for (auto & obj : doc)
+        ids.push_back(obj.identity.get());
+    sort(ids.begin(), ids.end());
+    for (auto & id : ids)
+        result += " " + id;
+    for (auto & id : doc.ancestors(uris[uris.size() - 2]))
+        result += " " + id;
+    return result + doc.writeString();
+}
+
+void create_lineage(Document& doc, vector<string>& uris)
+{
+    for (int i = 0; i < 50; ++i)
+    {
+        ComponentDefinition& cd = doc.componentDefinitions.create("gene" + to_string(i));
+        cd.roles.set(i % 2 ? SO_PROMOTER : SO_CDS);
+        cd.description.set("gene number " + to_string(i));
+        if (i)
+            cd.wasDerivedFrom.set(uris[uris.size() - 2]);
+        Component& c = cd.components.create("part");
+        uris.push_back(cd.identity.get());
+        uris.push_back(c.identity.get());
+    }
+    uris.push_back("http://examples.org/missing");
+}
+
+int testFrozenConcurrentReads()
+{
+    int failures = 0;
+    Document doc;
+    vector<string> uris;
+    create_lineage(doc, uris);
+    doc.freeze();
+    CHECK(doc.isFrozen());
+
+    // The serialization cache of the frozen Document is filled by whichever thread writes it first
+    vector<string> results(8);
+    vector<thread> readers;
+    for (size_t i_thread = 0; i_thread < results.size(); ++i_thread)
+        readers.emplace_back([&, i_thread]()
+        {
+            for (int i = 0; i < 20; ++i)
+                results[i_thread] += read_frozen(doc, uris);
+        });
+    for (auto & reader : readers)
+        reader.join();
+
+    // An identical Document that is not frozen, read on one thread
+    Document baseline_doc;
+    vector<string> baseline_uris;
+    create_lineage(baseline_doc, baseline_uris);
+    string expected = "";
+    for (int i = 0; i < 20; ++i)
+        expected += read_frozen(baseline_doc, baseline_uris);
+    for (auto & result : results)
+        CHECK(result == expected);
+    CHECK(expected.find(uris[0]) != string::npos);
+    return failures;
+}
+
+int testCloseRemovesFromStore()
+{
+    int failures = 0;
+    Document doc;
+    ComponentDefinition& cd0 = doc.componentDefinitions.create("cd0");
+    ComponentDefinition& cd1 = doc.componentDefinitions.create("cd1");
+    doc.componentDefinitions.create("cd2");
+    doc.sequences.create("seq");
+    string cd1_uri = cd1.identity.get();
+    string before = doc.writeString();
+
+    // A rolled back close puts the object back at its position in the store
+    doc.beginTransaction();
+    doc.close(cd1_uri);
+    CHECK(doc.componentDefinitions.size() == 2);
+    CHECK(doc.find(cd1_uri) == NULL);
+    doc.rollback();
+    CHECK(doc.componentDefinitions.size() == 3);
+    CHECK(&doc.componentDefinitions[1] == &cd1);
+    CHECK(doc.find(cd1_uri) == &cd1);
+    CHECK(doc.writeString() == before);
+
+    doc.close(cd0.identity.get());
+    doc.close(cd1_uri);
+    CHECK(doc.componentDefinitions.size() == 1);
+    CHECK(doc.sequences.size() == 1);
+    for (auto & cd : doc.componentDefinitions)
+        CHECK(cd.displayId.get() == "cd2");
+    CHECK(doc.size() == 2);
+    return failures;
+}
+
+class CountingObserver : public DocumentObserver
+{
+public:
+    int& n_deleted;
+    CountingObserver(int& n_deleted) : n_deleted(n_deleted) {};
+    ~CountingObserver() { ++n_deleted; };
+    void changed(Document& doc, const vector<ChangeEvent>& changes) override {};
+};
+
+int testOwnedObserversReleased()
+{
+    int failures = 0;
+    int n_deleted = 0;
+    Document* doc = new Document();
+    CountingObserver* observer = new CountingObserver(n_deleted);
+    doc->owned_observers.push_back(observer);
+    doc->addObserver(*observer);
+    doc->componentDefinitions.create("cd");
+    CHECK(n_deleted == 0);
+    delete doc;
+    CHECK(n_deleted == 1);
+    return failures;
+}
+
+// Two waves of threads mint identifiers. The threads of the second wave take over the slots of the first
+int testIdentifiersUnique()
+{
+    int failures = 0;
+    const size_t n_threads = 8;
+    const size_t n_ids = 500000;
+    vector<vector<pair<uint64_t, uint64_t>>> ids(2 * n_threads);
+    for (size_t wave = 0; wave < 2; ++wave)
+    {
+        vector<thread> minters;
+        for (size_t i_thread = wave * n_threads; i_thread < (wave + 1) * n_threads; ++i_thread)
+            minters.emplace_back([&, i_thread]()
+            {
+                // Identifiers are kept as two 64-bit numbers, so the test does not hold millions of strings
+                ids[i_thread].reserve(n_ids);
+                for (size_t i = 0; i < n_ids; ++i)
+                {
+                    string id = randomIdentifier();
+                    id.erase(std::remove(id.begin(), id.end(), '-'), id.end());
+                    ids[i_thread].push_back({ stoull(id.substr(0, 16), NULL, 16), stoull(id.substr(16), NULL, 16) });
+                }
+            });
+        for (auto & minter : minters)
+            minter.join();
+    }
+    vector<pair<uint64_t, uint64_t>> all_ids;
+    for (auto & thread_ids : ids)
+    {
+        all_ids.insert(all_ids.end(), thread_ids.begin(), thread_ids.end());
+        thread_ids = vector<pair<uint64_t, uint64_t>>();
+    }
+    sort(all_ids.begin(), all_ids.end());
+    CHECK(all_ids.size() == 2 * n_threads * n_ids);
+    CHECK(std::adjacent_find(all_ids.begin(), all_ids.end()) == all_ids.end());
+    CHECK(randomIdentifier().size() == 36);
+    return failures;
+}
+
+int testPinnedValues()
+{
+    int failures = 0;
+    Document doc;
+    Sequence& seq = doc.sequences.create("seq");
+    seq.elements.set("atgc");
+    pin_values(&seq, SBOL_ELEMENTS);
+    pin_values(&seq, SBOL_ELEMENTS);
+    bool threw = false;
+    try
+    {
+        seq.elements.set("cc");
+    }
+    catch (SBOLError&)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(seq.elements.get() == "atgc");
+    seq.name.set("named");  // Other properties can still change
+
+    // The values stay pinned until every pin is released
+    unpin_values(&seq, SBOL_ELEMENTS);
+    threw = false;
+    try
+    {
+        seq.elements.clear();
+    }
+    catch (SBOLError&)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+    unpin_values(&seq, SBOL_ELEMENTS);
+    seq.elements.set("cc");
+    CHECK(seq.elements.get() == "cc");
+    return failures;
+}
+
+int testLineageKeptByUnrelatedChanges()
+{
+    int failures = 0;
+    Document doc;
+    ComponentDefinition& cd0 = doc.componentDefinitions.create("cd0");
+    ComponentDefinition& cd1 = doc.componentDefinitions.create("cd1");
+    cd1.wasDerivedFrom.set(cd0.identity.get());
+    CHECK(doc.descendants(cd0.identity.get()).size() == 1);
+
+    // Objects without provenance values leave the graph as it is
+    Stats::reset();
+    Stats::enable();
+    ComponentDefinition& unrelated = doc.componentDefinitions.create("unrelated");
+    unrelated.sequenceAnnotations.create("sa");
+    doc.componentDefinitions.remove(unrelated.identity.get());
+    CHECK(doc.descendants(cd0.identity.get()).size() == 1);
+    CHECK(Stats::getCalls("index_lineage") == 0);
+
+    // Adding or removing an object that carries provenance rebuilds it
+    ComponentDefinition& cd2 = doc.componentDefinitions.create("cd2");
+    cd2.wasDerivedFrom.set(cd1.identity.get());
+    CHECK(doc.descendants(cd0.identity.get()).size() == 2);
+    ComponentDefinition* cd3 = new ComponentDefinition("cd3");
+    cd3->wasDerivedFrom.set(cd1.identity.get());
+    doc.add<ComponentDefinition>(*cd3);
+    CHECK(doc.descendants(cd0.identity.get()).size() == 3);
+    doc.componentDefinitions.remove(cd2.identity.get());
+    CHECK(doc.descendants(cd0.identity.get()).size() == 2);
+    CHECK(Stats::getCalls("index_lineage") == 3);
+    Stats::disable();
+    Stats::reset();
+    return failures;
+}
+
+int testTriplesWithoutIdentity()
+{
+    int failures = 0;
+    Document doc;
+    ComponentDefinition& cd = doc.componentDefinitions.create("cd");
+    SequenceAnnotation& sa = cd.sequenceAnnotations.create("sa");
+    vector<string> identity = sa.properties[SBOL_IDENTITY];
+    string buffer;
+    CHECK(doc.serialize_triples("ntriples", buffer) > 0);
+
+    // An object whose identity was removed is reported rather than read past the end of its values
+    for (auto & values : { vector<string>(), vector<string>({ "<>" }) })
+    {
+        sa.properties[SBOL_IDENTITY] = values;
+        for (string format : { "ntriples", "turtle" })
+        {
+            bool threw = false;
+            try
+            {
+                buffer.clear();
+                doc.serialize_triples(format, buffer);
+            }
+            catch (SBOLError& e)
+            {
+                threw = e.error_code() == SBOL_ERROR_SERIALIZATION;
+            }
+            CHECK(threw);
+        }
+    }
+    sa.properties.erase(SBOL_IDENTITY);
+    bool threw = false;
+    try
+    {
+        buffer.clear();
+        doc.serialize_triples("ntriples", buffer);
+    }
+    catch (SBOLError& e)
+    {
+        threw = e.error_code() == SBOL_ERROR_SERIALIZATION;
+    }
+    CHECK(threw);
+    sa.properties[SBOL_IDENTITY] = identity;
+    return failures;
+}
+
+static int count_parts(ComponentDefinition& cd, vector<int>& child_values, void* user_data)
+{
+    int n_parts = child_values.empty() ? 1 : 0;
+    for (auto n : child_values)
+        n_parts += n;
+    ++*(atomic<int>*)user_data;
+    return n_parts;
+}
+
+// A deep chain under a wide fan, with shared and repeated children, so some nodes become ready while others run
+int testParallelForReady()
+{
+    int failures = 0;
+    const size_t n_chain = 200;
+    const size_t n_fan = 1000;
+    vector<vector<size_t>> children(1 + n_chain + n_fan);
+    for (size_t i = 0; i < n_chain; ++i)
+        children[1 + i] = i + 1 < n_chain ? vector<size_t>{ 2 + i } : vector<size_t>{};
+    for (size_t i = 0; i < n_fan; ++i)
+    {
+        size_t i_node = 1 + n_chain + i;
+        if (i % 2)
+            children[i_node] = { i_node - 1, i_node - 1 };
+        children[0].push_back(i_node);
+    }
+    children[0].push_back(1);
+    vector<atomic<size_t>> finished(children.size());
+    vector<atomic<int>> calls(children.size());
+    for (size_t i = 0; i < children.size(); ++i)
+        finished[i] = calls[i] = 0;
+    atomic<size_t> clock(0);
+    atomic<bool> ordered(true);
+    parallel_for_ready(children, 8, [&](size_t i_node)
+    {
+        for (auto i_child : children[i_node])
+            if (!finished[i_child])
+                ordered = false;
+        ++calls[i_node];
+        finished[i_node] = ++clock;
+    });
+    CHECK(ordered);
+    CHECK(clock == children.size());
+    CHECK(std::all_of(calls.begin(), calls.end(), [](atomic<int>& n) { return n == 1; }));
+
+    // The walk stops at the first failure, and nothing that depends on the failed node runs
+    for (auto & n : calls)
+        n = 0;
+    bool thrown = false;
+    try
+    {
+        parallel_for_ready(children, 8, [&](size_t i_node)
+        {
+            ++calls[i_node];
+            if (i_node == n_chain)
+                throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "failed");
+        });
+    }
+    catch (SBOLError&)
+    {
+        thrown = true;
+    }
+    CHECK(thrown);
+    for (size_t i = 1; i < n_chain; ++i)
+        CHECK(calls[i] == 0);
+    CHECK(calls[0] == 0);
+
+    // A definition used twice is reduced once, and counted once per use
+    Document doc;
+    ComponentDefinition& root = doc.componentDefinitions.create("root");
+    ComponentDefinition& shared = doc.componentDefinitions.create("shared");
+    ComponentDefinition& other = doc.componentDefinitions.create("other");
+    ComponentDefinition& middle = doc.componentDefinitions.create("middle");
+    root.components.create("c0").definition.set(middle.identity.get());
+    root.components.create("c1").definition.set(shared.identity.get());
+    middle.components.create("c0").definition.set(shared.identity.get());
+    middle.components.create("c1").definition.set(other.identity.get());
+    atomic<int> n_reduced(0);
+    CHECK(root.reduceComponentHierarchy<int>(count_parts, &n_reduced, 4) == 3);
+    CHECK(n_reduced == 4);
+    return failures;
+}
+
+int main(int argc, char* argv[])
+{
+    setup();
+    vector< pair<string, int(*)()> > tests = {
+        { "BulkInsertRollback", testBulkInsertRollback },
+        { "StatsCounters", testStatsCounters },
+        { "VariableComponentRegistered", testVariableComponentRegistered },
+        { "FindPropertyValue", testFindPropertyValue },
+        { "CompileNested", testCompileNested },
+        { "ReportQC", testReportQC },
+        { "QCAnnotations", testQCAnnotations },
+        { "VerifyTargets", testVerifyTargets },
+        { "RemoveKeepsIndices", testRemoveKeepsIndices },
+        { "GetByClass", testGetByClass },
+        { "FrozenConcurrentReads", testFrozenConcurrentReads },
+        { "CloseRemovesFromStore", testCloseRemovesFromStore },
+        { "OwnedObserversReleased", testOwnedObserversReleased },
+        { "IdentifiersUnique", testIdentifiersUnique },
+        { "PinnedValues", testPinnedValues },
+        { "LineageKeptByUnrelatedChanges", testLineageKeptByUnrelatedChanges },
+        { "TriplesWithoutIdentity", testTriplesWithoutIdentity },
+        { "ParallelForReady", testParallelForReady },
+    };
+    int failed = 0;
+    for (auto & test : tests)
+    {
+        if (argc > 1 && test.first != argv[1])
+            continue;
+        cout << "Testing " << test.first << endl;
+        int failures = test.second();
+        if (failures)
+        {
+            cout << "XXX " << test.first << " failed XXX" << endl;
+            ++failed;
+        }
+        else
+            cout << "=== " << test.first << " passed ===" << endl;
+    }
+    cout << "FAILED: " << failed << endl;
+    return failed ? 1 : 0;
+}
@@ -121,19 +121,19 @@
         }
         return identified_vector;
     }
-%}
-
-
-
 
-
-//  General error handling and mapping of libSBOL exception types to Python exception types
-%exception {
-    try
+    // Releases the GIL for the lifetime of the object, so other Python threads can run while libSBOL does pure C++ work or waits on the network
+    class ReleaseGIL
     {
-        $function
-    }
-    catch(SBOLError e)
+    public:
+        ReleaseGIL() : thread_state(PyEval_SaveThread()) {};
+        ~ReleaseGIL() { PyEval_RestoreThread(thread_state); };
+    private:
+        PyThreadState* thread_state;
+    };
+
+    // Map a libSBOL exception to the corresponding Python exception type
+    void set_python_error(SBOLError& e)
     {
         if (e.error_code() == SBOL_ERROR_NOT_FOUND)
         {
@@ -151,10 +151,109 @@
         {
             PyErr_SetString(PyExc_IOError, e.what());
         }
+#if PY_MAJOR_VERSION >= 3
+        else if (e.error_code() == SBOL_ERROR_FROZEN_DOCUMENT)
+        {
+            PyErr_SetString(PyExc_PermissionError, e.what());
+        }
+#endif
         else
         {
             PyErr_SetString(PyExc_RuntimeError, e.what());
         }
+    }
+
+#if PY_MAJOR_VERSION >= 3
+    // Exports the values of a property through the buffer protocol without copying them. The values stay pinned, so they cannot change, until the exporter and every view of it are released
+    typedef struct {
+        PyObject_HEAD
+        PyObject* owner;  // The Python object that wraps the property's owner
+        sbol::SBOLObject* sbol_owner;
+        sbol::rdf_type* property_type;
+        const char* data;
+        Py_ssize_t size;
+    } PinnedBuffer;
+
+    static int PinnedBuffer_getbuffer(PyObject* exporter, Py_buffer* view, int flags)
+    {
+        PinnedBuffer* buffer = (PinnedBuffer*)exporter;
+        return PyBuffer_FillInfo(view, exporter, (void*)buffer->data, buffer->size, 1, flags);
+    }
+
+    static void PinnedBuffer_dealloc(PyObject* exporter)
+    {
+        PinnedBuffer* buffer = (PinnedBuffer*)exporter;
+        sbol::unpin_values(buffer->sbol_owner, *buffer->property_type);
+        delete buffer->property_type;
+        Py_XDECREF(buffer->owner);
+        PyObject_Del(exporter);
+    }
+
+    static PyBufferProcs PinnedBuffer_as_buffer = { PinnedBuffer_getbuffer, NULL };
+    static PyTypeObject PinnedBufferType = { PyVarObject_HEAD_INIT(NULL, 0) };
+#endif
+
+    // Get a read-only memoryview of the first value of a literal property, without the quotes it is stored with. In Python 2, the characters are copied into a str
+    PyObject* view_literal(sbol::SBOLObject* sbol_owner, const sbol::rdf_type& property_type, PyObject* owner)
+    {
+        const char* data = "";
+        size_t size = 0;
+        auto i_values = sbol_owner->properties.find(property_type);
+        if (i_values != sbol_owner->properties.end() && i_values->second.size() && i_values->second.front().size() > 2)
+        {
+            data = i_values->second.front().data() + 1;
+            size = i_values->second.front().size() - 2;
+        }
+#if PY_MAJOR_VERSION >= 3
+        PinnedBuffer* buffer = PyObject_New(PinnedBuffer, &PinnedBufferType);
+        if (!buffer)
+            return NULL;
+        Py_XINCREF(owner);
+        buffer->owner = owner;
+        buffer->sbol_owner = sbol_owner;
+        buffer->property_type = new sbol::rdf_type(property_type);
+        buffer->data = data;
+        buffer->size = (Py_ssize_t)size;
+        sbol::pin_values(sbol_owner, property_type);
+        PyObject* view = PyMemoryView_FromObject((PyObject*)buffer);
+        Py_DECREF(buffer);
+        return view;
+#else
+        return PyString_FromStringAndSize(data, size);
+#endif
+    }
+%}
+
+%init
+%{
+#if PY_VERSION_HEX < 0x03070000
+    PyEval_InitThreads();
+#endif
+    // Hold a reference on libcurl's global state for the life of the module, so the per-request init and cleanup calls cannot race when requests run concurrently
+    curl_global_init(CURL_GLOBAL_ALL);
+#if PY_MAJOR_VERSION >= 3
+    PinnedBufferType.tp_name = "libsbol.PinnedBuffer";
+    PinnedBufferType.tp_basicsize = sizeof(PinnedBuffer);
+    PinnedBufferType.tp_flags = Py_TPFLAGS_DEFAULT;
+    PinnedBufferType.tp_dealloc = PinnedBuffer_dealloc;
+    PinnedBufferType.tp_as_buffer = &PinnedBuffer_as_buffer;
+    PyType_Ready(&PinnedBufferType);
+#endif
+%}
+
+
+
+
+
+//  General error handling and mapping of libSBOL exception types to Python exception types
+%exception {
+    try
+    {
+        $function
+    }
+    catch(SBOLError e)
+    {
+        set_python_error(e);
         return NULL;
     }
     catch(...)
@@ -163,6 +262,44 @@
     }
 }
 
+// Long-running file and network operations release the GIL while they run. Python callbacks made during these operations, such as constructors of registered extension classes, reacquire it. A Document must not be modified by another thread while one of these operations is using it
+%define SBOL_RELEASE_GIL(method)
+%exception method {
+    try
+    {
+        ReleaseGIL release_gil;
+        $action
+    }
+    catch(SBOLError e)
+    {
+        set_python_error(e);
+        return NULL;
+    }
+    catch(...)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "An error of unspecified type occurred");
+        return NULL;
+    }
+}
+%enddef
+
+SBOL_RELEASE_GIL(sbol::Document::read)
+SBOL_RELEASE_GIL(sbol::Document::readString)
+SBOL_RELEASE_GIL(sbol::Document::append)
+SBOL_RELEASE_GIL(sbol::Document::write)
+SBOL_RELEASE_GIL(sbol::Document::writeString)
+SBOL_RELEASE_GIL(sbol::Document::validate)
+SBOL_RELEASE_GIL(sbol::Document::saveSnapshot)
+SBOL_RELEASE_GIL(sbol::Document::loadSnapshot)
+SBOL_RELEASE_GIL(sbol::PartShop::pull)
+SBOL_RELEASE_GIL(sbol::PartShop::count)
+SBOL_RELEASE_GIL(sbol::PartShop::search)
+SBOL_RELEASE_GIL(sbol::PartShop::searchCount)
+SBOL_RELEASE_GIL(sbol::PartShop::searchRootCollections)
+SBOL_RELEASE_GIL(sbol::PartShop::searchSubCollections)
+SBOL_RELEASE_GIL(sbol::PartShop::submit)
+SBOL_RELEASE_GIL(sbol::PartShop::login)
+
 // Catch the signal from the Python interpreter indicating that iteration has reached end of list. For Python 2
 %exception next
 {
@@ -215,10 +352,109 @@
 %ignore sbol::Document::flatten();
 %ignore sbol::Document::parse_objects;
 %ignore sbol::Document::close;
+%ignore sbol::Document::lineage_parents;
+%ignore sbol::Document::lineage_children;
+%ignore sbol::Document::lineage_valid;
+%ignore sbol::Document::index_lineage;
+%ignore sbol::Document::getPropertyColumns;  // Use variant signature defined in this interface file
+%ignore sbol::notify_property_change;
+%ignore sbol::ComponentHierarchy;
+%ignore sbol::TermQuery::operands;
+%rename(__and__) sbol::TermQuery::operator&;
+%rename(__or__) sbol::TermQuery::operator|;
+%ignore sbol::Document::indexed_properties;
+%ignore sbol::Document::term_index;
+%ignore sbol::Document::term_index_entries;
+%ignore sbol::Document::term_index_dirty;
+%ignore sbol::Document::term_index_valid;
+%ignore sbol::Document::index_terms;
+%ignore sbol::Document::index_new_object;
+%ignore sbol::Document::unindex_object;
+%ignore sbol::Document::invalidate_indices;
+%ignore sbol::TextPosting;
+%ignore sbol::Document::text_properties;
+%ignore sbol::Document::text_index;
+%ignore sbol::Document::text_index_objects;
+%ignore sbol::Document::text_index_ids;
+%ignore sbol::Document::text_index_classes;
+%ignore sbol::Document::text_index_class_uris;
+%ignore sbol::Document::text_index_dirty;
+%ignore sbol::Document::text_index_valid;
+%ignore sbol::Document::index_text;
+%ignore sbol::Document::unindex_text;
+%newobject sbol::Document::search;
+%ignore sbol::parallel_for;
+%ignore sbol::parallel_for_ready;
+%ignore sbol::ComponentDefinition::indexComponentHierarchy;
+%ignore sbol::DeserializationScope;
+%ignore sbol::Document::existing_children;
+%ignore sbol::Document::annotation_references;
+%ignore sbol::Document::collect_existing_children;
+%ignore sbol::ClassTraits;
+%ignore sbol::ClassRegistry;
+%ignore sbol::is_instance;
+%ignore sbol::next_revision;
+%ignore sbol::SBOLObject::revision;
+%ignore sbol::SerializedFragment;
+%ignore sbol::SerializationCache;
+%ignore sbol::Document::serialization_caches;
+%ignore sbol::Document::serialize_fragments;
+%ignore sbol::Document::serialize_rdfxml_fragment;
+%ignore sbol::Document::serialize_triples_fragments;
+%ignore sbol::Document::collect_namespaces;
+%ignore sbol::Compression;
+%ignore sbol::compression_from_filename;
+%ignore sbol::write_compressed_file;
+%ignore sbol::InputDecoder;
+%ignore sbol::InputFile;
+%ignore sbol::MemoryUsage::ClassUsage;
+%ignore sbol::MemoryUsage::object_count;
+%ignore sbol::MemoryUsage::triple_count;
+%ignore sbol::MemoryUsage::categories;
+%ignore sbol::MemoryUsage::classes;
+%ignore sbol::MemoryUsage::largest_objects;
+%ignore sbol::check_mutable;
+%ignore sbol::pin_values;
+%ignore sbol::unpin_values;
+%ignore sbol::AtomicFlag;
+%ignore sbol::Document::frozen;
+%ignore sbol::Document::assemble_fragments;
+%ignore sbol::Document::serialize_frozen;
+%ignore sbol::Document::release_frozen;
+%ignore sbol::UndoEntry;
+%ignore sbol::owning_document;
+%ignore sbol::record_values;
+%ignore sbol::record_object_added;
+%ignore sbol::record_object_removed;
+%ignore sbol::record_object_store;
+%ignore sbol::record_links;
+%ignore sbol::record_registration;
+%ignore sbol::record_created;
+%ignore sbol::release_object;
+%ignore sbol::Document::undo_log;
+%ignore sbol::Document::savepoints;
+%ignore sbol::Document::check_no_transaction;
+%ignore sbol::Document::release_transactions;
+%ignore sbol::notify_change;
+%ignore sbol::is_observed;
+%ignore sbol::ReloadScope;
+%ignore sbol::DocumentObserver;
+%ignore sbol::Document::addObserver(DocumentObserver& observer);  // Use variant signature defined in this interface file
+%ignore sbol::Document::removeObserver(DocumentObserver& observer);  // Use variant signature defined in this interface file
+%ignore sbol::Document::observers;
+%ignore sbol::Document::owned_observers;
+%ignore sbol::Document::queued_changes;
+%ignore sbol::Document::batch_depth;
+%ignore sbol::Document::reload_depth;
+%ignore sbol::Document::deliver_change;
+%ignore sbol::Document::release_observers;
+%ignore sbol::ComponentDefinition::reduceComponentHierarchy;
 %ignore sbol::ComponentDefinition::assemble(std::vector<std::string> list_of_uris, Document& doc);  // Use variant signature defined in this interface file
 %ignore sbol::ComponentDefinition::assemble(std::vector<std::string> list_of_uris);  // Use variant signature defined in this interface file
 %ignore sbol::ComponentDefinition::linearize(std::vector<std::string> list_of_uris);  // Use variant signature defined in this interface file
 %ignore sbol::TopLevel::addToDocument;
+%ignore sbol::Analysis::verifyTargets(std::vector < sbol::Analysis* > analyses, std::vector < sbol::Sequence* > consensus_sequences, int threads);  // Use variant signature defined in this interface file
+%ignore sbol::Analysis::verifyTargets(std::vector < sbol::Analysis* > analyses, std::vector < sbol::Sequence* > consensus_sequences);
 
 // Instantiate STL templates
 %include "std_string.i"
@@ -257,7 +493,88 @@
     }
     $result  = dict;
     $1.clear();
-    
+
+}
+
+// Typemap the combined statistics returned by Analysis::reportQC and Analysis::verifyTargets
+%{
+    PyObject* convert_qc_report_to_dict(std::unordered_map < std::string, sbol::QCStatistics >& qc_report)
+    {
+        PyObject* dict = PyDict_New();
+        for(auto & i_elem : qc_report)
+        {
+            sbol::QCStatistics& stats = i_elem.second;
+            PyObject* py_vals = Py_BuildValue("{s:i,s:i,s:f,s:f,s:f,s:f}", "start", stats.start, "end", stats.end, "identity", stats.identity, "error", stats.error, "ambiguity", stats.ambiguity, "coverage", stats.coverage);
+            PyDict_SetItemString(dict, i_elem.first.c_str(), py_vals);
+            Py_DECREF(py_vals);
+        }
+        return dict;
+    }
+%}
+
+%typemap(out) std::unordered_map < std::string, sbol::QCStatistics > {
+    $result  = convert_qc_report_to_dict($1);
+    $1.clear();
+}
+
+// Typemap the columns returned by Document::getPropertyColumns into a list of columns, each holding a list of values per object
+%typemap(out) std::vector < sbol::PropertyColumn > {
+    PyObject* columns = PyList_New($1.size());
+    for (size_t i_column = 0; i_column < $1.size(); ++i_column)
+    {
+        sbol::PropertyColumn& column = $1[i_column];
+        size_t n_objects = column.offsets.size() - 1;
+        PyObject* py_column = PyList_New(n_objects);
+        for (size_t i_obj = 0; i_obj < n_objects; ++i_obj)
+        {
+            size_t i_begin = column.offsets[i_obj];
+            PyObject* py_values = PyList_New(column.offsets[i_obj + 1] - i_begin);
+            for (size_t i_val = i_begin; i_val < column.offsets[i_obj + 1]; ++i_val)
+                PyList_SET_ITEM(py_values, i_val - i_begin, PyUnicode_FromStringAndSize(column.values[i_val].data(), column.values[i_val].size()));
+            PyList_SET_ITEM(py_column, i_obj, py_values);
+        }
+        PyList_SET_ITEM(columns, i_column, py_column);
+    }
+    $result = columns;
+}
+
+// Typemap the objects matched by Document::query into a list of objects of their most derived wrapped class. Python extension objects are returned as registered in their Document
+%typemap(out) std::vector < sbol::SBOLObject* > query {
+    std::unordered_map<std::string, swig_type_info*> descriptors;
+    PyObject* list = PyList_New($1.size());
+    for (size_t i_obj = 0; i_obj < $1.size(); ++i_obj)
+    {
+        sbol::SBOLObject* obj = $1[i_obj];
+        PyObject* py_obj = NULL;
+        auto i_descriptor = descriptors.find(obj->type);
+        if (i_descriptor == descriptors.end())
+            i_descriptor = descriptors.emplace(obj->type, SWIG_TypeQuery(("sbol::" + sbol::parseClassName(obj->type) + " *").c_str())).first;
+        if (!i_descriptor->second && obj->doc)
+        {
+            auto i_py_obj = obj->doc->PythonObjects.find(obj->identity.get());
+            if (i_py_obj != obj->doc->PythonObjects.end())
+            {
+                py_obj = i_py_obj->second;
+                Py_INCREF(py_obj);
+            }
+        }
+        if (!py_obj)
+            py_obj = SWIG_NewPointerObj(SWIG_as_voidptr(obj), i_descriptor->second ? i_descriptor->second : $descriptor(sbol::SBOLObject*), 0);
+        PyList_SET_ITEM(list, i_obj, py_obj);
+    }
+    $result = list;
+}
+
+%typemap(out) std::vector < std::unordered_map < std::string, sbol::QCStatistics > > {
+    PyObject* list = PyList_New(0);
+    for(auto & qc_report : $1)
+    {
+        PyObject* dict = convert_qc_report_to_dict(qc_report);
+        PyList_Append(list, dict);
+        Py_DECREF(dict);
+    }
+    $result  = list;
+    $1.clear();
 }
 
 %template(_IntVector) std::vector<int>;
@@ -271,6 +588,14 @@
 // Instantiate libSBOL templates
 %include "config.h"
 %include "constants.h"
+
+// Timers, counters and the curl wrapper are internal to the instrumented library code
+%ignore sbol::StatsTimer;
+%ignore sbol::StatsCounter;
+%ignore sbol::Stats::add_time;
+%ignore sbol::Stats::get_counter;
+%ignore sbol::perform_request;
+%include "stats.h"
 %include "validation.h"
 %include "property.h"
 
@@ -306,12 +631,26 @@
 %{
     val.thisown = False
 %}
+
+// The Document takes ownership of every object in a batch
+%pythonappend addBatch
+%{
+    for obj in sbol_objects:
+        obj.thisown = False
+%}
     
 // verifyTarget acts like a setter
 %pythonappend verifyTarget
 %{
     consensus_sequence.thisown = False
 %}
+
+// The Analyses take ownership of their consensus Sequences
+%pythonappend verifyTargets
+%{
+    for consensus_sequence in consensus_sequences:
+        consensus_sequence.thisown = False
+%}
     
 /* @TODO remove methods should change thisown flag back to True */
 /* Currently this causes an exception (probably need a call to Py_INCREF */
@@ -438,6 +777,14 @@ typedef std::string sbol::sbol_type;
             PyObject *py_obj = SWIG_NewPointerObj(SWIG_as_voidptr(&obj), $descriptor(sbol::SBOLClass*), 0 |  0 );
             return py_obj;
         }
+
+        %pythoncode
+        %{
+            # Each loop gets its own cursor, so nested loops, and threads reading a frozen Document, do not share one
+            def __iter__(self):
+                for i_obj in range(len(self)):
+                    yield self[i_obj]
+        %}
         
         void __setitem__(const std::string uri, PyObject* py_obj)
         {
@@ -916,8 +1263,240 @@ TEMPLATE_MACRO_3(Document);
     };
 }
     
+// Each Python loop over a Document gets its own cursor, so nested and concurrent loops over the same Document do not interfere
+%newobject sbol::Document::__iter__;
+%newobject sbol::Document::_iter;
+
+// Keep the Document alive while a loop over it runs
+%pythonappend sbol::Document::__iter__
+%{
+    val._document = self
+%}
+
+%pythonappend sbol::Document::_iter
+%{
+    val._document = self
+%}
+
+%ignore DocumentIterator::DocumentIterator;
+%inline
+%{
+    class DocumentIterator
+    {
+    public:
+        DocumentIterator(sbol::Document& doc, PyObject* sbol_class = NULL, std::vector<std::string> class_names = {}) :
+            doc(doc),
+            store(NULL),
+            i_stores(doc.owned_objects.begin()),
+            i_store(0),
+            last(NULL),
+            descriptor(SWIG_TypeQuery("sbol::SBOLObject *")),
+            is_extension_class(false)
+        {
+            if (sbol_class)
+            {
+                // The type of objects to visit is looked up in the registers of classes, rather than read from a throwaway instance.
+                // A Python extension class that has never been registered has no objects in the Document, so the loop visits none
+                type_uri = Config::getExtensionClassType(sbol_class);
+                for (auto & class_name : class_names)
+                {
+                    if (type_uri != "")
+                        break;
+                    for (int id = 0; id < ClassRegistry::size(); ++id)
+                        if (parseClassName(ClassRegistry::get(id).type) == class_name)
+                        {
+                            const ClassTraits& traits = ClassRegistry::get(id);
+                            type_uri = traits.type;
+                            // Objects of a core class are kept in their own store, so they are returned straight from it
+                            auto i_type_store = doc.owned_objects.find(traits.store);
+                            if (traits.is_toplevel && i_type_store != doc.owned_objects.end())
+                                store = &i_type_store->second;
+                            break;
+                        }
+                }
+                if (type_uri == "")
+                {
+                    i_stores = doc.owned_objects.end();
+                    return;
+                }
+                if (!store)
+                {
+                    auto i_type_store = doc.owned_objects.find(type_uri);
+                    if (i_type_store != doc.owned_objects.end())
+                        store = &i_type_store->second;
+                }
+
+                // Look up the wrapped type once, rather than casting every object. Python extension classes are returned as the objects registered in the Document
+                for (size_t i_name = 0; i_name < class_names.size(); ++i_name)
+                {
+                    swig_type_info* class_descriptor = SWIG_TypeQuery(("sbol::" + class_names[i_name] + " *").c_str());
+                    if (class_descriptor)
+                    {
+                        descriptor = class_descriptor;
+                        is_extension_class = i_name > 0;
+                        break;
+                    }
+                }
+            }
+        };
+
+        DocumentIterator* __iter__()
+        {
+            return this;
+        };
+
+        // The loop walks the Document's object stores by index, so it copies nothing up front and survives the register being rehashed.
+        // Objects added during the loop are visited when they land after the cursor, and objects removed during the loop are not visited
+        PyObject* __next__()
+        {
+            SBOLObject* obj = NULL;
+            while (!obj)
+            {
+                std::vector<sbol::SBOLObject*>* current = store;
+                if (!current)
+                {
+                    if (i_stores == doc.owned_objects.end())
+                        break;
+                    current = &i_stores->second;
+                }
+                resume(*current);
+                if (i_store < current->size())
+                {
+                    last = (*current)[i_store++];
+                    if (type_uri == "" || last->type == type_uri)
+                        obj = last;
+                }
+                else if (store)
+                    break;
+                else
+                {
+                    ++i_stores;
+                    i_store = 0;
+                    last = NULL;
+                }
+            }
+            if (!obj)
+                throw SBOLError(END_OF_LIST, "");
+            if (is_extension_class)
+            {
+                auto i_py_obj = doc.PythonObjects.find(obj->identity.get());
+                if (i_py_obj != doc.PythonObjects.end())
+                {
+                    Py_INCREF(i_py_obj->second);
+                    return i_py_obj->second;
+                }
+            }
+            return SWIG_NewPointerObj(SWIG_as_voidptr(obj), descriptor, 0);
+        };
+
+        PyObject* next()
+        {
+            return __next__();
+        };
+
+    private:
+        sbol::Document& doc;
+        std::string type_uri;
+        std::vector<sbol::SBOLObject*>* store;  // The store of a typed loop, or NULL to walk every store
+        std::map<sbol::rdf_type, std::vector<sbol::SBOLObject*> >::iterator i_stores;
+        size_t i_store;
+        sbol::SBOLObject* last;  // The object at the cursor, used to find it again when objects before it are removed
+        swig_type_info* descriptor;
+        bool is_extension_class;
+
+        // Move the cursor back to just after the last object visited, if objects were removed from the store since
+        void resume(std::vector<sbol::SBOLObject*>& objects)
+        {
+            if (!last || (i_store <= objects.size() && objects[i_store - 1] == last))
+                return;
+            for (size_t i_obj = std::min(i_store, objects.size()); i_obj > 0; --i_obj)
+                if (objects[i_obj - 1] == last)
+                {
+                    i_store = i_obj;
+                    return;
+                }
+            // The last object was itself removed, so the next one has taken its place
+            i_store = std::min(i_store - 1, objects.size());
+        };
+    };
+%}
+
+%ignore PythonObserver;
+%inline
+%{
+    // Calls a Python callable with the Document and a list of ChangeEvents
+    class PythonObserver : public sbol::DocumentObserver
+    {
+    public:
+        PythonObserver(PyObject* callback) :
+            callback(callback)
+        {
+            Py_INCREF(callback);
+        };
+
+        ~PythonObserver()
+        {
+            PyGILState_STATE gil = PyGILState_Ensure();
+            Py_DECREF(callback);
+            PyGILState_Release(gil);
+        };
+
+        void changed(sbol::Document& doc, const std::vector<sbol::ChangeEvent>& changes) override
+        {
+            PyGILState_STATE gil = PyGILState_Ensure();
+            PyObject* py_doc = SWIG_NewPointerObj(SWIG_as_voidptr(&doc), SWIG_TypeQuery("sbol::Document *"), 0);
+            PyObject* py_changes = PyList_New(changes.size());
+            for (size_t i_change = 0; i_change < changes.size(); ++i_change)
+                PyList_SET_ITEM(py_changes, i_change, SWIG_NewPointerObj(SWIG_as_voidptr(new sbol::ChangeEvent(changes[i_change])), SWIG_TypeQuery("sbol::ChangeEvent *"), SWIG_POINTER_OWN));
+            PyObject* result = PyObject_CallFunctionObjArgs(callback, py_doc, py_changes, NULL);
+            // The change has already been made, so an exception raised by the callback cannot undo it
+            if (!result)
+                PyErr_Print();
+            Py_XDECREF(result);
+            Py_DECREF(py_changes);
+            Py_DECREF(py_doc);
+            PyGILState_Release(gil);
+        };
+
+        PyObject* callback;
+    };
+%}
+
 %extend sbol::Document
 {
+    /// Register a callable that is called as callback(doc, changes) with the changes made to the Document, as a list of ChangeEvents
+    void addObserver(PyObject* callback)
+    {
+        if (!PyCallable_Check(callback))
+            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot add observer. The observer must be callable");
+        // Bound methods are created anew each time they are looked up, so callbacks are compared by equality
+        for (auto & owned_observer : $self->owned_observers)
+        {
+            PythonObserver* observer = dynamic_cast<PythonObserver*>(owned_observer);
+            if (observer && PyObject_RichCompareBool(observer->callback, callback, Py_EQ) == 1)
+                return;
+        }
+        // The Document deletes its Python observers when it is destroyed
+        PythonObserver* observer = new PythonObserver(callback);
+        $self->owned_observers.push_back(observer);
+        $self->addObserver(*observer);
+    }
+
+    void removeObserver(PyObject* callback)
+    {
+        std::vector<DocumentObserver*>& observers = $self->owned_observers;
+        for (auto i_observer = observers.begin(); i_observer != observers.end(); ++i_observer)
+        {
+            PythonObserver* observer = dynamic_cast<PythonObserver*>(*i_observer);
+            if (!observer || PyObject_RichCompareBool(observer->callback, callback, Py_EQ) != 1)
+                continue;
+            $self->removeObserver(*observer);
+            observers.erase(i_observer);
+            delete observer;
+            break;
+        }
+    }
+
     PyObject* getExtensionObject(std::string id)
     {
         // Search the Document's object store for the uri
@@ -968,47 +1547,52 @@ TEMPLATE_MACRO_3(Document);
             throw SBOLError(SBOL_ERROR_TYPE_MISMATCH, "Not a valid SBOL object");
     }
     
-    Document* __iter__()
+    DocumentIterator* __iter__()
     {
-        $self->python_iter = Document::iterator($self->SBOLObjects.begin());
-        return $self;
+        return new DocumentIterator(*$self);
     }
     
-    SBOLObject* next()
+    DocumentIterator* _iter(PyObject* sbol_class, PyObject* class_names)
     {
-        if ($self->python_iter != $self->end())
-        {
-            SBOLObject& obj = *self->python_iter;
-            $self->python_iter++;
-            if ($self->python_iter == $self->end())
-            {
-                PyErr_SetNone(PyExc_StopIteration);
-            }
-            return &obj;
-        }
-        throw SBOLError(END_OF_LIST, "");
-        return NULL;
+        return new DocumentIterator(*$self, sbol_class, convert_list_to_string_vector(class_names));
     }
     
-    SBOLObject* __next__()
-    {
-        if ($self->python_iter != $self->end())
-        {
-            
-            SBOLObject& obj = *$self->python_iter;
-            $self->python_iter++;
-            return &obj;
-        }
-        
-        throw SBOLError(END_OF_LIST, "");;
-        return NULL;
-    }
+    %pythoncode
+    %{
+        def iter(self, sbol_class = None):
+            """Iterate over the TopLevel objects in this Document. If a class is given, only objects of that class are visited, and they are returned with that type rather than as SBOLObjects."""
+            if sbol_class is None:
+                return self.__iter__()
+            return self._iter(sbol_class, [base.__name__ for base in sbol_class.__mro__])
+    %}
     
     int __len__()
     {
         return $self->size();
     }
     
+    std::vector < sbol::PropertyColumn > getPropertyColumns(std::string object_type, PyObject* property_uris)
+    {
+        std::vector<std::string> list_of_property_uris = convert_list_to_string_vector(property_uris);
+        return $self->getPropertyColumns(object_type, list_of_property_uris);
+    }
+}
+
+%extend sbol::Sequence
+{
+    PyObject* _getElementsView(PyObject* owner)
+    {
+        return view_literal($self, SBOL_ELEMENTS, owner);
+    }
+    
+    %pythoncode
+    %{
+        def getElementsView(self):
+            """Get the elements as a read-only memoryview of bytes, without copying them. The view keeps this Sequence
+            alive. Until the view and every slice of it are released, setting, clearing or removing the elements raises
+            a RuntimeError. Call release() on the view, or use it in a with statement, to change the elements again."""
+            return self._getElementsView(self)
+    %}
 }
 
     
@@ -1031,6 +1615,33 @@ TEMPLATE_MACRO_3(Document);
     }
 }
 
+%extend sbol::Analysis
+{
+    static std::vector < std::unordered_map < std::string, sbol::QCStatistics > > verifyTargets(PyObject *analyses, PyObject *consensus_sequences, int threads = 0)
+    {
+        if (!PyList_Check(analyses) || !PyList_Check(consensus_sequences))
+            throw SBOLError(SBOL_ERROR_TYPE_MISMATCH, "Arguments must be a List of Analysis objects and a List of consensus Sequence objects");
+        std::vector<sbol::Analysis*> list_of_analyses = {};
+        std::vector<sbol::Sequence*> list_of_sequences = {};
+        for (int i = 0; i < PyList_Size(analyses); ++i)
+        {
+            sbol::Analysis* analysis;
+            if ((SWIG_ConvertPtr(PyList_GetItem(analyses, i),(void **) &analysis, $descriptor(sbol::Analysis*),1)) == -1)
+                throw SBOLError(SBOL_ERROR_TYPE_MISMATCH, "First argument must be a List of Analysis objects");
+            list_of_analyses.push_back(analysis);
+        }
+        for (int i = 0; i < PyList_Size(consensus_sequences); ++i)
+        {
+            sbol::Sequence* seq;
+            if ((SWIG_ConvertPtr(PyList_GetItem(consensus_sequences, i),(void **) &seq, $descriptor(sbol::Sequence*),1)) == -1)
+                throw SBOLError(SBOL_ERROR_TYPE_MISMATCH, "Second argument must be a List of Sequence objects");
+            list_of_sequences.push_back(seq);
+        }
+        ReleaseGIL release_gil;
+        return sbol::Analysis::verifyTargets(list_of_analyses, list_of_sequences, threads);
+    }
+}
+
 %extend sbol::SearchQuery
 {
     sbol::TextProperty __getitem__(std::string uri)
@@ -1154,33 +1765,35 @@ from __future__ import absolute_import
     
 %pythoncode
 %{
-    def applyToComponentHierarchy(self, callback_fn, user_data):
-        # Assumes parent_component is an SBOL data structure of the general form ComponentDefinition(->Component->ComponentDefinition)n where n+1 is an integer describing how many hierarchical levels are in the SBOL structure
-        # Look at each of the ComponentDef's SequenceAnnotations, is the target base there?
-        if not self.doc:
-            raise Exception('Cannot traverse Component hierarchy without a Document')
-    
-        GET_ALL = True
-        component_nodes = []
-        if len(self.components) == 0:
-            component_nodes.append(self)  # Add leaf components
-            if (callback_fn):
-                callback_fn(self, user_data)
-        else:
-            if GET_ALL:
-                component_nodes.append(self)  # Add components with children
-                if callback_fn:
-                    callback_fn(self, user_data)
-            for subc in self.components:
-                if not self.doc.find(subc.definition.get()):
-                    raise Exception(subc.definition.get() + 'not found')
-                subcdef = self.doc.getComponentDefinition(subc.definition.get())
-                subcomponents = subcdef.applyToComponentHierarchy(callback_fn, user_data)
-                component_nodes.extend(subcomponents)
+    _traverseComponentHierarchy = ComponentDefinition.traverseComponentHierarchy
+
+    def traverseComponentHierarchy(self, callback_fn = None, user_data = None, per_use = False):
+        # The hierarchy is indexed in C++, which resolves definitions in constant time and rejects cycles. Python callbacks run in depth-first pre-order
+        component_nodes = _traverseComponentHierarchy(self, None, None, per_use)
+        if callback_fn:
+            for cdef in component_nodes:
+                callback_fn(cdef, user_data)
         return component_nodes
 
-    
+    def applyToComponentHierarchy(self, callback_fn, user_data):
+        # Assumes parent_component is an SBOL data structure of the general form ComponentDefinition(->Component->ComponentDefinition)n where n+1 is an integer describing how many hierarchical levels are in the SBOL structure
+        # Definitions shared by several Components are visited once per use
+        return self.traverseComponentHierarchy(callback_fn, user_data, True)
+
+    def reduceComponentHierarchy(self, reduce_fn, user_data = None):
+        # Each distinct definition is reduced once, after the definitions of its Components. The traversal checks that the hierarchy is complete and acyclic
+        definitions = { cdef.identity : cdef for cdef in _traverseComponentHierarchy(self, None, None, False) }
+        values = {}
+        def reduce(cdef):
+            if cdef.identity not in values:
+                child_values = [ reduce(definitions[c.definition]) for c in cdef.components ]
+                values[cdef.identity] = reduce_fn(cdef, child_values, user_data)
+            return values[cdef.identity]
+        return reduce(self)
+
+    ComponentDefinition.traverseComponentHierarchy = traverseComponentHierarchy
     ComponentDefinition.applyToComponentHierarchy = applyToComponentHierarchy
+    ComponentDefinition.reduceComponentHierarchy = reduceComponentHierarchy
     
     
     def testSBOL():
@@ -4,6 +4,9 @@ import random
 import string
 import os, sys
 import tempfile, shutil
+import gzip
+import threading
+import tracemalloc
 
 #####################
 # utility functions
@@ -509,7 +512,33 @@ class TestComponentDefinitions(unittest.TestCase):
         if sys.version_info[0] < 3:
             self.assertItemsEqual(listCD, listCD_true)
         else:
-            self.assertCountEqual(listCD, listCD_true)    
+            self.assertCountEqual(listCD, listCD_true)
+
+    def testComponentHierarchy(self):
+        doc = Document()
+        device = doc.componentDefinitions.create('device')
+        gene = doc.componentDefinitions.create('gene')
+        promoter = doc.componentDefinitions.create('promoter')
+        cds = doc.componentDefinitions.create('cds')
+        for parent, subcdefs in [ (gene, [ promoter, cds ]), (device, [ gene, gene ]) ]:
+            for i, subcdef in enumerate(subcdefs):
+                parent.components.create('%s_%d' % (subcdef.displayId, i)).definition = subcdef.identity
+        per_use = [ cd.displayId for cd in device.applyToComponentHierarchy(None, None) ]
+        self.assertEqual(per_use, ['device', 'gene', 'promoter', 'cds', 'gene', 'promoter', 'cds'])
+        self.assertEqual([ cd.displayId for cd in device.traverseComponentHierarchy() ], ['device', 'gene', 'promoter', 'cds'])
+        visits = []
+        count = device.reduceComponentHierarchy(lambda cd, counts, visits: visits.append(cd.displayId) or 1 + sum(counts), visits)
+        self.assertEqual(count, 7)
+        self.assertEqual(sorted(visits), ['cds', 'device', 'gene', 'promoter'])
+
+    def testCyclicComponentHierarchy(self):
+        doc = Document()
+        a = doc.componentDefinitions.create('a')
+        b = doc.componentDefinitions.create('b')
+        a.components.create('b').definition = b.identity
+        b.components.create('a').definition = a.identity
+        self.assertRaises(ValueError, lambda: a.traverseComponentHierarchy())
+        self.assertRaises(ValueError, lambda: a.applyToComponentHierarchy(None, None))
 
 
 class TestSequences(unittest.TestCase):
@@ -607,6 +636,113 @@ class TestMemory(unittest.TestCase):
         bool2 = cd.thisown
         self.assertNotEquals(bool1, bool2)
 
+class TestBulkInsert(unittest.TestCase):
+
+    def setUp(self):
+        pass
+
+    def testBulkInsert(self):
+        doc = Document()
+        bulk_insert = BulkInsert(doc, 100)
+        for i in range(100):
+            doc.componentDefinitions.create('cd%d' % i)
+        bulk_insert.commit()
+        self.assertEqual(doc.componentDefinitions.size(), 100)
+
+    def testBatchConflicts(self):
+        doc = Document()
+        doc.addComponentDefinition(ComponentDefinition('cd0'))
+        batch = [ComponentDefinition('cd0'), ComponentDefinition('cd1'), ComponentDefinition('cd1')]
+        with self.assertRaises(RuntimeError) as context:
+            doc.addBatch(batch)
+        self.assertIn('cd0', str(context.exception))
+        self.assertIn('cd1', str(context.exception))
+        self.assertEqual(doc.componentDefinitions.size(), 1)
+
+    def testBulkInsertConflict(self):
+        doc = Document()
+        doc.componentDefinitions.create('cd0')
+        original = doc.writeString()
+        bulk_insert = BulkInsert(doc)
+        doc.componentDefinitions.create('cd1')
+        doc.addComponentDefinition(ComponentDefinition('cd0'))
+        self.assertRaises(RuntimeError, bulk_insert.commit)
+        self.assertEqual(doc.componentDefinitions.size(), 1)
+        self.assertEqual(doc.writeString(), original)
+
+class TestStats(unittest.TestCase):
+
+    def setUp(self):
+        Stats.reset()
+
+    def tearDown(self):
+        Stats.disable()
+        Stats.reset()
+
+    def testReadCounters(self):
+        Stats.enable()
+        doc = Document()
+        doc.read(os.path.join(MODULE_LOCATION, 'crispr_example.xml'))
+        self.assertGreater(Stats.getCount('triples_parsed'), 0)
+        self.assertGreater(Stats.getCount('objects_created'), 0)
+        self.assertEqual(Stats.getCalls('read'), 1)
+        self.assertIn('parse_properties', Stats.getPhases())
+
+    def testDisabled(self):
+        doc = Document()
+        doc.read(os.path.join(MODULE_LOCATION, 'crispr_example.xml'))
+        self.assertEqual(Stats.getCount('triples_parsed'), 0)
+
+class TestSnapshot(unittest.TestCase):
+
+    def setUp(self):
+        self.temp_out_dir = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_out_dir)
+
+    def testRoundTrip(self):
+        doc = Document()
+        doc.read(os.path.join(MODULE_LOCATION, 'crispr_example.xml'))
+        snapshot_file = os.path.join(self.temp_out_dir, 'crispr_example.snapshot')
+        doc.saveSnapshot(snapshot_file)
+        doc2 = Document()
+        doc2.loadSnapshot(snapshot_file)
+        self.assertEqual(len(doc2), len(doc))
+        self.assertEqual(doc2.writeString(), doc.writeString())
+
+    def testInvalidSnapshot(self):
+        with self.assertRaises(RuntimeError):
+            Document().loadSnapshot(os.path.join(MODULE_LOCATION, 'crispr_example.xml'))
+
+class TestTriples(unittest.TestCase):
+
+    def setUp(self):
+        self.temp_out_dir = tempfile.mkdtemp()
+
+    def tearDown(self):
+        setFileFormat('rdfxml')
+        shutil.rmtree(self.temp_out_dir)
+
+    def testRoundTrip(self):
+        doc = Document()
+        doc.read(os.path.join(MODULE_LOCATION, 'crispr_example.xml'))
+        for file_format in ['ntriples', 'turtle']:
+            setFileFormat(file_format)
+            output_file = os.path.join(self.temp_out_dir, 'crispr_example.' + file_format)
+            doc.write(output_file)
+            doc2 = Document()
+            doc2.read(output_file)
+            self.assertEqual(len(doc2), len(doc))
+            self.assertEqual(sorted(doc2.writeString().splitlines()), sorted(doc.writeString().splitlines()))
+
+    def testEscaping(self):
+        doc = Document()
+        cd = doc.componentDefinitions.create('cd')
+        cd.description = 'Line one\nLine "two"'
+        setFileFormat('ntriples')
+        self.assertIn('"Line one\\nLine \\"two\\""', doc.writeString())
+
 class TestIterators(unittest.TestCase):
 
     def setUp(self):
@@ -621,8 +757,584 @@ class TestIterators(unittest.TestCase):
             annotations.append(sa.this)
         self.assertEquals(annotations, [sa1, sa2])
 
+    def testNestedDocumentIteration(self):
+        doc = Document()
+        for i in range(3):
+            doc.componentDefinitions.create('cd%d' % i)
+        doc.sequences.create('seq')
+        pairs = [(outer.identity, inner.identity) for outer in doc for inner in doc]
+        self.assertEqual(len(pairs), 16)
+        self.assertEqual(len(set(pairs)), 16)
+
+    def testTypedDocumentIteration(self):
+        doc = Document()
+        for i in range(3):
+            doc.componentDefinitions.create('cd%d' % i)
+        doc.sequences.create('seq')
+        cds = list(doc.iter(ComponentDefinition))
+        self.assertEqual(len(cds), 3)
+        for cd in cds:
+            self.assertIsInstance(cd, ComponentDefinition)
+        self.assertEqual([seq.displayId for seq in doc.iter(Sequence)], ['seq'])
+
+    def testModifyDuringDocumentIteration(self):
+        doc = Document()
+        for i in range(10):
+            doc.componentDefinitions.create('cd%d' % i)
+        # Objects added during the loop, enough to rehash the register, are visited once each
+        visited = []
+        for obj in doc:
+            visited.append(obj.identity)
+            if len(visited) == 1:
+                for i in range(1000):
+                    doc.sequences.create('seq%d' % i)
+        self.assertEqual(len(visited), 1010)
+        self.assertEqual(len(set(visited)), 1010)
+        # Objects closed during the loop are skipped
+        n_objects = len([obj for obj in doc])
+        visited = []
+        closed = []
+        for obj in doc:
+            visited.append(obj.identity)
+            if len(visited) == 1:
+                closed = [cd.identity for cd in doc.componentDefinitions if cd.identity != visited[0]]
+                for uri in closed:
+                    doc.componentDefinitions.remove(uri)
+        self.assertFalse(set(closed) & set(visited))
+        self.assertEqual(len(visited), n_objects - len(closed))
+        # Removing the object at the cursor does not skip the one after it
+        visited = []
+        for obj in doc:
+            visited.append(obj.identity)
+            if obj.type == SBOL_SEQUENCE:
+                doc.sequences.remove(obj.identity)
+        self.assertEqual(len(visited), n_objects - len(closed))
+        self.assertEqual(doc.sequences.size(), 0)
+
+class TestLineage(unittest.TestCase):
+
+    def setUp(self):
+        self.doc = Document()
+        self.a = self.doc.componentDefinitions.create('A')
+        self.b = self.doc.componentDefinitions.create('B')
+        self.c = self.doc.componentDefinitions.create('C')
+        self.b.wasDerivedFrom = self.a.identity
+        self.activity = self.doc.activities.create('assembly')
+        usage = self.activity.usages.create('usage')
+        usage.entity = self.b.identity
+        self.c.wasGeneratedBy = self.activity.identity
+
+    def testAncestors(self):
+        self.assertEqual(list(self.doc.ancestors(self.c.identity)), [self.activity.identity, self.b.identity, self.a.identity])
+        self.assertEqual(list(self.doc.ancestors(self.c.identity, 1)), [self.activity.identity])
+        self.assertEqual(list(self.doc.descendants(self.a.identity)), [self.b.identity, self.activity.identity, self.c.identity])
+
+    def testLineagePath(self):
+        path = [self.c.identity, self.activity.identity, self.b.identity, self.a.identity]
+        self.assertEqual(list(self.doc.lineagePath(self.c.identity, self.a.identity)), path)
+        self.assertEqual(list(self.doc.lineagePath(self.a.identity, self.c.identity)), path[::-1])
+
+    def testInvalidation(self):
+        self.assertEqual(len(self.doc.ancestors(self.c.identity)), 3)
+        self.activity.usages.remove(0)
+        self.assertEqual(list(self.doc.ancestors(self.c.identity)), [self.activity.identity])
+        self.assertEqual(list(self.doc.lineagePath(self.c.identity, self.a.identity)), [])
+
+class TestThreads(unittest.TestCase):
+
+    def testConcurrentReads(self):
+        sbol_file = os.path.join(MODULE_LOCATION, 'crispr_example.xml')
+        expected = Document(sbol_file).writeString()
+        results = [None] * 4
+        def read(i_thread):
+            doc = Document()
+            doc.read(sbol_file)
+            results[i_thread] = doc.writeString()
+        threads = [threading.Thread(target=read, args=(i,)) for i in range(len(results))]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        self.assertEqual(results, [expected] * len(results))
+
+class TestColumns(unittest.TestCase):
+
+    def testPropertyColumns(self):
+        doc = Document()
+        for i in range(3):
+            cd = doc.componentDefinitions.create('cd%d' % i)
+            if i:
+                cd.roles = [SO_PROMOTER] * i
+        display_ids, roles = doc.getPropertyColumns(SBOL_COMPONENT_DEFINITION, [SBOL_DISPLAY_ID, SBOL_ROLES])
+        self.assertEqual(display_ids, [['cd0'], ['cd1'], ['cd2']])
+        self.assertEqual([len(r) for r in roles], [0, 1, 2])
+        self.assertEqual(list(doc.getPropertyColumn(SBOL_COMPONENT_DEFINITION, SBOL_DISPLAY_ID)), ['cd0', 'cd1', 'cd2'])
+
+    def testElementsView(self):
+        seq = Sequence('seq', 'atgcatgc')
+        view = seq.getElementsView()
+        self.assertTrue(view.readonly)
+        self.assertEqual(view.tobytes(), b'atgcatgc')
+        piece = view[2:5]
+        self.assertEqual(piece.tobytes(), b'gca')
+        # The elements cannot change while the view or a slice of it is alive
+        with self.assertRaises(RuntimeError):
+            seq.elements = 'cc'
+        view.release()
+        with self.assertRaises(RuntimeError):
+            seq.elements = 'cc'
+        del piece
+        seq.elements = 'cc'
+        with seq.getElementsView() as view:
+            self.assertEqual(view.tobytes(), b'cc')
+        seq.elements = ''
+        self.assertEqual(seq.getElementsView().tobytes(), b'')
+
+    def testElementsViewNotCopied(self):
+        seq = Sequence('seq', 'atgc' * 1000000)
+        tracemalloc.start()
+        try:
+            view = seq.getElementsView()
+            current, peak = tracemalloc.get_traced_memory()
+        finally:
+            tracemalloc.stop()
+        self.assertEqual(len(view), 4000000)
+        self.assertLess(peak, 100000)
+
+class TestQuery(unittest.TestCase):
+
+    def setUp(self):
+        self.doc = Document()
+        self.promoter = self.doc.componentDefinitions.create('promoter')
+        self.promoter.roles = [SO_PROMOTER]
+        self.terminator = self.doc.componentDefinitions.create('terminator')
+        self.terminator.roles = [SO_TERMINATOR]
+        self.rna = self.doc.componentDefinitions.create('rna')
+        self.rna.types = [BIOPAX_RNA]
+        self.rna.roles = [SO_PROMOTER]
+        module = self.doc.moduleDefinitions.create('module')
+        module.roles = [SO_PROMOTER]
+
+    def displayIds(self, condition):
+        return sorted(obj.displayId for obj in self.doc.query(condition))
+
+    def testQuery(self):
+        cds = TermQuery.ofType(SBOL_COMPONENT_DEFINITION)
+        promoters = TermQuery(SBOL_ROLES, SO_PROMOTER)
+        self.assertEqual(self.displayIds(cds & promoters), ['promoter', 'rna'])
+        self.assertEqual(self.displayIds(promoters | TermQuery(SBOL_ROLES, SO_TERMINATOR)), ['module', 'promoter', 'rna', 'terminator'])
+        self.assertEqual(self.displayIds(cds & promoters & TermQuery(SBOL_TYPES, BIOPAX_DNA)), ['promoter'])
+        self.assertEqual(type(self.doc.query(cds & promoters)[0]), ComponentDefinition)
+
+    def testIncrementalUpdates(self):
+        promoters = TermQuery(SBOL_ROLES, SO_PROMOTER)
+        self.assertEqual(len(self.doc.query(promoters)), 3)
+        self.terminator.roles = [SO_PROMOTER]
+        self.doc.componentDefinitions.create('cds').roles = [SO_CDS]
+        self.assertEqual(len(self.doc.query(promoters)), 4)
+        self.assertEqual(self.displayIds(TermQuery(SBOL_ROLES, SO_CDS)), ['cds'])
+        self.doc.componentDefinitions.remove(self.promoter.identity)
+        self.assertEqual(len(self.doc.query(promoters)), 3)
+
+    def testIndexProperty(self):
+        self.assertRaises(ValueError, lambda: self.doc.query(TermQuery(SBOL_SEQUENCE_PROPERTY, 'http://examples.org/Sequence/seq/1')))
+        seq = self.doc.sequences.create('seq')
+        self.promoter.sequences = [seq.identity]
+        self.doc.indexProperty(SBOL_SEQUENCE_PROPERTY)
+        self.assertEqual(self.displayIds(TermQuery(SBOL_SEQUENCE_PROPERTY, seq.identity)), ['promoter'])
+
+class TestTextSearch(unittest.TestCase):
+
+    def setUp(self):
+        self.doc = Document()
+        for display_id, name, description in [ ('pTet', 'TetR repressible promoter', 'Promoter repressed by TetR'),
+                                                ('gfp', 'Green fluorescent protein', 'A reporter'),
+                                                ('tetR', 'TetR repressor', 'Represses the pTet promoter') ]:
+            cd = self.doc.componentDefinitions.create(display_id)
+            cd.name = name
+            cd.description = description
+
+    def displayIds(self, response):
+        return [ record.displayId for record in response ]
+
+    def testGeneralSearch(self):
+        self.assertEqual(self.displayIds(self.doc.search('ptet')), ['pTet', 'tetR'])
+        self.assertEqual(self.displayIds(self.doc.search('TETR REPRESS')), ['tetR', 'pTet'])
+        self.assertEqual(self.displayIds(self.doc.search('fluor')), ['gfp'])
+        self.assertEqual(self.doc.searchCount('promoter'), 2)
+        self.assertEqual(self.doc.searchCount('promoter', SBOL_SEQUENCE), 0)
+        self.assertEqual(len(self.doc.search('t', SBOL_COMPONENT_DEFINITION, 1, 1)), 1)
+
+    def testIncrementalUpdates(self):
+        self.assertEqual(self.doc.searchCount('lac'), 0)
+        self.doc.componentDefinitions.create('lacI').name = 'LacI repressor'
+        self.doc.componentDefinitions.get('gfp').description = 'Reporter under lac control'
+        self.assertEqual(sorted(self.displayIds(self.doc.search('lac'))), ['gfp', 'lacI'])
+
+    def testAdvancedSearch(self):
+        q = SearchQuery()
+        q['name'].set('repressor')
+        self.assertEqual(self.displayIds(self.doc.search(q)), ['tetR'])
+        self.assertEqual(self.doc.searchCount(q), 1)
+
+class TestDeserialization(unittest.TestCase):
+
+    def setUp(self):
+        self.temp_out_dir = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_out_dir)
+
+    def write(self, file_name, sbol_text):
+        path = os.path.join(self.temp_out_dir, file_name)
+        with open(path, 'w') as f:
+            f.write(sbol_text)
+        return path
+
+    def testNoDefaultValues(self):
+        path = self.write('cd0.xml', '<?xml version="1.0" ?>\n'
+                          '<rdf:RDF xmlns:rdf="http://www.w3.org/1999/02/22-rdf-syntax-ns#" xmlns:sbol="http://sbols.org/v2#">'
+                          '<sbol:ComponentDefinition rdf:about="http://examples.com/cd0">'
+                          '<sbol:displayId>cd0</sbol:displayId>'
+                          '<sbol:type rdf:resource="http://www.biopax.org/release/biopax-level3.owl#DnaRegion"/>'
+                          '</sbol:ComponentDefinition></rdf:RDF>')
+        doc = Document()
+        doc.read(path)
+        self.assertEqual(len(doc), 1)
+        self.assertNotIn('sbol:version', doc.writeString())
+        self.assertNotIn('sbol:persistentIdentity', doc.writeString())
+        # Objects constructed outside the parser still receive their defaults
+        self.assertEqual(ComponentDefinition('cd1').version, '1.0.0')
+
+    def testAppendChildObjects(self):
+        paths = []
+        for display_id in ['cd0', 'cd1']:
+            doc = Document()
+            cd = doc.componentDefinitions.create(display_id)
+            cd.sequenceAnnotations.create('sa')
+            paths.append(self.write(display_id + '.xml', doc.writeString()))
+        doc = Document()
+        doc.read(paths[0])
+        doc.append(paths[1])
+        self.assertEqual(len(doc), 2)
+        for cd in doc.componentDefinitions:
+            self.assertEqual(len(cd.sequenceAnnotations), 1)
+
+    def testNestedAnnotations(self):
+        records = ''.join('<qc:hasRecord><qc:QCRecord rdf:about="http://examples.com/cd0/qc%d">'
+                          '<qc:score>%d</qc:score></qc:QCRecord></qc:hasRecord>' % (i, i) for i in range(3))
+        path = self.write('nested.xml', '<?xml version="1.0" ?>\n'
+                          '<rdf:RDF xmlns:rdf="http://www.w3.org/1999/02/22-rdf-syntax-ns#" xmlns:sbol="http://sbols.org/v2#" xmlns:qc="http://examples.com/qc#">'
+                          '<sbol:ComponentDefinition rdf:about="http://examples.com/cd0">'
+                          '<sbol:displayId>cd0</sbol:displayId>' + records +
+                          '</sbol:ComponentDefinition></rdf:RDF>')
+        doc = Document()
+        doc.read(path)
+        self.assertEqual(len(doc), 1)
+        sbol_text = doc.writeString()
+        self.assertEqual(sbol_text.count('<qc:QCRecord'), 3)
+        self.assertNotIn('rdf:resource="http://examples.com/cd0/qc', sbol_text)
+
+    def testAmbiguousAnnotationParent(self):
+        path = self.write('ambiguous.xml', '<?xml version="1.0" ?>\n'
+                          '<rdf:RDF xmlns:rdf="http://www.w3.org/1999/02/22-rdf-syntax-ns#" xmlns:sbol="http://sbols.org/v2#" xmlns:qc="http://examples.com/qc#">'
+                          '<sbol:ComponentDefinition rdf:about="http://examples.com/cd0"><qc:hasRecord rdf:resource="http://examples.com/qc"/></sbol:ComponentDefinition>'
+                          '<sbol:ComponentDefinition rdf:about="http://examples.com/cd1"><qc:hasRecord rdf:resource="http://examples.com/qc"/></sbol:ComponentDefinition>'
+                          '<qc:QCRecord rdf:about="http://examples.com/qc"><qc:score>1</qc:score></qc:QCRecord>'
+                          '</rdf:RDF>')
+        with self.assertRaises(RuntimeError):
+            Document().read(path)
+
+class TestIncrementalWrite(unittest.TestCase):
+
+    def tearDown(self):
+        setFileFormat('rdfxml')
+
+    def build(self, doc):
+        for i in range(5):
+            cd = doc.componentDefinitions.create('cd%d' % i)
+            cd.name = 'part %d' % i
+            cd.sequenceAnnotations.create('sa')
+        doc.moduleDefinitions.create('md')
+
+    def edit(self, doc):
+        doc.componentDefinitions.get('cd1').name = 'renamed'
+        doc.componentDefinitions.get('cd2').sequenceAnnotations.get('sa').name = 'annotation'
+        doc.componentDefinitions.get('cd3').sequenceAnnotations.create('sa2')
+        doc.componentDefinitions.get('cd4').sequenceAnnotations.remove(0)
+        doc.componentDefinitions.remove(0)
+        doc.sequences.create('seq')
+
+    def testEditsMatchFullWrite(self):
+        for file_format in ['rdfxml', 'ntriples', 'turtle']:
+            setFileFormat(file_format)
+            doc = Document()
+            self.build(doc)
+            doc.writeString()
+            self.edit(doc)
+            expected = Document()
+            self.build(expected)
+            self.edit(expected)
+            self.assertEqual(doc.writeString(), expected.writeString())
+
+    def testNewNamespace(self):
+        doc = Document()
+        self.build(doc)
+        sbol_text = doc.writeString()
+        doc.addNamespace('http://examples.com/ext#', 'ext')
+        doc.componentDefinitions.get('cd0').setAnnotation('http://examples.com/ext#note', 'note')
+        sbol_text = doc.writeString()
+        self.assertIn('xmlns:ext="http://examples.com/ext#"', sbol_text)
+        self.assertIn('<ext:note>note</ext:note>', sbol_text)
+
+class TestCompression(unittest.TestCase):
+
+    def setUp(self):
+        self.temp_out_dir = tempfile.mkdtemp()
+        Config.setOption('validate', False)
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_out_dir)
+        Config.setOption('validate', True)
+
+    def build(self):
+        doc = Document()
+        for i in range(10):
+            doc.componentDefinitions.create('cd%d' % i).name = 'part %d' % i
+        return doc
+
+    def testRoundTripGzip(self):
+        doc = self.build()
+        filename = os.path.join(self.temp_out_dir, 'doc.xml.gz')
+        doc.write(filename)
+        with open(filename, 'rb') as f:
+            self.assertEqual(f.read(2), b'\x1f\x8b')
+        with gzip.open(filename, 'rb') as f:
+            self.assertEqual(f.read().decode('utf-8'), doc.writeString())
+        doc2 = Document()
+        doc2.read(filename)
+        self.assertEqual(doc2.writeString(), doc.writeString())
+
+    def testReadByMagicBytes(self):
+        doc = self.build()
+        filename = os.path.join(self.temp_out_dir, 'doc.xml')
+        with gzip.open(filename, 'wb') as f:
+            f.write(doc.writeString().encode('utf-8'))
+        doc2 = Document()
+        doc2.read(filename)
+        self.assertEqual(len(doc2.componentDefinitions), 10)
+
+    def testTruncatedFile(self):
+        filename = os.path.join(self.temp_out_dir, 'doc.xml.gz')
+        self.build().write(filename)
+        with open(filename, 'rb') as f:
+            compressed = f.read()
+        with open(filename, 'wb') as f:
+            f.write(compressed[:len(compressed) // 2])
+        with self.assertRaises(Exception):
+            Document().read(filename)
+
 # List of tests
-default_test_list = [TestRoundTripSBOL2, TestComponentDefinitions, TestSequences, TestMemory, TestIterators]
+class TestMemoryUsage(unittest.TestCase):
+
+    def testBreakdown(self):
+        doc = Document()
+        for i in range(3):
+            cd = doc.componentDefinitions.create('cd%d' % i)
+            cd.sequenceAnnotations.create('sa')
+        doc.componentDefinitions.get('cd2').description = 'x' * 1000
+        usage = doc.memoryUsage(2)
+        self.assertEqual(usage.getObjectCount(), 6)
+        self.assertEqual(usage.getTotal(), sum(usage.getCategorySize(c) for c in usage.getCategories()))
+        self.assertEqual(usage.getClassCount(SBOL_COMPONENT_DEFINITION), 3)
+        self.assertEqual(usage.getClassCount(SBOL_SEQUENCE_ANNOTATION), 3)
+        self.assertGreater(usage.getCategorySize('property_strings'), 1000)
+        self.assertEqual(len(usage.getLargestObjects()), 2)
+        self.assertEqual(usage.getLargestObjects()[0], doc.componentDefinitions.get('cd2').identity)
+        self.assertIn('property_strings', usage.report())
+
+class TestFreeze(unittest.TestCase):
+
+    def setUp(self):
+        self.doc = Document()
+        for i in range(20):
+            cd = self.doc.componentDefinitions.create('cd%d' % i)
+            cd.roles = [SO_PROMOTER if i % 2 else SO_CDS]
+            cd.sequenceAnnotations.create('sa')
+        self.doc.freeze()
+
+    def testModificationsRaise(self):
+        frozen_error = PermissionError if sys.version_info[0] >= 3 else RuntimeError
+        cd = self.doc.componentDefinitions.get('cd0')
+        self.assertTrue(self.doc.isFrozen())
+        with self.assertRaises(frozen_error):
+            cd.name = 'changed'
+        with self.assertRaises(frozen_error):
+            cd.sequenceAnnotations.create('sa2')
+        with self.assertRaises(frozen_error):
+            self.doc.componentDefinitions.create('cd20')
+        with self.assertRaises(frozen_error):
+            self.doc.addComponentDefinition(ComponentDefinition('cd21'))
+        self.assertEqual(len(self.doc.componentDefinitions), 20)
+        Document().componentDefinitions.create('cd0')
+
+    def testConcurrentReaders(self):
+        expected = self.doc.writeString()
+        n_promoters = len(self.doc.query(TermQuery(SBOL_ROLES, SO_PROMOTER)))
+        failures = []
+        def read(i_thread):
+            for i in range(20):
+                uri = self.doc.componentDefinitions[(i + i_thread) % 20].identity
+                if self.doc.find(uri).identity != uri or len(self.doc.componentDefinitions.get(uri).sequenceAnnotations) != 1:
+                    failures.append(uri)
+                if len(self.doc.query(TermQuery(SBOL_ROLES, SO_PROMOTER))) != n_promoters:
+                    failures.append('query')
+                if len([cd for cd in self.doc.componentDefinitions]) != 20:
+                    failures.append('iteration')
+                if self.doc.writeString() != expected:
+                    failures.append('writeString')
+        threads = [threading.Thread(target=read, args=(i,)) for i in range(8)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        self.assertEqual(failures, [])
+
+class TestTransactions(unittest.TestCase):
+
+    def setUp(self):
+        self.doc = Document()
+        for i in range(5):
+            cd = self.doc.componentDefinitions.create('cd%d' % i)
+            cd.roles = [SO_PROMOTER]
+            cd.sequenceAnnotations.create('sa')
+        self.original = self.doc.writeString()
+
+    def testRollback(self):
+        self.doc.beginTransaction()
+        cd = self.doc.componentDefinitions.get('cd0')
+        cd.name = 'changed'
+        cd.roles = [SO_CDS]
+        cd.sequenceAnnotations.create('sa2')
+        self.doc.componentDefinitions.get('cd1').sequenceAnnotations.clear()
+        self.doc.componentDefinitions.create('cd5')
+        self.doc.addComponentDefinition(ComponentDefinition('cd6'))
+        self.doc.close(self.doc.componentDefinitions.get('cd2').identity)
+        self.doc.rollback()
+        self.assertEqual(self.doc.getTransactionDepth(), 0)
+        self.assertEqual(self.doc.writeString(), self.original)
+        self.assertEqual(len(self.doc.componentDefinitions), 5)
+        self.assertEqual(len(self.doc.query(TermQuery(SBOL_ROLES, SO_PROMOTER))), 5)
+
+    def testSavepoints(self):
+        self.doc.beginTransaction()
+        self.doc.componentDefinitions.get('cd0').name = 'outer'
+        self.doc.beginTransaction()
+        self.doc.componentDefinitions.get('cd1').name = 'rolled back'
+        self.doc.rollback()
+        self.doc.beginTransaction()
+        self.doc.componentDefinitions.get('cd2').name = 'committed'
+        self.doc.commit()
+        self.assertEqual(self.doc.getTransactionDepth(), 1)
+        self.assertEqual(self.doc.componentDefinitions.get('cd1').name, self.doc.componentDefinitions.get('cd3').name)
+        self.assertEqual(self.doc.componentDefinitions.get('cd2').name, 'committed')
+        self.doc.commit()
+        self.assertEqual(self.doc.componentDefinitions.get('cd0').name, 'outer')
+        self.assertRaises(ValueError, self.doc.commit)
+        self.assertRaises(ValueError, self.doc.rollback)
+
+    def testReadInsideTransaction(self):
+        self.doc.beginTransaction()
+        self.assertRaises(ValueError, self.doc.readString, self.original)
+        self.doc.rollback()
+
+class TestObservers(unittest.TestCase):
+
+    def setUp(self):
+        self.doc = Document()
+        self.cd = self.doc.componentDefinitions.create('cd')
+        self.calls = []
+        self.doc.addObserver(self.record)
+
+    def record(self, doc, changes):
+        self.calls.append([(change.type, change.subject, change.property, change.value) for change in changes])
+
+    def testChanges(self):
+        self.cd.name = 'promoter'
+        sa = self.cd.sequenceAnnotations.create('sa')
+        self.cd.sequenceAnnotations.remove(sa.identity)
+        self.doc.componentDefinitions.create('cd2')
+        changes = [call[0] for call in self.calls]
+        self.assertEqual(changes[0], (SBOL_CHANGE_PROPERTY_SET, self.cd.identity, SBOL_NAME, 'promoter'))
+        self.assertIn(SBOL_CHANGE_OBJECT_ADDED, [change[0] for change in changes])
+        self.assertIn(SBOL_CHANGE_OBJECT_REMOVED, [change[0] for change in changes])
+        self.assertEqual(changes[-1][0], SBOL_CHANGE_TOPLEVEL_ADDED)
+
+    def testBatch(self):
+        self.doc.beginBatch()
+        self.cd.name = 'a'
+        self.cd.description = 'b'
+        self.assertEqual(len(self.calls), 0)
+        self.doc.endBatch()
+        self.assertEqual(len(self.calls), 1)
+        self.assertEqual(len(self.calls[0]), 2)
+        self.assertRaises(ValueError, self.doc.endBatch)
+
+    def testRollback(self):
+        self.doc.beginTransaction()
+        self.doc.componentDefinitions.create('cd2')
+        self.doc.rollback()
+        self.assertEqual(self.calls[-1][0][0], SBOL_CHANGE_TOPLEVEL_CLOSED)
+
+    def testReload(self):
+        sbol_string = self.doc.writeString()
+        doc = Document()
+        doc.addObserver(self.record)
+        doc.readString(sbol_string)
+        self.assertEqual(self.calls[-1][0][0], SBOL_CHANGE_RELOADED)
+
+    def testRemoveObserver(self):
+        self.doc.removeObserver(self.record)
+        self.cd.name = 'quiet'
+        self.assertEqual(len(self.calls), 0)
+
+    def testObserverReleasedWithDocument(self):
+        doc = Document()
+        callback = lambda doc, changes: None
+        references = sys.getrefcount(callback)
+        doc.addObserver(callback)
+        self.assertEqual(sys.getrefcount(callback), references + 1)
+        del doc
+        self.assertEqual(sys.getrefcount(callback), references)
+
+class TestIdentifiers(unittest.TestCase):
+
+    def testUniqueAcrossThreads(self):
+        results = [None] * 4
+        def mint(i_thread):
+            results[i_thread] = [randomIdentifier() for i in range(500000)]
+        threads = [threading.Thread(target=mint, args=(i,)) for i in range(len(results))]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        ids = [id for thread_ids in results for id in thread_ids]
+        self.assertEqual(len(set(ids)), len(ids))
+        self.assertEqual([len(part) for part in ids[0].split('-')], [8, 4, 4, 4, 12])
+
+    def testAutoconstructURI(self):
+        homespace = getHomespace()
+        setHomespace('http://examples.org')
+        Config.setOption('sbol_compliant_uris', False)
+        try:
+            uris = [autoconstructURI() for i in range(1000)]
+        finally:
+            Config.setOption('sbol_compliant_uris', True)
+            setHomespace(homespace)
+        self.assertEqual(len(set(uris)), len(uris))
+        self.assertTrue(uris[0].startswith('http://examples.org/'))
+
+default_test_list = [TestRoundTripSBOL2, TestComponentDefinitions, TestSequences, TestMemory, TestBulkInsert, TestStats, TestSnapshot, TestTriples, TestIterators, TestLineage, TestThreads, TestColumns, TestQuery, TestTextSearch, TestDeserialization, TestIncrementalWrite, TestCompression, TestMemoryUsage, TestFreeze, TestTransactions, TestObservers, TestIdentifiers]
 
 def runTests(test_list = default_test_list):
     print("Setting up")